@@ -0,0 +1,143 @@
+#!/usr/bin/env node
+/**
+ * Benchmark de host do LZSS (lzss-codec.js, mesmo algoritmo do firmware).
+ * Gera fluxos realistas de heartbeat, telemetria e replay do diário, em
+ * JSON e MessagePack, e mede taxa de compressão e vazão.
+ *
+ *   node bench-lzss.js [frames]   (default 2000 por fluxo)
+ */
+
+const lzss = require("./lzss-codec");
+const msgpack = require("./msgpack-codec");
+
+const FRAMES = parseInt(process.argv[2] || "2000", 10);
+const CAR_ID = "CAR-1759327346444-n2ug1qp3a";
+const COMPRESS_MIN_BYTES = 96; // WS_COMPRESS_MIN_BYTES
+
+// Gerador determinístico para resultados repetíveis
+let seed = 12345;
+const rand = () => {
+  seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+  return seed / 0x7fffffff;
+};
+const between = (lo, hi) => Math.round(lo + rand() * (hi - lo));
+
+const STATES = ["STOPPED", "ACTIVE", "PAUSED", "LIBERATED_TIME"];
+const EVENTS = ["start", "stop", "pause", "resume", "liberate"];
+
+function heartbeatStream(n) {
+  const frames = [];
+  let remaining = 1800;
+  let heap = 41000;
+  let rssi = -62;
+  for (let i = 0; i < n; i++) {
+    remaining = remaining > 0 ? remaining - 5 : 1800;
+    heap += between(-300, 300);
+    rssi = Math.max(-90, Math.min(-40, rssi + between(-2, 2)));
+    const op = STATES[Math.floor(i / 200) % STATES.length];
+    frames.push({
+      type: "heartbeat",
+      carId: CAR_ID,
+      status: op === "ACTIVE" ? "running" : "stopped",
+      relayOn: op === "ACTIVE",
+      rssi,
+      ip: "192.168.0.57",
+      uptimeSec: 3600 + i * 5,
+      heap,
+      operationState: op,
+      remainingSeconds: op === "ACTIVE" ? remaining : 0,
+      extraSeconds: 0,
+      isCountingDown: op === "ACTIVE",
+    });
+  }
+  return frames;
+}
+
+function telemetryStream(n) {
+  const frames = [];
+  const quad = (lo, hi) => {
+    const a = between(lo, hi);
+    const b = between(lo, hi);
+    const min = Math.min(a, b);
+    const max = Math.max(a, b);
+    return [min, max, Math.round((min + max) / 2), between(min, max)];
+  };
+  for (let i = 0; i < n; i++) {
+    frames.push({
+      type: "telemetry",
+      carId: CAR_ID,
+      seq: i + 1,
+      samples: 30,
+      rssi: quad(-75, -55),
+      heap: quad(38000, 43000),
+      maxBlock: quad(15000, 20000),
+      loopUs: quad(800, 9000),
+      rttMs: quad(8, 120),
+    });
+  }
+  return frames;
+}
+
+function journalStream(n) {
+  const frames = [];
+  let seq = 1;
+  for (let i = 0; i < n; i++) {
+    const events = [];
+    for (let k = 0; k < 4; k++, seq++) {
+      events.push([
+        seq,
+        EVENTS[between(0, EVENTS.length - 1)],
+        STATES[between(0, STATES.length - 1)],
+        between(0, 3600),
+        600000 + seq * 1234,
+        1760000000 + seq * 60,
+      ]);
+    }
+    frames.push({ type: "journal", carId: CAR_ID, events });
+  }
+  return frames;
+}
+
+function run(name, objects, encode) {
+  const frames = objects.map(encode);
+  let rawBytes = 0;
+  let sentBytes = 0;
+  let compressed = 0;
+  const packed = [];
+
+  const t0 = process.hrtime.bigint();
+  for (const frame of frames) {
+    const out = frame.length >= COMPRESS_MIN_BYTES ? lzss.compress(frame, CAR_ID) : null;
+    packed.push(out);
+    rawBytes += frame.length;
+    sentBytes += out ? out.length : frame.length;
+    compressed += out ? 1 : 0;
+  }
+  const t1 = process.hrtime.bigint();
+  packed.forEach((out, i) => {
+    if (out && !lzss.decompress(out, CAR_ID).equals(frames[i])) {
+      throw new Error(`${name}: ida e volta divergiu no frame ${i}`);
+    }
+  });
+  const t2 = process.hrtime.bigint();
+
+  const mbps = (bytes, ns) => (bytes / 1e6 / (Number(ns) / 1e9)).toFixed(1);
+  console.log(
+    `${name.padEnd(20)} ${String(frames.length).padStart(6)} frames` +
+      `  média ${(rawBytes / frames.length).toFixed(0).padStart(4)} B → ${(sentBytes / frames.length).toFixed(0).padStart(4)} B` +
+      `  taxa ${((sentBytes / rawBytes) * 100).toFixed(1).padStart(5)}%` +
+      `  comprimidos ${compressed}` +
+      `  comp ${mbps(rawBytes, t1 - t0)} MB/s  desc ${mbps(rawBytes, t2 - t1)} MB/s`
+  );
+}
+
+const json = (o) => Buffer.from(JSON.stringify(o));
+const mp = (o) => msgpack.encode(o);
+
+console.log(`LZSS: janela = dicionário (${lzss.dictionary(CAR_ID).length} B) + frame, min ${COMPRESS_MIN_BYTES} B\n`);
+run("heartbeat json", heartbeatStream(FRAMES), json);
+run("heartbeat msgpack", heartbeatStream(FRAMES), mp);
+run("telemetry json", telemetryStream(FRAMES), json);
+run("telemetry msgpack", telemetryStream(FRAMES), mp);
+run("journal json", journalStream(FRAMES), json);
+run("journal msgpack", journalStream(FRAMES), mp);
@@ -0,0 +1,46 @@
+/**
+ * Responder da descoberta por broadcast (src/WS/gateway_discovery.cpp).
+ * A placa envia {"type":"discover","carId":...,"proto":N} para
+ * 255.255.255.255:8082 e o primeiro gateway a responder
+ * {"type":"discover_reply","port":8081} vira o host; o endereço usado é o
+ * de origem do datagrama, então um socket em 0.0.0.0 atende todas as
+ * interfaces (o sistema responde pela interface da rede da placa).
+ */
+
+const dgram = require("dgram");
+const os = require("os");
+const protocol = require("./protocol-codec");
+
+// Igual a DISCOVERY_PORT em src/Config/config.h
+const DISCOVERY_PORT = 8082;
+
+function startDiscoveryResponder({ wsPort, name = os.hostname(), port = DISCOVERY_PORT } = {}) {
+  const socket = dgram.createSocket({ type: "udp4", reuseAddr: true });
+  const reply = Buffer.from(JSON.stringify(protocol.discoverReply({ port: wsPort, name: name.slice(0, 24) })));
+
+  socket.on("message", (data, rinfo) => {
+    let msg;
+    try {
+      msg = protocol.decode(JSON.parse(data.toString("utf8")));
+    } catch (err) {
+      return; // não é uma busca da placa
+    }
+    if (msg.type !== "discover") return;
+
+    socket.send(reply, rinfo.port, rinfo.address);
+    console.log(`📡 Descoberta de ${msg.carId} (${rinfo.address}) → porta ${wsPort}`);
+  });
+
+  socket.on("error", (err) => {
+    console.error(`❌ Responder de descoberta (UDP ${port}):`, err.message);
+    socket.close();
+  });
+
+  socket.bind(port, "0.0.0.0", () => {
+    console.log(`📡 Descoberta: UDP ${port} (broadcast)`);
+  });
+
+  return socket;
+}
+
+module.exports = { DISCOVERY_PORT, startDiscoveryResponder };
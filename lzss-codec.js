@@ -0,0 +1,147 @@
+/**
+ * Codec LZSS (sem dependências) compatível com src/Compress/lzss.cpp.
+ * Frame: 0xC1, tamanho original (uint16 BE), fluxo LZSS com um byte de
+ * flags a cada 8 itens (1 = literal, 0 = referência [dist-1:12][len-3:4]).
+ * A janela começa com o mesmo dicionário do firmware + carId do carro.
+ * compress() reproduz o compressor do firmware (mesmo hash e cadeia),
+ * usado no benchmark de host (bench-lzss.js).
+ */
+
+const MARKER = 0xc1;
+const HEADER_SIZE = 3;
+const MIN_MATCH = 3;
+const MAX_MATCH = 18;
+const MAX_CHAIN = 32;
+const NIL = 0xffff;
+
+// Igual a DICTIONARY em src/Compress/lzss.cpp
+const DICTIONARY_BASE =
+  '"isCountingDown":false,"extraSeconds":0,"remainingSeconds":"operationState":"STOPPED",' +
+  '"ACTIVE","PAUSED","LIBERATED_TIME","LIBERATED_FREE","relayOn":true,"rssi":-' +
+  '"ip":"192.168.","uptimeSec":"heap":"status":"heartbeat","seq":' +
+  '{"type":"journal","events":[["start","stop","pause","resume","liberate","' +
+  '"samples":,"maxBlock":[,"loopUs":[,"rttMs":[,"rssi":[-,"heap":[],' +
+  '{"type":"telemetry","carId":"';
+
+const dictionaries = new Map();
+
+function dictionary(carId) {
+  if (!dictionaries.has(carId)) {
+    dictionaries.set(carId, Buffer.from(`${DICTIONARY_BASE}${carId}"`, "latin1"));
+  }
+  return dictionaries.get(carId);
+}
+
+function isCompressed(data) {
+  return data.length >= HEADER_SIZE && data[0] === MARKER;
+}
+
+function decompress(data, carId) {
+  if (!isCompressed(data)) {
+    throw new Error("frame LZSS sem marcador");
+  }
+  const dict = dictionary(carId);
+  const length = data.readUInt16BE(1);
+  const window = Buffer.alloc(dict.length + length);
+  dict.copy(window);
+
+  let pos = dict.length;
+  const end = window.length;
+  let i = HEADER_SIZE;
+  while (pos < end) {
+    if (i >= data.length) throw new Error("frame LZSS truncado");
+    const flags = data[i++];
+    for (let bit = 0; bit < 8 && pos < end; bit++) {
+      if (flags & (1 << bit)) {
+        if (i >= data.length) throw new Error("frame LZSS truncado");
+        window[pos++] = data[i++];
+      } else {
+        if (i + 1 >= data.length) throw new Error("frame LZSS truncado");
+        const code = (data[i] << 8) | data[i + 1];
+        i += 2;
+        const distance = (code >> 4) + 1;
+        const len = (code & 0x0f) + MIN_MATCH;
+        if (distance > pos || pos + len > end) throw new Error("referência LZSS inválida");
+        for (let k = 0; k < len; k++, pos++) {
+          window[pos] = window[pos - distance];
+        }
+      }
+    }
+  }
+  return window.subarray(dict.length);
+}
+
+// Retorna o frame comprimido, ou null se não ficar menor que o original
+function compress(input, carId) {
+  const dict = dictionary(carId);
+  const window = Buffer.concat([dict, input]);
+  const end = window.length;
+  const head = new Uint16Array(256).fill(NIL);
+  const prev = new Uint16Array(end);
+  const budget = input.length - 1;
+
+  const hash = (p) => ((window[p] << 2) ^ (window[p + 1] << 1) ^ window[p + 2]) & 0xff;
+  const insert = (p) => {
+    if (p + MIN_MATCH > end) return;
+    const h = hash(p);
+    prev[p] = head[h];
+    head[h] = p;
+  };
+
+  for (let p = 0; p < dict.length; p++) insert(p);
+
+  const out = Buffer.alloc(input.length);
+  if (budget <= HEADER_SIZE) return null;
+  out[0] = MARKER;
+  out.writeUInt16BE(input.length, 1);
+  let o = HEADER_SIZE;
+  let flagAt = 0;
+  let flagBit = 8;
+
+  let pos = dict.length;
+  while (pos < end) {
+    if (flagBit === 8) {
+      if (o >= budget) return null;
+      flagAt = o++;
+      out[flagAt] = 0;
+      flagBit = 0;
+    }
+
+    const limit = Math.min(end - pos, MAX_MATCH);
+    let best = 0;
+    let distance = 0;
+    if (limit >= MIN_MATCH) {
+      let candidate = head[hash(pos)];
+      for (let depth = 0; candidate !== NIL && depth < MAX_CHAIN; depth++) {
+        let len = 0;
+        while (len < limit && window[candidate + len] === window[pos + len]) len++;
+        if (len > best) {
+          best = len;
+          distance = pos - candidate;
+          if (best === limit) break;
+        }
+        candidate = prev[candidate];
+      }
+    }
+
+    let len = best >= MIN_MATCH ? best : 0;
+    if (len) {
+      if (o + 2 > budget) return null;
+      const code = ((distance - 1) << 4) | (len - MIN_MATCH);
+      out[o++] = code >> 8;
+      out[o++] = code & 0xff;
+    } else {
+      if (o + 1 > budget) return null;
+      out[flagAt] |= 1 << flagBit;
+      out[o++] = window[pos];
+      len = 1;
+    }
+    flagBit++;
+
+    for (let k = 0; k < len; k++) insert(pos + k);
+    pos += len;
+  }
+  return out.subarray(0, o);
+}
+
+module.exports = { MARKER, compress, decompress, isCompressed, dictionary };
@@ -0,0 +1,149 @@
+/**
+ * Codec MessagePack mínimo (sem dependências) para os servidores de teste.
+ * Cobre o subconjunto usado pelo firmware: map, array, str, bin,
+ * inteiros até 32 bits, float32/64, bool e nil.
+ */
+
+function encode(value) {
+  const parts = [];
+
+  const pushInt = (marker, bytes, v, signed) => {
+    const buf = Buffer.alloc(1 + bytes);
+    buf[0] = marker;
+    if (bytes === 1) signed ? buf.writeInt8(v, 1) : buf.writeUInt8(v, 1);
+    if (bytes === 2) signed ? buf.writeInt16BE(v, 1) : buf.writeUInt16BE(v, 1);
+    if (bytes === 4) signed ? buf.writeInt32BE(v, 1) : buf.writeUInt32BE(v, 1);
+    parts.push(buf);
+  };
+
+  const write = (v) => {
+    if (v === null || v === undefined) {
+      parts.push(Buffer.from([0xc0]));
+    } else if (typeof v === "boolean") {
+      parts.push(Buffer.from([v ? 0xc3 : 0xc2]));
+    } else if (typeof v === "number") {
+      if (!Number.isInteger(v) || v > 0xffffffff || v < -0x80000000) {
+        const buf = Buffer.alloc(9);
+        buf[0] = 0xcb;
+        buf.writeDoubleBE(v, 1);
+        parts.push(buf);
+      } else if (v >= 0) {
+        if (v <= 0x7f) parts.push(Buffer.from([v]));
+        else if (v <= 0xff) pushInt(0xcc, 1, v, false);
+        else if (v <= 0xffff) pushInt(0xcd, 2, v, false);
+        else pushInt(0xce, 4, v, false);
+      } else {
+        if (v >= -32) parts.push(Buffer.from([v & 0xff]));
+        else if (v >= -128) pushInt(0xd0, 1, v, true);
+        else if (v >= -32768) pushInt(0xd1, 2, v, true);
+        else pushInt(0xd2, 4, v, true);
+      }
+    } else if (typeof v === "string") {
+      const str = Buffer.from(v, "utf8");
+      if (str.length <= 31) parts.push(Buffer.from([0xa0 | str.length]));
+      else if (str.length <= 0xff) parts.push(Buffer.from([0xd9, str.length]));
+      else pushInt(0xda, 2, str.length, false);
+      parts.push(str);
+    } else if (Buffer.isBuffer(v)) {
+      if (v.length <= 0xff) parts.push(Buffer.from([0xc4, v.length]));
+      else pushInt(0xc5, 2, v.length, false);
+      parts.push(v);
+    } else if (Array.isArray(v)) {
+      if (v.length <= 15) parts.push(Buffer.from([0x90 | v.length]));
+      else pushInt(0xdc, 2, v.length, false);
+      v.forEach(write);
+    } else if (typeof v === "object") {
+      const keys = Object.keys(v).filter((k) => v[k] !== undefined);
+      if (keys.length <= 15) parts.push(Buffer.from([0x80 | keys.length]));
+      else pushInt(0xde, 2, keys.length, false);
+      keys.forEach((k) => {
+        write(k);
+        write(v[k]);
+      });
+    } else {
+      throw new Error(`Tipo não suportado: ${typeof v}`);
+    }
+  };
+
+  write(value);
+  return Buffer.concat(parts);
+}
+
+function decode(buffer) {
+  let pos = 0;
+
+  const read = () => {
+    if (pos >= buffer.length) throw new Error("MessagePack truncado");
+    const b = buffer[pos++];
+
+    if (b <= 0x7f) return b;
+    if (b >= 0xe0) return b - 0x100;
+    if ((b & 0xf0) === 0x80) return readMap(b & 0x0f);
+    if ((b & 0xf0) === 0x90) return readArray(b & 0x0f);
+    if ((b & 0xe0) === 0xa0) return readStr(b & 0x1f);
+
+    const take = (n) => {
+      if (pos + n > buffer.length) throw new Error("MessagePack truncado");
+      const start = pos;
+      pos += n;
+      return start;
+    };
+
+    switch (b) {
+      case 0xc0: return null;
+      case 0xc2: return false;
+      case 0xc3: return true;
+      case 0xc4: return readBin(buffer[take(1)]);
+      case 0xc5: return readBin(buffer.readUInt16BE(take(2)));
+      case 0xc6: return readBin(buffer.readUInt32BE(take(4)));
+      case 0xca: return buffer.readFloatBE(take(4));
+      case 0xcb: return buffer.readDoubleBE(take(8));
+      case 0xcc: return buffer.readUInt8(take(1));
+      case 0xcd: return buffer.readUInt16BE(take(2));
+      case 0xce: return buffer.readUInt32BE(take(4));
+      case 0xd0: return buffer.readInt8(take(1));
+      case 0xd1: return buffer.readInt16BE(take(2));
+      case 0xd2: return buffer.readInt32BE(take(4));
+      case 0xd9: return readStr(buffer[take(1)]);
+      case 0xda: return readStr(buffer.readUInt16BE(take(2)));
+      case 0xdb: return readStr(buffer.readUInt32BE(take(4)));
+      case 0xdc: return readArray(buffer.readUInt16BE(take(2)));
+      case 0xdd: return readArray(buffer.readUInt32BE(take(4)));
+      case 0xde: return readMap(buffer.readUInt16BE(take(2)));
+      case 0xdf: return readMap(buffer.readUInt32BE(take(4)));
+      default:
+        throw new Error(`Marcador MessagePack não suportado: 0x${b.toString(16)}`);
+    }
+  };
+
+  const readStr = (n) => {
+    const s = buffer.toString("utf8", pos, pos + n);
+    pos += n;
+    return s;
+  };
+
+  const readBin = (n) => {
+    const b = buffer.subarray(pos, pos + n);
+    pos += n;
+    return b;
+  };
+
+  const readArray = (n) => {
+    const out = [];
+    for (let i = 0; i < n; i++) out.push(read());
+    return out;
+  };
+
+  const readMap = (n) => {
+    const out = {};
+    for (let i = 0; i < n; i++) {
+      const k = read();
+      out[k] = read();
+    }
+    return out;
+  };
+
+  return read();
+}
+
+module.exports = { encode, decode };
@@ -0,0 +1,277 @@
+#!/usr/bin/env node
+// Gerado por tools/gen_protocol.py a partir de protocol/messages.json - não editar.
+/**
+ * Codec das mensagens planas do protocolo, espelho de src/Protocol/messages.*
+ *
+ *   make(type, fields)  -> objeto pronto para JSON/MessagePack (lança se inválido)
+ *   check(msg)          -> lista de problemas ([] = válido; null = tipo fora do esquema)
+ *   decode(msg)         -> msg validada (lança se inválida)
+ *
+ * Mensagens da placa levam "carId"; as do gateway não. Campos fora do
+ * esquema são erro aqui (o firmware os ignora): o gateway nunca deve
+ * enviar algo que a placa não conheça.
+ *
+ *   node protocol-codec.js bench [iterações]
+ */
+
+const SCHEMA_VERSION = 1;
+
+const MESSAGES = {
+  "status": {
+    "direction": "car",
+    "fields": [
+      {"name": "status", "type": "str", "max": 23},
+      {"name": "relayOn", "type": "bool"}
+    ]
+  },
+  "ack": {
+    "direction": "car",
+    "fields": [
+      {"name": "id", "type": "uint"},
+      {"name": "result", "type": "str", "max": 24},
+      {"name": "latencyUs", "type": "uint"},
+      {"name": "duplicate", "type": "bool", "optional": true}
+    ]
+  },
+  "nack": {
+    "direction": "car",
+    "fields": [
+      {"name": "id", "type": "uint"},
+      {"name": "result", "type": "str", "max": 24},
+      {"name": "latencyUs", "type": "uint"},
+      {"name": "duplicate", "type": "bool", "optional": true}
+    ]
+  },
+  "batch_result": {
+    "direction": "car",
+    "fields": [
+      {"name": "ok", "type": "bool"},
+      {"name": "id", "type": "uint", "optional": true},
+      {"name": "duplicate", "type": "bool", "optional": true},
+      {"name": "applied", "type": "uint"},
+      {"name": "failed", "type": "int", "optional": true},
+      {"name": "error", "type": "str", "max": 24, "optional": true},
+      {"name": "operationState", "type": "str", "max": 16},
+      {"name": "relayOn", "type": "bool"},
+      {"name": "hc595", "type": "uint"},
+      {"name": "applyUs", "type": "uint"},
+      {"name": "latencyUs", "type": "uint"}
+    ]
+  },
+  "caps_select": {
+    "direction": "gateway",
+    "fields": [
+      {"name": "proto", "type": "int", "optional": true},
+      {"name": "enc", "type": "str", "max": 8, "optional": true},
+      {"name": "hbDelta", "type": "bool", "optional": true},
+      {"name": "keyframeEvery", "type": "int", "optional": true},
+      {"name": "compress", "type": "str", "max": 8, "optional": true}
+    ]
+  },
+  "encoding": {
+    "direction": "gateway",
+    "fields": [
+      {"name": "value", "type": "str", "max": 8}
+    ]
+  },
+  "heartbeat_mode": {
+    "direction": "gateway",
+    "fields": [
+      {"name": "mode", "type": "str", "max": 8, "optional": true},
+      {"name": "keyframeEvery", "type": "int", "optional": true}
+    ]
+  },
+  "heartbeat_keyframe": {
+    "direction": "gateway",
+    "fields": []
+  },
+  "journal_ack": {
+    "direction": "gateway",
+    "fields": [
+      {"name": "seq", "type": "uint"}
+    ]
+  },
+  "discover": {
+    "direction": "car",
+    "fields": [
+      {"name": "proto", "type": "uint"}
+    ]
+  },
+  "discover_reply": {
+    "direction": "gateway",
+    "fields": [
+      {"name": "port", "type": "uint"},
+      {"name": "name", "type": "str", "max": 24, "optional": true}
+    ]
+  }
+};
+
+const EXAMPLES = {
+  "status": {
+    "status": "running",
+    "relayOn": true
+  },
+  "ack": {
+    "id": 123456789,
+    "result": "ok",
+    "latencyUs": 812,
+    "duplicate": true
+  },
+  "nack": {
+    "id": 123456789,
+    "result": "ok",
+    "latencyUs": 812,
+    "duplicate": true
+  },
+  "batch_result": {
+    "ok": false,
+    "id": 42,
+    "duplicate": true,
+    "applied": 0,
+    "failed": 1,
+    "error": "invalid_argument",
+    "operationState": "ACTIVE",
+    "relayOn": true,
+    "hc595": 255,
+    "applyUs": 140,
+    "latencyUs": 960
+  },
+  "caps_select": {
+    "proto": 1,
+    "enc": "msgpack",
+    "hbDelta": true,
+    "keyframeEvery": 12,
+    "compress": "lzss"
+  },
+  "encoding": {
+    "value": "msgpack"
+  },
+  "heartbeat_mode": {
+    "mode": "delta",
+    "keyframeEvery": 12
+  },
+  "heartbeat_keyframe": {},
+  "journal_ack": {
+    "seq": 17
+  },
+  "discover": {
+    "proto": 1
+  },
+  "discover_reply": {
+    "port": 8081,
+    "name": "gateway-pc"
+  }
+};
+
+function checkValue(field, value) {
+  switch (field.type) {
+    case "str":
+      if (typeof value !== "string") return "deveria ser string";
+      if (Buffer.byteLength(value) > field.max) return `passa de ${field.max} bytes`;
+      return null;
+    case "bool":
+      return typeof value === "boolean" ? null : "deveria ser booleano";
+    case "int":
+      return Number.isInteger(value) && value >= -0x80000000 && value <= 0x7fffffff ? null : "deveria ser inteiro de 32 bits";
+    case "uint":
+      return Number.isInteger(value) && value >= 0 && value <= 0xffffffff ? null : "deveria ser inteiro sem sinal de 32 bits";
+  }
+  return "tipo desconhecido";
+}
+
+function check(msg) {
+  if (!msg || typeof msg !== "object") return ["não é objeto"];
+  const spec = MESSAGES[msg.type];
+  if (!spec) return null;
+
+  const problems = [];
+  const known = new Set(["type"]);
+  if (spec.direction === "car") {
+    known.add("carId");
+    if (typeof msg.carId !== "string") problems.push("carId ausente");
+  }
+  for (const field of spec.fields) {
+    known.add(field.name);
+    if (msg[field.name] === undefined) {
+      if (!field.optional) problems.push(`${field.name} ausente`);
+      continue;
+    }
+    const problem = checkValue(field, msg[field.name]);
+    if (problem) problems.push(`${field.name} ${problem}`);
+  }
+  for (const key of Object.keys(msg)) {
+    if (!known.has(key)) problems.push(`${key} fora do esquema`);
+  }
+  return problems;
+}
+
+function decode(msg) {
+  const problems = check(msg);
+  if (problems === null) throw new Error(`tipo fora do esquema: ${msg && msg.type}`);
+  if (problems.length) throw new Error(`${msg.type}: ${problems.join(", ")}`);
+  return msg;
+}
+
+// Monta a mensagem na ordem do esquema (mesma ordem do firmware)
+function make(type, fields = {}, carId) {
+  const spec = MESSAGES[type];
+  if (!spec) throw new Error(`tipo fora do esquema: ${type}`);
+  const msg = { type };
+  if (spec.direction === "car") msg.carId = carId;
+  for (const field of spec.fields) {
+    if (fields[field.name] !== undefined) msg[field.name] = fields[field.name];
+  }
+  for (const key of Object.keys(fields)) {
+    if (!(key in msg)) msg[key] = fields[key];
+  }
+  return decode(msg);
+}
+
+const status = (fields, carId) => make("status", fields, carId);
+const ack = (fields, carId) => make("ack", fields, carId);
+const nack = (fields, carId) => make("nack", fields, carId);
+const batchResult = (fields, carId) => make("batch_result", fields, carId);
+const capsSelect = (fields) => make("caps_select", fields);
+const encoding = (fields) => make("encoding", fields);
+const heartbeatMode = (fields) => make("heartbeat_mode", fields);
+const heartbeatKeyframe = (fields) => make("heartbeat_keyframe", fields);
+const journalAck = (fields) => make("journal_ack", fields);
+const discover = (fields, carId) => make("discover", fields, carId);
+const discoverReply = (fields) => make("discover_reply", fields);
+
+function benchmark(iterations = 10000) {
+  const msgpack = require("./msgpack-codec");
+  const assert = require("assert");
+  const carId = "CAR-BENCH";
+
+  console.log(`Codecs do protocolo (esquema v${SCHEMA_VERSION}, ${iterations} iterações)`);
+  for (const type of Object.keys(MESSAGES)) {
+    const sample = make(type, EXAMPLES[type], carId);
+    const codecs = [
+      ["json", (m) => Buffer.from(JSON.stringify(m)), (b) => JSON.parse(b.toString())],
+      ["msgpack", (m) => msgpack.encode(m), (b) => msgpack.decode(b)],
+    ];
+    for (const [name, enc, dec] of codecs) {
+      let frame;
+      const t0 = process.hrtime.bigint();
+      for (let i = 0; i < iterations; i++) frame = enc(make(type, EXAMPLES[type], carId));
+      const t1 = process.hrtime.bigint();
+      let back;
+      for (let i = 0; i < iterations; i++) back = decode(dec(frame));
+      const t2 = process.hrtime.bigint();
+      assert.deepStrictEqual(back, sample, `${type}/${name}: ida e volta divergiu`);
+      const ns = (t) => (Number(t) / iterations).toFixed(0).padStart(6);
+      console.log(`${type.padEnd(18)} ${name.padEnd(7)} ${String(frame.length).padStart(3)} B  enc ${ns(t1 - t0)} ns  dec ${ns(t2 - t1)} ns  ok`);
+    }
+  }
+}
+
+module.exports = { SCHEMA_VERSION, MESSAGES, check, decode, make, benchmark, status, ack, nack, batchResult, capsSelect, encoding, heartbeatMode, heartbeatKeyframe, journalAck, discover, discoverReply };
+
+if (require.main === module) {
+  if (process.argv[2] !== "bench") {
+    console.log("uso: node protocol-codec.js bench [iterações]");
+    process.exit(1);
+  }
+  benchmark(parseInt(process.argv[3] || "10000", 10));
+}
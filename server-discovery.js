@@ -8,6 +8,8 @@
 const WebSocket = require("ws");
 const http = require("http");
 const os = require("os");
+const protocol = require("./protocol-codec");
+const { DISCOVERY_PORT, startDiscoveryResponder } = require("./discovery-responder");
 
 // Configurações
 const WS_PORT = 8081;
@@ -102,6 +104,11 @@ function createWebSocketServer(server) {
         if (message.startsWith("{")) {
           const msg = JSON.parse(message);
 
+          const problems = protocol.check(msg);
+          if (problems && problems.length) {
+            console.log(`⚠️  ${msg.type} de ${carId} fora do esquema: ${problems.join(", ")}`);
+          }
+
           if (msg.type === "heartbeat") {
             // Não responder heartbeat para evitar spam
             return;
@@ -181,15 +188,19 @@ async function main() {
     process.exit(1);
   }
 
+  // Um socket UDP atende todas as interfaces: a resposta sai pela rede da placa
+  const discovery = startDiscoveryResponder({ wsPort: WS_PORT });
+
   console.log(`🎉 ${servers.length} servidor(es) iniciado(s) com sucesso!`);
   console.log("\n📋 Para testar:");
   console.log(`   • Configure o ESP8266 com qualquer um dos IPs acima`);
-  console.log(`   • O ESP8266 tentará conectar automaticamente`);
+  console.log(`   • O ESP8266 acha o gateway por broadcast (UDP ${DISCOVERY_PORT})`);
   console.log(`   • Use Ctrl+C para parar os servidores\n`);
 
   // Graceful shutdown
   process.on("SIGINT", () => {
     console.log("\n🛑 Parando servidores...");
+    discovery.close();
 
     servers.forEach(({ httpServer, ip }) => {
       httpServer.close(() => {
@@ -6,9 +6,40 @@
 
 const WebSocket = require("ws");
 const http = require("http");
+const readline = require("readline");
+const msgpack = require("./msgpack-codec");
+const lzss = require("./lzss-codec");
+const protocol = require("./protocol-codec");
+const { startDiscoveryResponder } = require("./discovery-responder");
 
 const PORT = 8081;
 
+// Heartbeat delta (opt-in): HB_DELTA=1 node server-simple.js
+const HB_DELTA = process.env.HB_DELTA === "1";
+const HB_KEYFRAME_EVERY = parseInt(process.env.HB_KEYFRAME_EVERY || "12", 10);
+
+// Codificação binária (opt-in): WS_ENCODING=msgpack node server-simple.js
+const WS_ENCODING = process.env.WS_ENCODING === "msgpack" ? "msgpack" : "json";
+
+// Compressão LZSS de frames grandes (opt-in): WS_COMPRESS=lzss node server-simple.js
+const WS_COMPRESS = process.env.WS_COMPRESS === "lzss";
+
+// Maior versão do protocolo de handshake que este servidor entende
+const PROTO_VERSION = 1;
+
+// Comandos com id/ts/ttl: a placa responde ack/nack e ignora reenvios do mesmo id
+const CMD_TTL_MS = parseInt(process.env.CMD_TTL_MS || "10000", 10);
+let nextCommandId = Date.now() % 1000000000; // único entre reinícios do servidor
+
+// Envia um objeto na codificação combinada com a placa
+function sendToCar(ws, message) {
+  if (ws.encoding === "msgpack") {
+    ws.send(msgpack.encode(message), { binary: true });
+  } else {
+    ws.send(JSON.stringify(message));
+  }
+}
+
 console.log("🚀 Servidor WebSocket para ESP8266");
 
 // Criar servidor HTTP
@@ -60,6 +91,46 @@ wss.on("connection", (ws, req) => {
     })
   );
 
+  // Formato e heartbeat são negociados quando o carro manda o hello
+  ws.encoding = "json";
+
+  // Estado reconstruído a partir de keyframes + deltas
+  const hbState = { seq: null, base: null, fields: {} };
+
+  const negotiate = (hello) => {
+    const caps = hello.caps;
+    if (!caps) {
+      // Firmware sem "caps": pedidos avulsos, como antes da negociação
+      if (WS_ENCODING === "msgpack") {
+        // O pedido vai em texto; a partir daqui os dois lados usam WStype_BIN
+        ws.send(JSON.stringify(protocol.encoding({ value: "msgpack" })));
+        ws.encoding = "msgpack";
+      }
+      if (HB_DELTA) {
+        sendToCar(ws, protocol.heartbeatMode({ mode: "delta", keyframeEvery: HB_KEYFRAME_EVERY }));
+      }
+      return;
+    }
+
+    const encodings = Array.isArray(caps.enc) ? caps.enc : ["json"];
+    const select = protocol.capsSelect({
+      proto: Math.min(hello.proto || 1, PROTO_VERSION),
+      enc: encodings.includes(WS_ENCODING) ? WS_ENCODING : "json",
+      hbDelta: HB_DELTA && caps.hbDelta === true,
+      keyframeEvery: HB_KEYFRAME_EVERY,
+      compress: WS_COMPRESS && Array.isArray(caps.compress) && caps.compress.includes("lzss") ? "lzss" : "none",
+    });
+    // O dicionário LZSS inclui o carId anunciado no hello
+    ws.carId = hello.carId || carId;
+    // Sempre em texto: o carro só troca de formato depois de aplicar
+    ws.send(JSON.stringify(select));
+    ws.encoding = select.enc;
+    console.log(
+      `   🤝 proto ${select.proto}, ${select.enc}, heartbeat ${select.hbDelta ? "delta" : "completo"}, compress ${select.compress}` +
+        ` (caps: ${JSON.stringify(caps)})`
+    );
+  };
+
   // Heartbeat
   const heartbeat = setInterval(() => {
     if (ws.readyState === WebSocket.OPEN) {
@@ -68,20 +139,85 @@ wss.on("connection", (ws, req) => {
   }, 30000);
 
   // Escutar mensagens
-  ws.on("message", (data) => {
+  ws.on("message", (data, isBinary) => {
     try {
-      const message = JSON.parse(data.toString());
-      console.log(`📨 [${carId}] Recebido:`, message.type || "data");
+      // Frame LZSS: descomprime e decodifica o conteúdo (JSON ou MessagePack)
+      let payload = data;
+      let note = isBinary ? ` (msgpack ${data.length} B)` : "";
+      if (isBinary && lzss.isCompressed(data)) {
+        payload = lzss.decompress(data, ws.carId || carId);
+        note = ` (lzss ${data.length} → ${payload.length} B)`;
+      }
+      const isJson = !isBinary || payload[0] === 0x7b; // '{'
+      const message = isJson ? JSON.parse(payload.toString()) : msgpack.decode(payload);
+      console.log(`📨 [${carId}] Recebido${note}:`, message.type || "data");
+
+      // Mensagens planas do esquema (status, ack, batch_result...): fora do esquema = firmware divergente
+      const problems = protocol.check(message);
+      if (problems && problems.length) {
+        console.log(`⚠️  [${carId}] ${message.type} fora do esquema v${protocol.SCHEMA_VERSION}: ${problems.join(", ")}`);
+      }
 
       // Responder baseado no tipo
-      if (message.type === "hello") {
-        ws.send(
-          JSON.stringify({
-            type: "welcome",
-            message: "Conectado ao servidor",
-            timestamp: Date.now(),
-          })
+      if (message.type === "heartbeat") {
+        const { type, ...fields } = message;
+        hbState.fields = fields;
+        hbState.seq = message.keyframe ? message.seq : null;
+        hbState.base = message.keyframe ? message.seq : null;
+      } else if (message.type === "heartbeat_delta") {
+        const expected = hbState.seq === null ? null : hbState.seq + 1;
+        if (message.seq !== expected || message.base !== hbState.base) {
+          console.log(
+            `⚠️  [${carId}] Delta fora de sequência (seq=${message.seq}, esperado=${expected}) - pedindo keyframe`
+          );
+          hbState.seq = null;
+          sendToCar(ws, protocol.heartbeatKeyframe());
+        } else {
+          const { type, seq, base, ...changed } = message;
+          Object.assign(hbState.fields, changed);
+          hbState.seq = seq;
+          console.log(`   Δ ${JSON.stringify(changed)}`);
+        }
+      } else if (message.type === "journal") {
+        // Replay do diário offline: [seq, evento, status, restante, uptimeMs, epoch]
+        const events = message.events || [];
+        events.forEach(([seq, event, status, remaining, uptimeMs, epoch]) => {
+          const when = epoch ? new Date(epoch * 1000).toLocaleTimeString() : `up ${uptimeMs} ms`;
+          console.log(`   📒 #${seq} ${event} → ${status} (restante ${remaining}s, ${when})`);
+        });
+        if (events.length > 0) {
+          sendToCar(ws, protocol.journalAck({ seq: events[events.length - 1][0] }));
+        }
+      } else if (message.type === "telemetry") {
+        // Janela agregada: cada métrica é [min, max, avg, last]
+        const metrics = ["rssi", "heap", "maxBlock", "loopUs", "rttMs"]
+          .filter((name) => Array.isArray(message[name]))
+          .map((name) => `${name} ${message[name].join("/")}`);
+        console.log(`   📈 janela #${message.seq} (${message.samples} amostras) ${metrics.join("  ")}`);
+      } else if (message.type === "ack" || message.type === "nack") {
+        console.log(
+          `   ${message.type === "ack" ? "✅" : "❌"} Comando #${message.id}: ${message.result}` +
+            ` (${message.latencyUs} us${message.duplicate ? ", repetido" : ""})`
+        );
+      } else if (message.type === "batch_result") {
+        console.log(
+          message.ok
+            ? `   ✅ Lote aplicado (${message.applied} ações, ${message.applyUs} us) → ${message.operationState}`
+            : `   ❌ Lote rejeitado na ação #${message.failed}: ${message.error}`
         );
+      } else if (message.type === "hello") {
+        if (message.operationState) {
+          console.log(
+            `   🚦 ${message.status} / ${message.operationState}` +
+              ` (restante ${message.remainingSeconds}s, relay ${message.relayOn ? "ON" : "OFF"})`
+          );
+        }
+        negotiate(message);
+        sendToCar(ws, {
+          type: "welcome",
+          message: "Conectado ao servidor",
+          timestamp: Date.now(),
+        });
       }
     } catch (error) {
       console.log(`📨 [${carId}] Raw:`, data.toString());
@@ -108,12 +244,69 @@ wss.on("connection", (ws, req) => {
   });
 });
 
-// Iniciar servidor em todas as interfaces
+// Comandos digitados no terminal vão para todas as placas conectadas:
+//   start | stop | pause | resume | hc595_byte_255 ...  -> {"action": ...}
+//   session <segundos>                                -> session_data
+//   session_frag <segundos>                           -> session_data grande, em fragmentos de texto
+//   hc595_byte_255 start (várias ações)               -> {"actions": [...]}
+readline.createInterface({ input: process.stdin }).on("line", (line) => {
+  const words = line.trim().split(/\s+/).filter(Boolean);
+  const [cmd, arg] = words;
+  if (!cmd) return;
+
+  if (cmd === "session_frag") {
+    // Payload propositalmente grande (histórico fictício) enviado em pedaços
+    // de 200 B: a placa tokeniza cada fragmento sem remontar a mensagem
+    const history = Array.from({ length: 60 }, (_, i) => ({ at: Date.now() - i * 60000, event: "tick" }));
+    const text = JSON.stringify({
+      type: "session_data",
+      history,
+      data: { remainingTime: { total_seconds: parseInt(arg || "60", 10) } },
+    });
+    wss.clients.forEach((client) => {
+      if (client.readyState !== WebSocket.OPEN) return;
+      for (let i = 0; i < text.length; i += 200) {
+        client.send(text.slice(i, i + 200), { binary: false, fin: i + 200 >= text.length });
+      }
+    });
+    console.log(`📤 session_data fragmentado (${text.length} B) para ${wss.clients.size} placa(s)`);
+    return;
+  }
+
+  let message;
+  if (cmd === "session") {
+    message = {
+      type: "session_data",
+      data: { remainingTime: { total_seconds: parseInt(arg || "60", 10) } },
+    };
+  } else if (words.length > 1) {
+    message = { actions: words };
+  } else {
+    message = { action: cmd };
+  }
+
+  if (message.action || message.actions) {
+    Object.assign(message, {
+      id: nextCommandId++,
+      ts: Math.floor(Date.now() / 1000),
+      ttl: CMD_TTL_MS,
+    });
+  }
+
+  wss.clients.forEach((client) => {
+    if (client.readyState === WebSocket.OPEN) sendToCar(client, message);
+  });
+  console.log(`📤 Enviado para ${wss.clients.size} placa(s):`, JSON.stringify(message));
+});
+
+// Iniciar servidor em todas as interfaces (+ responder da descoberta por broadcast)
+let discovery = null;
 server.listen(PORT, "0.0.0.0", () => {
   console.log(`🌐 Servidor escutando na porta ${PORT}`);
   console.log(`🔌 WebSocket: ws://192.168.1.114:${PORT}/ws`);
   console.log(`💊 Health: http://192.168.1.114:${PORT}/health`);
   console.log(`⏰ Iniciado: ${new Date().toISOString()}`);
+  discovery = startDiscoveryResponder({ wsPort: PORT });
   console.log(`\n📡 Aguardando ESP8266...\n`);
 });
 
@@ -130,6 +323,7 @@ server.on("error", (error) => {
 // Parar graciosamente
 process.on("SIGINT", () => {
   console.log(`\n🛑 Parando servidor...`);
+  if (discovery) discovery.close();
   server.close(() => {
     console.log(`✅ Servidor parado!`);
     process.exit(0);
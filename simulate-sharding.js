@@ -0,0 +1,147 @@
+#!/usr/bin/env node
+/**
+ * Simulação de host do sharding de carros entre gateways (WS_HOST_SHARDING).
+ * Usa o mesmo peso rendezvous do firmware (src/WS/rendezvous.cpp) e mostra,
+ * para a frota informada, a distribuição por gateway e quantos carros mudam
+ * de gateway quando um cai ou quando entra mais um. Compara com o modo
+ * atual (todos em WS_HOST_STR) e com hash módulo N.
+ *
+ *   node simulate-sharding.js [carros] [gateways]   (default 60 carros, 3 gateways)
+ */
+
+// ===== PESO (igual a Rendezvous::weight) =====
+function fnv1a(text, hash) {
+  for (const byte of Buffer.from(text, "utf8")) {
+    hash = Math.imul(hash ^ byte, 16777619) >>> 0;
+  }
+  return hash;
+}
+
+function fmix32(h) {
+  h ^= h >>> 16;
+  h = Math.imul(h, 0x85ebca6b) >>> 0;
+  h ^= h >>> 13;
+  h = Math.imul(h, 0xc2b2ae35) >>> 0;
+  h ^= h >>> 16;
+  return h >>> 0;
+}
+
+function weight(carId, host) {
+  let hash = fnv1a(carId, 2166136261);
+  hash = Math.imul(hash, 16777619) >>> 0; // byte 0 entre carId e host
+  return fmix32(fnv1a(host, hash));
+}
+
+// Hosts em ordem de preferência do carro (empate: ordem da lista)
+function order(carId, hosts) {
+  return hosts
+    .map((host, index) => ({ host, index, w: weight(carId, host) }))
+    .sort((a, b) => b.w - a.w || a.index - b.index)
+    .map((entry) => entry.host);
+}
+
+// ===== ESTRATÉGIAS =====
+const strategies = {
+  "primeiro da lista (atual)": (carId, alive) => alive[0],
+  "hash módulo N": (carId, alive) => alive[fnv1a(carId, 2166136261) % alive.length],
+  rendezvous: (carId, alive) => order(carId, alive)[0],
+};
+
+// ===== FROTA =====
+// Gerador determinístico (mesmo formato de generate-car-id.js)
+let seed = 20240917;
+const rand = () => {
+  seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+  return seed / 0x7fffffff;
+};
+
+function fleet(count) {
+  const cars = [];
+  let ts = 1759327346444;
+  for (let i = 0; i < count; i++) {
+    ts += Math.floor(rand() * 86400000);
+    const suffix = Math.floor(rand() * 36 ** 9).toString(36).padStart(9, "0");
+    cars.push(`CAR-${ts}-${suffix}`);
+  }
+  return cars;
+}
+
+function gateways(count) {
+  return Array.from({ length: count }, (_, i) => `192.168.1.${114 + i}`);
+}
+
+function assign(strategy, cars, alive) {
+  const map = new Map();
+  for (const car of cars) map.set(car, strategy(car, alive));
+  return map;
+}
+
+function distribution(map, hosts) {
+  const counts = new Map(hosts.map((h) => [h, 0]));
+  for (const host of map.values()) counts.set(host, counts.get(host) + 1);
+  return hosts.map((h) => counts.get(h));
+}
+
+function moved(before, after) {
+  let n = 0;
+  for (const [car, host] of before) if (after.get(car) !== host) n++;
+  return n;
+}
+
+const pct = (n, total) => `${((100 * n) / total).toFixed(1)}%`;
+
+// ===== RELATÓRIO =====
+function main() {
+  const CARS = parseInt(process.argv[2] || "60", 10);
+  const GATEWAYS = parseInt(process.argv[3] || "3", 10);
+  const cars = fleet(CARS);
+  const hosts = gateways(GATEWAYS);
+  const ideal = CARS / GATEWAYS;
+
+  console.log(`Frota: ${CARS} carros, ${GATEWAYS} gateways (${hosts.join(", ")})`);
+  console.log(`Ideal: ${ideal.toFixed(1)} carros por gateway\n`);
+
+  for (const [name, strategy] of Object.entries(strategies)) {
+    const base = assign(strategy, cars, hosts);
+    const counts = distribution(base, hosts);
+    const max = Math.max(...counts);
+
+    console.log(`== ${name} ==`);
+    console.log(`  distribuição: [${counts.join(", ")}]  maior/ideal=${(max / ideal).toFixed(2)}`);
+
+    // Queda de cada gateway: quantos mudam e quantos precisariam mudar (os que estavam nele)
+    for (const down of hosts) {
+      const alive = hosts.filter((h) => h !== down);
+      const after = assign(strategy, cars, alive);
+      const orphans = counts[hosts.indexOf(down)];
+      const n = moved(base, after);
+      const extra = n - orphans;
+      console.log(
+        `  cai ${down}: mudam ${n} (${pct(n, CARS)}), órfãos ${orphans}` +
+          (extra > 0 ? `, ${extra} mudaram sem necessidade` : "") +
+          ` -> [${distribution(after, alive).join(", ")}]`
+      );
+    }
+
+    // Entrada de mais um gateway: espera-se que ~1/(N+1) da frota mude
+    const grown = gateways(GATEWAYS + 1);
+    const n = moved(base, assign(strategy, cars, grown));
+    console.log(`  entra ${grown[GATEWAYS]}: mudam ${n} (${pct(n, CARS)}; esperado ~${pct(CARS / (GATEWAYS + 1), CARS)})\n`);
+  }
+
+  // Equilíbrio do rendezvous conforme o número de gateways
+  console.log("== rendezvous por número de gateways ==");
+  for (let g = 2; g <= 6; g++) {
+    const list = gateways(g);
+    const counts = distribution(assign(strategies.rendezvous, cars, list), list);
+    const mean = CARS / g;
+    const stddev = Math.sqrt(counts.reduce((s, c) => s + (c - mean) ** 2, 0) / g);
+    console.log(`  ${g} gateways: [${counts.join(", ")}]  desvio=${stddev.toFixed(1)} (${pct(stddev, mean)} da média)`);
+  }
+}
+
+module.exports = { weight, order };
+
+if (require.main === module) {
+  main();
+}
@@ -1,5 +1,8 @@
 #include "serial_commands.h"
 #include "../WebSocket/websocket_manager.h"
+#include "../Operation/operation_manager.h"
+#include "../Protocol/messages.h"
+#include "../WS/host_scoreboard.h"
 
 namespace SerialCommands
 {
@@ -9,6 +12,9 @@ namespace SerialCommands
         Serial.println(F("Comandos disponíveis:"));
         Serial.println(F("  i = Snapshot detalhado"));
         Serial.println(F("  j = Snapshot JSON"));
+        Serial.println(F("  b = Benchmark do despacho de ações"));
+        Serial.println(F("  p = Benchmark dos codecs do protocolo"));
+        Serial.println(F("  g = Placar dos hosts do gateway"));
         Serial.println(F("  h = Esta ajuda"));
     }
 
@@ -24,6 +30,18 @@ namespace SerialCommands
             WebSocketManager::printConnectionSnapshot();
             break;
 
+        case 'b':
+            Operation::benchmarkActionDispatch(1000);
+            break;
+
+        case 'p':
+            Protocol::benchmarkRoundTrip(200);
+            break;
+
+        case 'g':
+            HostScoreboard::print();
+            break;
+
         case 'h':
             showHelp();
             break;
@@ -0,0 +1,175 @@
+#include "lzss.h"
+#include "../Config/config.h"
+
+namespace
+{
+    // Dicionário inicial da janela; qualquer mudança aqui precisa ser
+    // espelhada em lzss-codec.js (o gateway reconstrói a mesma janela)
+    const char DICTIONARY[] PROGMEM =
+        "\"isCountingDown\":false,\"extraSeconds\":0,\"remainingSeconds\":\"operationState\":\"STOPPED\","
+        "\"ACTIVE\",\"PAUSED\",\"LIBERATED_TIME\",\"LIBERATED_FREE\",\"relayOn\":true,\"rssi\":-"
+        "\"ip\":\"192.168.\",\"uptimeSec\":\"heap\":\"status\":\"heartbeat\",\"seq\":"
+        "{\"type\":\"journal\",\"events\":[[\"start\",\"stop\",\"pause\",\"resume\",\"liberate\",\""
+        "\"samples\":,\"maxBlock\":[,\"loopUs\":[,\"rttMs\":[,\"rssi\":[-,\"heap\":[],"
+        "{\"type\":\"telemetry\",\"carId\":\"" CAR_ID_STR "\"";
+
+    const size_t DICTIONARY_SIZE = sizeof(DICTIONARY) - 1;
+    const size_t WINDOW_SIZE = DICTIONARY_SIZE + WS_TX_BUFFER_SIZE;
+
+    const size_t MIN_MATCH = 3;
+    const size_t MAX_MATCH = 18;     // 4 bits de comprimento
+    const size_t MAX_DISTANCE = 4096; // 12 bits de distância
+    const uint8_t MAX_CHAIN = 32;    // candidatos examinados por posição
+    const uint16_t NIL = 0xFFFF;
+
+    static_assert(WINDOW_SIZE <= MAX_DISTANCE, "Janela LZSS maior que a distância codificável");
+    static_assert(WINDOW_SIZE < NIL, "Janela LZSS não cabe em índices de 16 bits");
+
+    uint8_t g_window[WINDOW_SIZE];
+    uint16_t g_head[256];        // última posição com cada hash
+    uint16_t g_prev[WINDOW_SIZE]; // posição anterior com o mesmo hash
+    Lzss::Stats g_stats;
+
+    uint8_t hash(size_t pos)
+    {
+        return (uint8_t)((g_window[pos] << 2) ^ (g_window[pos + 1] << 1) ^ g_window[pos + 2]);
+    }
+
+    void insert(size_t pos, size_t end)
+    {
+        if (pos + MIN_MATCH > end)
+            return;
+        uint8_t h = hash(pos);
+        g_prev[pos] = g_head[h];
+        g_head[h] = (uint16_t)pos;
+    }
+
+    // Maior referência para 'pos' entre os candidatos da cadeia de hash
+    size_t longestMatch(size_t pos, size_t end, size_t &distance)
+    {
+        size_t limit = end - pos < MAX_MATCH ? end - pos : MAX_MATCH;
+        if (limit < MIN_MATCH)
+            return 0;
+
+        size_t best = 0;
+        uint16_t candidate = g_head[hash(pos)];
+        for (uint8_t depth = 0; candidate != NIL && depth < MAX_CHAIN; depth++)
+        {
+            size_t len = 0;
+            while (len < limit && g_window[candidate + len] == g_window[pos + len])
+            {
+                len++;
+            }
+            if (len > best)
+            {
+                best = len;
+                distance = pos - candidate;
+                if (best == limit)
+                    break;
+            }
+            candidate = g_prev[candidate];
+        }
+        return best >= MIN_MATCH ? best : 0;
+    }
+}
+
+namespace Lzss
+{
+    size_t compress(const uint8_t *input, size_t length, uint8_t *output, size_t capacity)
+    {
+        if (length > WS_TX_BUFFER_SIZE || length <= HEADER_SIZE)
+        {
+            return 0;
+        }
+
+        // Só vale a pena se ficar menor que o original
+        size_t budget = capacity < length ? capacity : length - 1;
+        if (budget <= HEADER_SIZE)
+        {
+            return 0;
+        }
+
+        const uint32_t startedAt = micros();
+
+        memcpy_P(g_window, DICTIONARY, DICTIONARY_SIZE);
+        memcpy(g_window + DICTIONARY_SIZE, input, length);
+        const size_t end = DICTIONARY_SIZE + length;
+
+        memset(g_head, 0xFF, sizeof(g_head));
+        for (size_t pos = 0; pos < DICTIONARY_SIZE; pos++)
+        {
+            insert(pos, end);
+        }
+
+        output[0] = MARKER;
+        output[1] = (uint8_t)(length >> 8);
+        output[2] = (uint8_t)length;
+        size_t out = HEADER_SIZE;
+
+        size_t flagAt = 0;
+        uint8_t flagBit = 8; // força um novo byte de flags no primeiro item
+
+        size_t pos = DICTIONARY_SIZE;
+        while (pos < end)
+        {
+            if (flagBit == 8)
+            {
+                if (out >= budget)
+                    break;
+                flagAt = out++;
+                output[flagAt] = 0;
+                flagBit = 0;
+            }
+
+            size_t distance = 0;
+            size_t len = longestMatch(pos, end, distance);
+
+            if (len)
+            {
+                if (out + 2 > budget)
+                    break;
+                uint16_t code = (uint16_t)(((distance - 1) << 4) | (len - MIN_MATCH));
+                output[out++] = (uint8_t)(code >> 8);
+                output[out++] = (uint8_t)code;
+            }
+            else
+            {
+                if (out + 1 > budget)
+                    break;
+                output[flagAt] |= (uint8_t)(1 << flagBit);
+                output[out++] = g_window[pos];
+                len = 1;
+            }
+            flagBit++;
+
+            for (size_t i = 0; i < len; i++)
+            {
+                insert(pos + i, end);
+            }
+            pos += len;
+        }
+
+        g_stats.lastMicros = micros() - startedAt;
+
+        if (pos < end)
+        {
+            // Compressão no lugar: devolve o original a partir da cópia na janela
+            if (output == input)
+            {
+                memcpy(output, g_window + DICTIONARY_SIZE, length);
+            }
+            g_stats.skipped++;
+            return 0;
+        }
+
+        g_stats.frames++;
+        g_stats.bytesIn += length;
+        g_stats.bytesOut += out;
+        return out;
+    }
+
+    const Stats &stats()
+    {
+        return g_stats;
+    }
+}
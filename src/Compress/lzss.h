@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Compressão LZSS para frames de saída grandes e repetitivos
+ *
+ * Formato (sempre enviado como frame binário):
+ *   0xC1                 marcador (byte nunca usado em MessagePack e
+ *                        inválido como início de JSON)
+ *   uint16 big-endian    tamanho original
+ *   fluxo LZSS           um byte de flags a cada 8 itens (bit 0 primeiro):
+ *                        1 = literal (1 byte)
+ *                        0 = referência (2 bytes): distância-1 em 12 bits
+ *                            e comprimento-3 em 4 bits -> [dddddddd][ddddllll]
+ * A janela começa com um dicionário fixo (chaves e valores comuns de
+ * heartbeat, telemetria e diário + CAR_ID_STR), então até o primeiro frame
+ * da sessão já encontra referências. Cada frame é independente: perda ou
+ * coalescência na fila não afeta o seguinte.
+ * Memória fixa: janela (dicionário + WS_TX_BUFFER_SIZE) e cadeias de hash.
+ * A entrada é copiada para a janela antes de codificar, então a saída pode
+ * ser o próprio buffer de entrada (sem um segundo buffer de frame).
+ * O decodificador de referência está em lzss-codec.js.
+ */
+
+namespace Lzss
+{
+    const uint8_t MARKER = 0xC1;
+    const size_t HEADER_SIZE = 3;
+
+    struct Stats
+    {
+        uint32_t frames = 0;   // frames que ficaram menores comprimidos
+        uint32_t skipped = 0;  // tentativas que não ficaram menores
+        uint32_t bytesIn = 0;  // tamanho original dos frames comprimidos
+        uint32_t bytesOut = 0; // tamanho comprimido (com cabeçalho)
+        uint32_t lastMicros = 0;
+    };
+
+    // Comprime 'length' bytes (até WS_TX_BUFFER_SIZE) em 'output', que pode
+    // ser o próprio 'input'. Retorna o tamanho com cabeçalho, ou 0 se não
+    // ficou menor que o original ou não coube em 'capacity' (o chamador envia
+    // sem comprimir; no lugar, o original é restaurado em 'input').
+    size_t compress(const uint8_t *input, size_t length, uint8_t *output, size_t capacity);
+
+    const Stats &stats();
+}
@@ -32,6 +32,30 @@ static const uint16_t WS_PORT = 8081;
 #define HEARTBEAT_MS 5000 // 5 segundos - mantém servidor sempre informado do status
 #endif
 
+#ifndef HB_KEYFRAME_EVERY
+#define HB_KEYFRAME_EVERY 12 // modo delta: heartbeat completo a cada N batidas
+#endif
+
+#ifndef HB_RSSI_DEADBAND_DBM
+#define HB_RSSI_DEADBAND_DBM 3 // modo delta: variação mínima de RSSI para reenviar
+#endif
+
+#ifndef HB_HEAP_DEADBAND_BYTES
+#define HB_HEAP_DEADBAND_BYTES 1024 // modo delta: variação mínima de heap para reenviar
+#endif
+
+#ifndef TELEMETRY_SAMPLE_MS
+#define TELEMETRY_SAMPLE_MS 1000 // telemetria: intervalo entre amostras (1 Hz)
+#endif
+
+#ifndef TELEMETRY_WINDOW_SAMPLES
+#define TELEMETRY_WINDOW_SAMPLES 30 // telemetria: amostras por janela (um frame por janela); 0 = desligada
+#endif
+
+#ifndef TELEMETRY_RTT_PING_MS
+#define TELEMETRY_RTT_PING_MS 5000 // telemetria: intervalo entre pings de medição de RTT
+#endif
+
 #ifndef WS_BASE_RETRY_MS
 #define WS_BASE_RETRY_MS 3000
 #endif
@@ -44,8 +68,158 @@ static const uint16_t WS_PORT = 8081;
 #define WS_HANDSHAKE_TIMEOUT_MS 8000
 #endif
 
-#ifndef WS_HELLO_DELAY_MS
-#define WS_HELLO_DELAY_MS 5000
+#ifndef WS_PROBE_TIMEOUT_MS
+#define WS_PROBE_TIMEOUT_MS 2000 // busca de host: limite por sonda (DNS e conexão TCP)
+#endif
+
+#ifndef WS_PROBE_PARALLEL
+#define WS_PROBE_PARALLEL 4 // busca de host: sondas simultâneas (limitado pelos PCBs TCP do lwIP)
+#endif
+
+#ifndef WS_PROBE_MAX_HOSTS
+#define WS_PROBE_MAX_HOSTS 8 // busca de host: maior lista de candidatos sondada
+#endif
+
+#ifndef HOST_FAIL_PENALTY_MS
+#define HOST_FAIL_PENALTY_MS 2000 // placar de hosts: penalidade por falha recente na pontuação
+#endif
+
+#ifndef HOST_SCORE_RTC_OFFSET
+#define HOST_SCORE_RTC_OFFSET 0 // placar de hosts: posição na memória RTC do usuário (palavras de 4 bytes)
+#endif
+
+#ifndef HEALTH_TIMEOUT_MS
+#define HEALTH_TIMEOUT_MS 3000 // health check HTTP: limite total (DNS, conexão e resposta)
+#endif
+
+#ifndef HEALTH_RESPONSE_MAX
+#define HEALTH_RESPONSE_MAX 256 // health check HTTP: bytes da resposta guardados (status + início do corpo)
+#endif
+
+#ifndef WS_TX_BUFFER_SIZE
+#define WS_TX_BUFFER_SIZE 448 // buffer estático reutilizado para serializar frames de saída
+#endif
+
+#ifndef WS_OUTQ_SLOTS
+#define WS_OUTQ_SLOTS 3 // fila de saída: slots de frame cheio (hello, heartbeat, telemetria, diário)
+#endif
+
+#ifndef WS_OUTQ_SLOT_SIZE
+#define WS_OUTQ_SLOT_SIZE WS_TX_BUFFER_SIZE // fila de saída: maior frame aceito
+#endif
+
+#ifndef WS_OUTQ_SMALL_SLOTS
+#define WS_OUTQ_SMALL_SLOTS 3 // fila de saída: slots só para frames curtos (acks, status)
+#endif
+
+#ifndef WS_OUTQ_SMALL_SIZE
+#define WS_OUTQ_SMALL_SIZE 192 // fila de saída: maior frame de um slot curto
+#endif
+
+#ifndef WS_OUTQ_PACING_MS
+#define WS_OUTQ_PACING_MS 100 // fila de saída: intervalo mínimo entre frames drenados
+#endif
+
+#ifndef STATUS_CACHE_SLOTS
+#define STATUS_CACHE_SLOTS 4 // frames status pré-serializados (status x relay x codificação)
+#endif
+
+#ifndef STATUS_CACHE_FRAME_SIZE
+#define STATUS_CACHE_FRAME_SIZE 128 // maior frame status guardado no cache
+#endif
+
+#ifndef WS_STREAM_WINDOW
+#define WS_STREAM_WINDOW 128 // mensagens fragmentadas: janela fixa (maior token aceito)
+#endif
+
+#ifndef WS_STREAM_MAX_BYTES
+#define WS_STREAM_MAX_BYTES 16384 // mensagens fragmentadas: tamanho total máximo
+#endif
+
+#ifndef WS_INQ_SLOTS
+#define WS_INQ_SLOTS 4 // fila de comandos recebidos: frames aguardando execução
+#endif
+
+#ifndef WS_INQ_SLOT_SIZE
+#define WS_INQ_SLOT_SIZE 256 // fila de comandos recebidos: maior frame de comando
+#endif
+
+#ifndef WS_CMD_BUDGET_US
+#define WS_CMD_BUDGET_US 5000 // tempo máximo executando comandos por iteração do loop
+#endif
+
+// Limite de taxa de entrada (token bucket): fichas por segundo / rajada máxima
+#ifndef RL_OPERATION_PER_S
+#define RL_OPERATION_PER_S 5 // start/stop/pause/..., session_data
+#endif
+
+#ifndef RL_OPERATION_BURST
+#define RL_OPERATION_BURST 10
+#endif
+
+#ifndef RL_HC595_PER_S
+#define RL_HC595_PER_S 20 // ações hc595_*
+#endif
+
+#ifndef RL_HC595_BURST
+#define RL_HC595_BURST 40
+#endif
+
+#ifndef RL_MESSAGE_PER_S
+#define RL_MESSAGE_PER_S 10 // demais mensagens do gateway
+#endif
+
+#ifndef RL_MESSAGE_BURST
+#define RL_MESSAGE_BURST 20
+#endif
+
+#ifndef WS_TX_RESERVE_BYTES
+#define WS_TX_RESERVE_BYTES 512 // buffer TCP livre reservado a comandos/status (heartbeat espera)
+#endif
+
+// ===== HANDSHAKE / CAPACIDADES =====
+// O hello JSON anuncia as capacidades e o gateway responde com caps_select.
+// Para gateways antigos que só entendem "HELLO <carId>", defina WS_HELLO_SIMPLE
+// em build_flags (desliga o anúncio de capacidades).
+#ifndef WS_PROTO_VERSION
+#define WS_PROTO_VERSION 1 // versão do protocolo anunciada no hello
+#endif
+
+#ifndef WS_MAX_FRAME
+#define WS_MAX_FRAME 1024 // maior frame de entrada aceito (anunciado em caps.maxFrame)
+#endif
+
+#ifndef WS_COMPRESS_MIN_BYTES
+#define WS_COMPRESS_MIN_BYTES 96 // com "compress":"lzss" aceito, frames a partir deste tamanho saem comprimidos
+#endif
+
+#ifndef OP_MAX_BATCH_ACTIONS
+#define OP_MAX_BATCH_ACTIONS 8 // ações aceitas em um frame {"actions":[...]}
+#endif
+
+#ifndef CMD_DEDUPE_WINDOW
+#define CMD_DEDUPE_WINDOW 16 // ids de comando lembrados para não reaplicar reenvios
+#endif
+
+// ===== DIÁRIO OFFLINE (LittleFS) =====
+#ifndef JOURNAL_RAM_RECORDS
+#define JOURNAL_RAM_RECORDS 8 // registros aguardando descarga no flash
+#endif
+
+#ifndef JOURNAL_SEGMENT_RECORDS
+#define JOURNAL_SEGMENT_RECORDS 128 // registros por segmento (16 bytes cada); 2 segmentos no máximo
+#endif
+
+#ifndef JOURNAL_FLUSH_MS
+#define JOURNAL_FLUSH_MS 500 // idade máxima de um registro em RAM antes da descarga
+#endif
+
+#ifndef JOURNAL_REPLAY_BATCH
+#define JOURNAL_REPLAY_BATCH 4 // eventos por frame de replay
+#endif
+
+#ifndef JOURNAL_ACK_TIMEOUT_MS
+#define JOURNAL_ACK_TIMEOUT_MS 5000 // reenvia o lote se o journal_ack não chegar
 #endif
 
 // ===== CONFIGURAÇÕES DE LOG =====
@@ -74,6 +248,34 @@ static const uint16_t WS_PORT = 8081;
 #define WS_DISABLE_HEARTBEAT 0 // 0 = heartbeat habilitado, 1 = desabilitado
 #endif
 
+#ifndef DISCOVERY_ENABLED
+#if defined(WS_DISABLE_FALLBACK) || (WS_CONNECT_ONCE == 1)
+#define DISCOVERY_ENABLED 0 // host fixo: só WS_HOST_STR
+#else
+#define DISCOVERY_ENABLED 1 // busca do gateway por broadcast UDP antes da lista de hosts
+#endif
+#endif
+
+#ifndef DISCOVERY_PORT
+#define DISCOVERY_PORT 8082 // porta UDP do responder nos servidores
+#endif
+
+#ifndef DISCOVERY_RETRY_MS
+#define DISCOVERY_RETRY_MS 250 // intervalo entre repetições do broadcast
+#endif
+
+#ifndef DISCOVERY_TIMEOUT_MS
+#define DISCOVERY_TIMEOUT_MS 1000 // sem resposta nesse prazo: sonda a lista de hosts
+#endif
+
+#ifndef WS_HOST_SHARDING
+#define WS_HOST_SHARDING 0 // 1 = divide a frota entre os gateways (rendezvous hashing do CAR_ID_STR)
+#endif
+
+#ifndef DISCOVERY_SHARD_WINDOW_MS
+#define DISCOVERY_SHARD_WINDOW_MS 200 // sharding: espera pelos demais gateways após a primeira resposta
+#endif
+
 // ===== CORES PARA LOG =====
 #if LOG_COLOR
 #define C_GREEN "\x1b[32m"
@@ -90,14 +292,17 @@ static const uint16_t WS_PORT = 8081;
 #endif
 
 // ===== HOSTS ALTERNATIVOS =====
+// Sondados quando nenhum gateway responde à descoberta por broadcast
 #if defined(WS_DISABLE_FALLBACK) || (WS_CONNECT_ONCE == 1)
-static const char *ALT_WS_HOSTS[] = {WS_HOST_STR};
+static constexpr const char *ALT_WS_HOSTS[] = {WS_HOST_STR};
+#elif defined(WS_HOSTS_LIST)
+// Lista própria de gateways (ex.: sharding): -DWS_HOSTS_LIST='"10.0.0.2","10.0.0.3"'
+// Com WS_HOST_SHARDING só IPs: o peso rendezvous é o do texto (rendezvous.h)
+static constexpr const char *ALT_WS_HOSTS[] = {WS_HOSTS_LIST};
 #else
-static const char *ALT_WS_HOSTS[] = {
+static constexpr const char *ALT_WS_HOSTS[] = {
     WS_HOST_STR,     // IP Ethernet principal: 10.8.113.82
     "192.168.1.114", // IP WiFi do PC
-    "localhost",     // Para teste local
-    "127.0.0.1",     // Loopback local
     "192.168.1.100", // IPs comuns da rede WiFi
     "192.168.0.100", // IPs comuns de outras redes
     "10.0.0.100"     // IPs comuns de rede corporativa
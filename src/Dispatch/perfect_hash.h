@@ -0,0 +1,241 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "../Json/json_tokenizer.h"
+
+/**
+ * Tabela de despacho com hash perfeito gerado em compilação
+ *
+ * Os nomes (ações, tipos de mensagem) são declarados junto com o handler em
+ * um array constexpr; o compilador procura uma semente FNV-1a que leve cada
+ * nome a um slot distinto e monta a tabela de slots. Em runtime uma busca é
+ * um hash do nome + uma comparação, independente de quantos comandos existam.
+ *
+ * Segmentos numéricos do nome (entre '_' ou nas pontas) viram '#' na
+ * normalização e são entregues ao handler já convertidos; dígitos colados
+ * em letras ("hc595") fazem parte do nome:
+ *   "hc595_pin_3_on" -> chave "hc595_pin_#_on", args[0] = 3
+ *   "hc595_byte_170" -> chave "hc595_byte_#",   args[0] = 170
+ *
+ * Uso:
+ *   static constexpr Dispatch::Entry<Handler> ENTRIES[] = {{"start", onStart}, ...};
+ *   static constexpr auto TABLE = Dispatch::makeTable(ENTRIES);
+ *   static_assert(TABLE.valid(), "sem semente sem colisões");
+ *   Handler h = TABLE.find(key, len);
+ */
+
+#ifndef DISPATCH_MAX_KEY
+#define DISPATCH_MAX_KEY 32 // maior nome normalizado aceito
+#endif
+
+#ifndef DISPATCH_MAX_ARGS
+#define DISPATCH_MAX_ARGS 2 // números extraídos do nome
+#endif
+
+namespace Dispatch
+{
+    constexpr uint32_t NO_SEED = 0xFFFFFFFFu;
+    constexpr uint32_t MAX_SEED_SEARCH = 4096;
+
+    // FNV-1a 32 bits com semente misturada na base
+    constexpr uint32_t fnv1a(const char *text, size_t length, uint32_t seed)
+    {
+        uint32_t hash = 2166136261u ^ (seed * 16777619u);
+        for (size_t i = 0; i < length; i++)
+        {
+            hash ^= (uint8_t)text[i];
+            hash *= 16777619u;
+        }
+        return hash ^ (hash >> 15);
+    }
+
+    constexpr size_t tableSizeFor(size_t count)
+    {
+        size_t size = 4;
+        while (size < count * 2)
+        {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    // Argumentos numéricos extraídos do nome, em ordem de aparição
+    struct ActionArgs
+    {
+        long values[DISPATCH_MAX_ARGS] = {};
+        uint8_t count = 0;
+        Json::Slice raw; // nome original, como recebido
+
+        // Argumento 'index' dentro de [min, max]; false se ausente ou fora da faixa
+        bool integer(uint8_t index, long min, long max, long &out) const
+        {
+            if (index >= count || values[index] < min || values[index] > max)
+            {
+                return false;
+            }
+            out = values[index];
+            return true;
+        }
+    };
+
+    // Troca cada segmento só de dígitos por '#', guardando o valor em args
+    inline bool normalize(const Json::Slice &name, char *key, size_t capacity, size_t &keyLength, ActionArgs &args)
+    {
+        args = ActionArgs();
+        args.raw = name;
+        keyLength = 0;
+
+        for (size_t i = 0; i < name.len;)
+        {
+            if (keyLength + 1 >= capacity)
+            {
+                return false;
+            }
+
+            size_t end = i;
+            while (end < name.len && name.ptr[end] >= '0' && name.ptr[end] <= '9')
+            {
+                end++;
+            }
+
+            bool segmentStart = (i == 0 || name.ptr[i - 1] == '_');
+            bool segmentEnd = (end == name.len || name.ptr[end] == '_');
+            if (end == i || !segmentStart || !segmentEnd)
+            {
+                // Não é argumento: copia até o fim da sequência analisada
+                size_t stop = (end == i) ? i + 1 : end;
+                for (; i < stop; i++)
+                {
+                    if (keyLength + 1 >= capacity)
+                    {
+                        return false;
+                    }
+                    key[keyLength++] = name.ptr[i];
+                }
+                continue;
+            }
+
+            long value = 0;
+            for (; i < end; i++)
+            {
+                if (value < 100000000L)
+                {
+                    value = value * 10 + (name.ptr[i] - '0');
+                }
+            }
+
+            if (args.count >= DISPATCH_MAX_ARGS)
+            {
+                return false;
+            }
+            args.values[args.count++] = value;
+            key[keyLength++] = '#';
+        }
+
+        key[keyLength] = '\0';
+        return true;
+    }
+
+    template <typename Handler>
+    struct Entry
+    {
+        const char *name;
+        size_t length;
+        Handler handler;
+
+        template <size_t N>
+        constexpr Entry(const char (&literal)[N], Handler fn) : name(literal), length(N - 1), handler(fn)
+        {
+        }
+    };
+
+    template <typename Handler, size_t N>
+    class Table
+    {
+    public:
+        static constexpr size_t SIZE = tableSizeFor(N);
+
+        constexpr explicit Table(const Entry<Handler> (&entries)[N]) : _entries(entries)
+        {
+            for (uint32_t seed = 0; seed < MAX_SEED_SEARCH; seed++)
+            {
+                if (place(seed))
+                {
+                    _seed = seed;
+                    return;
+                }
+            }
+        }
+
+        constexpr bool valid() const { return _seed != NO_SEED; }
+        constexpr uint32_t seed() const { return _seed; }
+        constexpr size_t size() const { return N; }
+
+        // Handler registrado para o nome exato, ou nullptr
+        Handler find(const char *key, size_t length) const
+        {
+            uint8_t slot = _slots[fnv1a(key, length, _seed) & (SIZE - 1)];
+            if (slot == 0)
+            {
+                return nullptr;
+            }
+
+            const Entry<Handler> &entry = _entries[slot - 1];
+            if (entry.length != length || memcmp(entry.name, key, length) != 0)
+            {
+                return nullptr;
+            }
+            return entry.handler;
+        }
+
+        Handler find(const Json::Slice &key) const
+        {
+            return find(key.ptr, key.len);
+        }
+
+        // Normaliza o nome (dígitos -> '#') e busca; args recebe os números
+        Handler find(const Json::Slice &name, ActionArgs &args) const
+        {
+            char key[DISPATCH_MAX_KEY];
+            size_t length = 0;
+            if (!normalize(name, key, sizeof(key), length, args))
+            {
+                return nullptr;
+            }
+            return find(key, length);
+        }
+
+    private:
+        constexpr bool place(uint32_t seed)
+        {
+            for (size_t i = 0; i < SIZE; i++)
+            {
+                _slots[i] = 0;
+            }
+
+            for (size_t i = 0; i < N; i++)
+            {
+                size_t slot = fnv1a(_entries[i].name, _entries[i].length, seed) & (SIZE - 1);
+                if (_slots[slot] != 0)
+                {
+                    return false;
+                }
+                _slots[slot] = (uint8_t)(i + 1);
+            }
+            return true;
+        }
+
+        const Entry<Handler> (&_entries)[N];
+        uint32_t _seed = NO_SEED;
+        uint8_t _slots[SIZE] = {};
+    };
+
+    template <typename Handler, size_t N>
+    constexpr Table<Handler, N> makeTable(const Entry<Handler> (&entries)[N])
+    {
+        static_assert(N < 255, "Tabela de despacho limitada a 254 entradas");
+        return Table<Handler, N>(entries);
+    }
+}
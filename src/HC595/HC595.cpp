@@ -7,6 +7,39 @@ namespace HC595
     // Estado atual dos 8 pinos (bit 0 = Q0, bit 7 = Q7)
     static uint8_t currentState = 0;
 
+    // Latch adiado durante um lote de comandos
+    static bool batching = false;
+    static bool batchDirty = false;
+
+    // Running light em andamento (avançado por loop())
+    static bool animating = false;
+    static uint8_t animationStep = 0;
+    static uint16_t animationStepMs = 0;
+    static unsigned long animationStepAt = 0;
+
+    static void latch()
+    {
+        // Puxa LATCH para baixo para começar a transmissão
+        digitalWrite(HC595_LATCH_PIN, LOW);
+
+        // Envia os 8 bits, começando pelo mais significativo (Q7 primeiro)
+        for (int8_t i = 7; i >= 0; i--)
+        {
+            digitalWrite(HC595_DATA_PIN, (currentState >> i) & 1);
+
+            // Pulso de clock para registrar o bit
+            digitalWrite(HC595_CLOCK_PIN, HIGH);
+            delayMicroseconds(1);
+            digitalWrite(HC595_CLOCK_PIN, LOW);
+            delayMicroseconds(1);
+        }
+
+        // Puxa LATCH para cima para aplicar os dados nas saídas
+        digitalWrite(HC595_LATCH_PIN, HIGH);
+        delayMicroseconds(1);
+        digitalWrite(HC595_LATCH_PIN, LOW);
+    }
+
     void begin()
     {
         // Configura pinos como saída
@@ -30,6 +63,8 @@ namespace HC595
         if (pin > 7)
             return; // Pin inválido
 
+        animating = false;
+
         if (state)
         {
             currentState |= (1 << pin); // Liga o bit
@@ -42,30 +77,34 @@ namespace HC595
 
     void setByte(uint8_t value)
     {
+        animating = false;
         currentState = value;
     }
 
     void update()
     {
-        // Puxa LATCH para baixo para começar a transmissão
-        digitalWrite(HC595_LATCH_PIN, LOW);
-
-        // Envia os 8 bits, começando pelo mais significativo (Q7 primeiro)
-        for (int8_t i = 7; i >= 0; i--)
+        if (batching)
         {
-            digitalWrite(HC595_DATA_PIN, (currentState >> i) & 1);
-
-            // Pulso de clock para registrar o bit
-            digitalWrite(HC595_CLOCK_PIN, HIGH);
-            delayMicroseconds(1);
-            digitalWrite(HC595_CLOCK_PIN, LOW);
-            delayMicroseconds(1);
+            batchDirty = true;
+            return;
         }
+        latch();
+    }
 
-        // Puxa LATCH para cima para aplicar os dados nas saídas
-        digitalWrite(HC595_LATCH_PIN, HIGH);
-        delayMicroseconds(1);
-        digitalWrite(HC595_LATCH_PIN, LOW);
+    void beginBatch()
+    {
+        batching = true;
+        batchDirty = false;
+    }
+
+    void commitBatch()
+    {
+        batching = false;
+        if (batchDirty)
+        {
+            batchDirty = false;
+            latch();
+        }
     }
 
     bool getPin(uint8_t pin)
@@ -109,14 +148,40 @@ namespace HC595
 
     void runningLight(uint16_t delayMs)
     {
-        for (uint8_t i = 0; i < 8; i++)
+        animating = true;
+        animationStep = 0;
+        animationStepMs = delayMs;
+        animationStepAt = millis();
+
+        currentState = 1; // Liga apenas o LED atual
+        latch();          // Animação é visível mesmo dentro de um lote
+    }
+
+    void loop()
+    {
+        if (!animating || millis() - animationStepAt < animationStepMs)
         {
-            setByte(1 << i); // Liga apenas o LED atual
-            update();
-            delay(delayMs);
+            return;
         }
 
-        // Volta ao estado anterior
-        allOff();
+        animationStepAt = millis();
+        animationStep++;
+
+        if (animationStep >= 8)
+        {
+            // Fim do efeito: tudo desligado
+            animating = false;
+            currentState = 0;
+        }
+        else
+        {
+            currentState = 1 << animationStep;
+        }
+        latch();
+    }
+
+    bool isAnimating()
+    {
+        return animating;
     }
 }
\ No newline at end of file
@@ -38,6 +38,11 @@ namespace HC595
     // Aplica as mudanças nas saídas (shift out + latch)
     void update();
 
+    // Lote: entre beginBatch() e commitBatch() update() só marca pendência;
+    // commitBatch() faz um único shift out + latch se algo mudou
+    void beginBatch();
+    void commitBatch();
+
     // Obtém o estado atual de um pino (0-7)
     bool getPin(uint8_t pin);
 
@@ -53,6 +58,13 @@ namespace HC595
     // Pisca um pino específico
     void blinkPin(uint8_t pin, uint16_t delayMs = 500);
 
-    // Efeito sequencial (como um LED running)
+    // Efeito sequencial (como um LED running), sem bloquear: só inicia a
+    // animação, que avança em loop(). Termina com todas as saídas desligadas;
+    // setPin/setByte/allOn/allOff no meio da animação a cancelam.
     void runningLight(uint16_t delayMs = 200);
+
+    // Avança a animação em andamento (chamar a cada iteração do loop)
+    void loop();
+
+    bool isAnimating();
 }
\ No newline at end of file
@@ -0,0 +1,468 @@
+#include "event_journal.h"
+#include "../Config/config.h"
+#include "../Protocol/messages.h"
+#include <LittleFS.h>
+#include <time.h>
+
+namespace
+{
+    const char ACTIVE_PATH[] = "/journal.bin";
+    const char PREVIOUS_PATH[] = "/journal.old";
+    const char ACK_PATH[] = "/journal.ack";
+
+    // Fragmentos do lote de replay
+    const char J_HEAD[] PROGMEM = "{\"type\":\"journal\",\"carId\":\"" CAR_ID_STR "\"" JSON_KEY("events") "[";
+    const char J_TAIL[] PROGMEM = "]}";
+
+    // Pior caso por evento: [seq,"liberate","LIBERATED_TIME",rem,upMs,ts] + vírgula
+    static_assert(Json::literalLength(J_HEAD) + Json::literalLength(J_TAIL) +
+                          JOURNAL_REPLAY_BATCH * (6 + 3 * 10 + 5 + 2 * 16) <
+                      WS_TX_BUFFER_SIZE,
+                  "WS_TX_BUFFER_SIZE pequeno demais para JOURNAL_REPLAY_BATCH");
+
+    const char K_TYPE[] PROGMEM = "type";
+    const char K_CAR_ID[] PROGMEM = "carId";
+    const char K_EVENTS[] PROGMEM = "events";
+    const char V_JOURNAL[] PROGMEM = "journal";
+    const char V_CAR_ID[] PROGMEM = CAR_ID_STR;
+
+    // Anel em RAM: caminho barato usado pelos handlers de ação
+    Journal::Record g_ring[JOURNAL_RAM_RECORDS];
+    uint8_t g_ringHead = 0;
+    uint8_t g_ringCount = 0;
+    unsigned long g_ringOldestAt = 0;
+    uint32_t g_ringDropped = 0;
+
+    bool g_fsReady = false;
+    bool g_online = false;
+    uint32_t g_nextSeq = 1;
+    uint32_t g_ackedSeq = 0;
+    uint16_t g_activeRecords = 0;
+
+    // Lote em trânsito aguardando journal_ack
+    uint32_t g_inflightSeq = 0;
+    unsigned long g_inflightSentAt = 0;
+
+    // Falha de leitura dos segmentos: nova tentativa depois de JOURNAL_ACK_TIMEOUT_MS
+    bool g_readFailed = false;
+    unsigned long g_readFailedAt = 0;
+
+    const Journal::Record &ringAt(uint8_t i)
+    {
+        return g_ring[(g_ringHead + i) % JOURNAL_RAM_RECORDS];
+    }
+
+    void ringPopFront()
+    {
+        g_ringHead = (g_ringHead + 1) % JOURNAL_RAM_RECORDS;
+        g_ringCount--;
+    }
+
+    uint32_t lastSeqIn(const char *path, uint16_t *records)
+    {
+        File f = LittleFS.open(path, "r");
+        if (!f)
+        {
+            return 0;
+        }
+
+        size_t count = f.size() / sizeof(Journal::Record);
+        if (records)
+        {
+            *records = (uint16_t)count;
+        }
+
+        Journal::Record rec;
+        uint32_t seq = 0;
+        if (count > 0 && f.seek((count - 1) * sizeof(Journal::Record), SeekSet) &&
+            f.read(reinterpret_cast<uint8_t *>(&rec), sizeof(rec)) == sizeof(rec))
+        {
+            seq = rec.seq;
+        }
+        f.close();
+        return seq;
+    }
+
+    void persistAck()
+    {
+        File f = LittleFS.open(ACK_PATH, "w");
+        if (f)
+        {
+            f.write(reinterpret_cast<const uint8_t *>(&g_ackedSeq), sizeof(g_ackedSeq));
+            f.close();
+        }
+    }
+
+    // Avança o ponto confirmado; com tudo confirmado os segmentos são apagados
+    void acknowledge(uint32_t seq)
+    {
+        g_ackedSeq = seq;
+        if (g_ackedSeq >= g_inflightSeq)
+        {
+            g_inflightSeq = 0;
+        }
+
+        while (g_ringCount > 0 && ringAt(0).seq <= g_ackedSeq)
+        {
+            ringPopFront();
+        }
+
+        if (!g_fsReady)
+        {
+            return;
+        }
+
+        persistAck();
+
+        if (g_ackedSeq + 1 >= g_nextSeq)
+        {
+            LittleFS.remove(ACTIVE_PATH);
+            LittleFS.remove(PREVIOUS_PATH);
+            g_activeRecords = 0;
+            Serial.println(F("[JOURNAL] Replay confirmado - diário vazio"));
+        }
+    }
+
+    // Segmento ativo cheio: vira o anterior (o mais antigo é descartado)
+    void rotateSegment()
+    {
+        LittleFS.remove(PREVIOUS_PATH);
+        LittleFS.rename(ACTIVE_PATH, PREVIOUS_PATH);
+        g_activeRecords = 0;
+
+        if (LOG_VERBOSE)
+        {
+            Serial.println(F("[JOURNAL] Segmento cheio - rotacionado"));
+        }
+    }
+
+    void flushRing()
+    {
+        if (!g_fsReady || g_ringCount == 0)
+        {
+            return;
+        }
+
+        File f = LittleFS.open(ACTIVE_PATH, "a");
+        while (f && g_ringCount > 0)
+        {
+            if (g_activeRecords >= JOURNAL_SEGMENT_RECORDS)
+            {
+                f.close();
+                rotateSegment();
+                f = LittleFS.open(ACTIVE_PATH, "a");
+                continue;
+            }
+
+            const Journal::Record &rec = ringAt(0);
+            if (f.write(reinterpret_cast<const uint8_t *>(&rec), sizeof(rec)) != sizeof(rec))
+            {
+                Serial.println(F("[JOURNAL][ERRO] Falha ao gravar registro"));
+                break;
+            }
+            g_activeRecords++;
+            ringPopFront();
+        }
+
+        if (f)
+        {
+            f.close();
+        }
+    }
+
+    // Copia até 'max' registros com seq > afterSeq, em ordem: .old, .bin, anel.
+    // 'ok' vira false se um segmento existente não pôde ser aberto ou lido.
+    size_t readFile(const char *path, uint32_t afterSeq, Journal::Record *out, size_t n, size_t max, bool &ok)
+    {
+        if (!g_fsReady || n >= max || !LittleFS.exists(path))
+        {
+            return n;
+        }
+
+        File f = LittleFS.open(path, "r");
+        if (!f)
+        {
+            ok = false;
+            return n;
+        }
+
+        size_t count = f.size() / sizeof(Journal::Record);
+        Journal::Record rec;
+        for (size_t i = 0; i < count && n < max; i++)
+        {
+            if (f.read(reinterpret_cast<uint8_t *>(&rec), sizeof(rec)) != sizeof(rec))
+            {
+                ok = false;
+                break;
+            }
+            if (rec.seq > afterSeq)
+            {
+                out[n++] = rec;
+            }
+        }
+        f.close();
+        return n;
+    }
+
+    size_t collectPending(Journal::Record *out, size_t max, bool &ok)
+    {
+        ok = true;
+        size_t n = readFile(PREVIOUS_PATH, g_ackedSeq, out, 0, max, ok);
+        n = readFile(ACTIVE_PATH, g_ackedSeq, out, n, max, ok);
+        for (uint8_t i = 0; i < g_ringCount && n < max; i++)
+        {
+            if (ringAt(i).seq > g_ackedSeq)
+            {
+                out[n++] = ringAt(i);
+            }
+        }
+        return n;
+    }
+
+    // Decide se há lote a enviar agora e o carrega em 'batch'
+    size_t nextBatch(Journal::Record *batch, unsigned long now)
+    {
+        if (!g_online || g_ackedSeq + 1 >= g_nextSeq)
+        {
+            return 0;
+        }
+
+        if (g_inflightSeq != 0)
+        {
+            if (now - g_inflightSentAt < JOURNAL_ACK_TIMEOUT_MS)
+            {
+                return 0;
+            }
+            Serial.println(F("[JOURNAL] Sem journal_ack - reenviando lote"));
+            g_inflightSeq = 0;
+        }
+
+        if (g_readFailed && now - g_readFailedAt < JOURNAL_ACK_TIMEOUT_MS)
+        {
+            return 0;
+        }
+
+        flushRing();
+        bool ok = true;
+        size_t n = collectPending(batch, JOURNAL_REPLAY_BATCH, ok);
+        g_readFailed = !ok;
+        if (g_readFailed)
+        {
+            // Falha transitória do flash não prova perda, e um lote parcial faria
+            // o journal_ack pular o que não foi lido: mantém tudo pendente
+            g_readFailedAt = now;
+            Serial.println(F("[JOURNAL][ERRO] Falha ao ler o diário - nova tentativa mais tarde"));
+            return 0;
+        }
+        if (n == 0)
+        {
+            // Segmentos lidos por inteiro sem nenhum seq pendente: os registros
+            // não confirmados saíram na rotação e não há o que reenviar
+            acknowledge(g_nextSeq - 1);
+            return 0;
+        }
+
+        g_inflightSeq = batch[n - 1].seq;
+        g_inflightSentAt = now;
+        return n;
+    }
+}
+
+namespace Journal
+{
+
+    void begin()
+    {
+        g_fsReady = LittleFS.begin();
+        if (!g_fsReady)
+        {
+            Serial.println(F("[JOURNAL][ERRO] LittleFS indisponível - diário só em RAM"));
+            return;
+        }
+
+        File ack = LittleFS.open(ACK_PATH, "r");
+        if (ack)
+        {
+            ack.read(reinterpret_cast<uint8_t *>(&g_ackedSeq), sizeof(g_ackedSeq));
+            ack.close();
+        }
+
+        uint32_t lastSeq = lastSeqIn(ACTIVE_PATH, &g_activeRecords);
+        if (lastSeq == 0)
+        {
+            lastSeq = lastSeqIn(PREVIOUS_PATH, nullptr);
+        }
+        g_nextSeq = ((lastSeq > g_ackedSeq) ? lastSeq : g_ackedSeq) + 1;
+
+        Serial.print(F("[JOURNAL] Pronto - pendentes="));
+        Serial.println(pendingCount());
+    }
+
+    void loop()
+    {
+        if (g_ringCount == 0)
+        {
+            return;
+        }
+
+        if (millis() - g_ringOldestAt >= JOURNAL_FLUSH_MS || g_ringCount >= JOURNAL_RAM_RECORDS / 2)
+        {
+            flushRing();
+        }
+    }
+
+    void setOnline(bool online)
+    {
+        g_online = online;
+    }
+
+    void onConnected()
+    {
+        g_inflightSeq = 0;
+
+        if (pendingCount() > 0)
+        {
+            Serial.print(F("[JOURNAL] Reconectado - eventos a reenviar: "));
+            Serial.println(pendingCount());
+        }
+    }
+
+    void record(EventType event, OperationStatus status, int remainingSeconds)
+    {
+        if (g_online)
+        {
+            return;
+        }
+
+        if (g_ringCount == JOURNAL_RAM_RECORDS)
+        {
+            // Flash indisponível ou sem descarga: perde o mais antigo
+            ringPopFront();
+            g_ringDropped++;
+        }
+
+        if (g_ringCount == 0)
+        {
+            g_ringOldestAt = millis();
+        }
+
+        Record &rec = g_ring[(g_ringHead + g_ringCount) % JOURNAL_RAM_RECORDS];
+        time_t epoch = time(nullptr);
+        rec.seq = g_nextSeq++;
+        rec.uptimeMs = millis();
+        rec.epoch = (epoch > 1600000000) ? (uint32_t)epoch : 0;
+        rec.event = event;
+        rec.status = (uint8_t)status;
+        rec.remainingSeconds = (uint16_t)constrain(remainingSeconds, 0, 0xFFFF);
+        g_ringCount++;
+
+        if (LOG_VERBOSE)
+        {
+            Serial.print(F("[JOURNAL] Offline - registrado seq="));
+            Serial.print(rec.seq);
+            Serial.print(F(" evento="));
+            Serial.println(eventToString(event));
+        }
+    }
+
+    bool buildReplay(Json::Writer &json, unsigned long now)
+    {
+        Record batch[JOURNAL_REPLAY_BATCH];
+        size_t n = nextBatch(batch, now);
+        if (n == 0)
+        {
+            return false;
+        }
+
+        json.raw(J_HEAD);
+        for (size_t i = 0; i < n; i++)
+        {
+            if (i > 0)
+            {
+                json.put(',');
+            }
+            json.put('[')
+                .number((unsigned long)batch[i].seq)
+                .put(',')
+                .put('"')
+                .str(eventToString(batch[i].event))
+                .put('"')
+                .put(',')
+                .put('"')
+                .str(statusToString((OperationStatus)batch[i].status))
+                .put('"')
+                .put(',')
+                .number((unsigned int)batch[i].remainingSeconds)
+                .put(',')
+                .number((unsigned long)batch[i].uptimeMs)
+                .put(',')
+                .number((unsigned long)batch[i].epoch)
+                .put(']');
+        }
+        json.raw(J_TAIL);
+        return true;
+    }
+
+    bool buildReplay(MsgPack::Writer &msg, unsigned long now)
+    {
+        Record batch[JOURNAL_REPLAY_BATCH];
+        size_t n = nextBatch(batch, now);
+        if (n == 0)
+        {
+            return false;
+        }
+
+        msg.map(3).key(K_TYPE).key(V_JOURNAL).key(K_CAR_ID).key(V_CAR_ID).key(K_EVENTS).array(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            msg.array(6)
+                .number((unsigned long)batch[i].seq)
+                .str(eventToString(batch[i].event))
+                .str(statusToString((OperationStatus)batch[i].status))
+                .number((unsigned int)batch[i].remainingSeconds)
+                .number((unsigned long)batch[i].uptimeMs)
+                .number((unsigned long)batch[i].epoch);
+        }
+        return true;
+    }
+
+    void handleAck(const uint8_t *payload, size_t length, Json::Format format)
+    {
+        Protocol::JournalAckMsg msg;
+        if (!Protocol::decodeJournalAck(payload, length, format, msg))
+        {
+            return;
+        }
+
+        if (msg.seq <= g_ackedSeq || msg.seq >= g_nextSeq)
+        {
+            return;
+        }
+
+        acknowledge(msg.seq);
+    }
+
+    uint32_t pendingCount()
+    {
+        return g_nextSeq - 1 - g_ackedSeq;
+    }
+
+    const char *eventToString(uint8_t event)
+    {
+        switch (event)
+        {
+        case EV_START:
+            return "start";
+        case EV_STOP:
+            return "stop";
+        case EV_PAUSE:
+            return "pause";
+        case EV_RESUME:
+            return "resume";
+        case EV_LIBERATE:
+            return "liberate";
+        default:
+            return "unknown";
+        }
+    }
+}
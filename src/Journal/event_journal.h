@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Arduino.h>
+#include "../Operation/operation_state.h"
+#include "../Json/json_writer.h"
+#include "../Json/msgpack_writer.h"
+#include "../Json/json_tokenizer.h"
+
+/**
+ * Diário de eventos offline (LittleFS)
+ *
+ * Transições de operação feitas com o gateway fora do ar são gravadas como
+ * registros binários de 16 bytes e reenviadas em ordem na reconexão.
+ * - record(): só copia o registro para um anel em RAM (seguro dentro dos handlers)
+ * - loop(): descarrega o anel em /journal.bin quando ocioso; ao atingir
+ *   JOURNAL_SEGMENT_RECORDS o segmento vira /journal.old (o mais antigo é
+ *   descartado), e o wear leveling fica a cargo do LittleFS
+ * - replay: lotes {"type":"journal","events":[[seq,ev,status,rem,upMs,ts],...]}
+ *   confirmados pelo gateway com {"type":"journal_ack","seq":N}; sem ack em
+ *   JOURNAL_ACK_TIMEOUT_MS o lote é reenviado
+ * O último seq confirmado fica em /journal.ack, então seq nunca se repete
+ * entre reboots.
+ */
+
+namespace Journal
+{
+    enum EventType : uint8_t
+    {
+        EV_START = 1,
+        EV_STOP,
+        EV_PAUSE,
+        EV_RESUME,
+        EV_LIBERATE
+    };
+
+    // Registro gravado como está no arquivo (little-endian)
+    struct __attribute__((packed)) Record
+    {
+        uint32_t seq;
+        uint32_t uptimeMs;
+        uint32_t epoch; // 0 se o NTP ainda não sincronizou
+        uint8_t event;
+        uint8_t status; // OperationStatus após a transição
+        uint16_t remainingSeconds;
+    };
+
+    static_assert(sizeof(Record) == 16, "Registro do diário deve ter 16 bytes");
+
+    void begin();
+    void loop();
+
+    // Online: transições seguem ao vivo pelo status; offline: vão para o diário
+    void setOnline(bool online);
+    void onConnected();
+
+    void record(EventType event, OperationStatus status, int remainingSeconds);
+
+    // Serializa o próximo lote pendente; false se não há nada a enviar agora
+    bool buildReplay(Json::Writer &json, unsigned long now);
+    bool buildReplay(MsgPack::Writer &msg, unsigned long now);
+
+    // Processa {"type":"journal_ack","seq":N}
+    void handleAck(const uint8_t *payload, size_t length, Json::Format format = Json::FORMAT_JSON);
+
+    uint32_t pendingCount();
+    const char *eventToString(uint8_t event);
+}
@@ -0,0 +1,100 @@
+#include "json_stream.h"
+
+#include <cstring>
+
+namespace Json
+{
+
+    StreamTokenizer::StreamTokenizer(char *window, size_t capacity)
+        : _window(window), _capacity(capacity), _tok(nullptr, 0)
+    {
+        reset();
+    }
+
+    void StreamTokenizer::reset()
+    {
+        _carry = 0;
+        _consumed = 0;
+        _error = STREAM_OK;
+        _tok = Tokenizer(nullptr, 0);
+        _tok.setPartial(true);
+    }
+
+    // Entrega os tokens completos da janela e move o incompleto para o início
+    bool StreamTokenizer::drain(TokenFn onToken, void *context)
+    {
+        _tok.resume(reinterpret_cast<const uint8_t *>(_window), _carry);
+
+        Token tok;
+        while (_tok.next(tok))
+        {
+            onToken(tok, context);
+        }
+
+        if (tok.type == TOK_ERROR)
+        {
+            _error = STREAM_MALFORMED;
+            return false;
+        }
+
+        size_t left = _carry - _tok.offset();
+        if (tok.type == TOK_INCOMPLETE && left >= _capacity)
+        {
+            _error = STREAM_TOKEN_TOO_LARGE;
+            return false;
+        }
+
+        memmove(_window, _window + _tok.offset(), left);
+        _carry = left;
+        return true;
+    }
+
+    bool StreamTokenizer::feed(const uint8_t *chunk, size_t length, TokenFn onToken, void *context)
+    {
+        if (_error != STREAM_OK)
+        {
+            return false;
+        }
+
+        while (length > 0)
+        {
+            size_t n = _capacity - _carry;
+            if (n > length)
+            {
+                n = length;
+            }
+
+            memcpy(_window + _carry, chunk, n);
+            _carry += n;
+            _consumed += n;
+            chunk += n;
+            length -= n;
+
+            if (!drain(onToken, context))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool StreamTokenizer::finish(TokenFn onToken, void *context)
+    {
+        if (_error != STREAM_OK)
+        {
+            return false;
+        }
+
+        // Sem mais dados, o que sobrou na janela precisa fechar como token completo
+        _tok.setPartial(false);
+        bool ok = drain(onToken, context);
+        _tok.setPartial(true);
+
+        if (ok && (_carry > 0 || _tok.depth() > 0))
+        {
+            _error = STREAM_TRUNCATED;
+            ok = false;
+        }
+        return ok;
+    }
+}
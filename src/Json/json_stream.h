@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "json_tokenizer.h"
+
+/**
+ * Tokenização incremental de JSON entregue em pedaços
+ *
+ * Para mensagens fragmentadas (WStype_FRAGMENT_*): cada pedaço é copiado
+ * para uma janela fixa fornecida pelo chamador e tokenizado na hora; só o
+ * token cortado na borda do pedaço fica na janela esperando o próximo.
+ * A memória por mensagem é a janela, não o tamanho da mensagem: um token
+ * maior que a janela aborta o fluxo (STREAM_TOKEN_TOO_LARGE).
+ *
+ * Os tokens entregues ao callback apontam para a janela e só valem
+ * durante a chamada.
+ *
+ * Uso:
+ *   static char window[128];
+ *   Json::StreamTokenizer stream(window, sizeof(window));
+ *   stream.feed(chunk1, len1, onToken, &ctx);
+ *   stream.feed(chunkN, lenN, onToken, &ctx);
+ *   bool ok = stream.finish(onToken, &ctx);
+ */
+
+namespace Json
+{
+    enum StreamError : uint8_t
+    {
+        STREAM_OK = 0,
+        STREAM_MALFORMED,       // JSON inválido
+        STREAM_TOKEN_TOO_LARGE, // um token não coube na janela
+        STREAM_TRUNCATED        // terminou com containers abertos
+    };
+
+    typedef void (*TokenFn)(const Token &tok, void *context);
+
+    class StreamTokenizer
+    {
+    public:
+        StreamTokenizer(char *window, size_t capacity);
+
+        void reset();
+
+        // Tokeniza mais um pedaço; false se o fluxo já falhou ou falhou agora
+        bool feed(const uint8_t *chunk, size_t length, TokenFn onToken, void *context);
+
+        // Último pedaço entregue: esvazia a janela e confere o fechamento
+        bool finish(TokenFn onToken, void *context);
+
+        StreamError error() const { return _error; }
+        size_t consumed() const { return _consumed; }
+
+    private:
+        bool drain(TokenFn onToken, void *context);
+
+        char *_window;
+        size_t _capacity;
+        size_t _carry = 0; // bytes do token incompleto no início da janela
+        size_t _consumed = 0;
+        StreamError _error = STREAM_OK;
+        Tokenizer _tok;
+    };
+}
@@ -0,0 +1,546 @@
+#include "json_tokenizer.h"
+
+#include <cstring>
+#include <climits>
+
+namespace Json
+{
+
+    // ===== SLICE =====
+
+    bool Slice::equals(const char *lit) const
+    {
+        size_t n = strlen(lit);
+        return n == len && memcmp(ptr, lit, n) == 0;
+    }
+
+    bool Slice::startsWith(const char *lit) const
+    {
+        size_t n = strlen(lit);
+        return n <= len && memcmp(ptr, lit, n) == 0;
+    }
+
+    bool Slice::endsWith(const char *lit) const
+    {
+        size_t n = strlen(lit);
+        return n <= len && memcmp(ptr + len - n, lit, n) == 0;
+    }
+
+    long Slice::toLong(size_t from) const
+    {
+        long value = 0;
+        bool negative = false;
+        size_t i = from;
+
+        if (i < len && ptr[i] == '-')
+        {
+            negative = true;
+            i++;
+        }
+
+        for (; i < len && ptr[i] >= '0' && ptr[i] <= '9'; i++)
+        {
+            if (value > (LONG_MAX - 9) / 10)
+            {
+                break; // satura em vez de estourar
+            }
+            value = value * 10 + (ptr[i] - '0');
+        }
+
+        return negative ? -value : value;
+    }
+
+    size_t Slice::copyTo(char *dst, size_t capacity) const
+    {
+        if (capacity == 0)
+        {
+            return 0;
+        }
+
+        size_t n = (len < capacity - 1) ? len : capacity - 1;
+        memcpy(dst, ptr, n);
+        dst[n] = '\0';
+        return n;
+    }
+
+    // ===== TOKENIZER =====
+
+    Tokenizer::Tokenizer(const uint8_t *data, size_t length, Format format)
+        : _data(reinterpret_cast<const char *>(data)), _length(data ? length : 0), _format(format)
+    {
+    }
+
+    bool Tokenizer::fail(Token &tok)
+    {
+        _failed = true;
+        tok.type = TOK_ERROR;
+        tok.text.ptr = _data + _pos;
+        tok.text.len = 0;
+        return false;
+    }
+
+    bool Tokenizer::incomplete(Token &tok, size_t start)
+    {
+        _pos = start;
+        tok.type = TOK_INCOMPLETE;
+        tok.text.ptr = _data + start;
+        tok.text.len = _length - start;
+        return false;
+    }
+
+    void Tokenizer::resume(const uint8_t *data, size_t length)
+    {
+        _data = reinterpret_cast<const char *>(data);
+        _length = data ? length : 0;
+        _pos = 0;
+    }
+
+    void Tokenizer::afterValue()
+    {
+        if (_format == FORMAT_MSGPACK)
+        {
+            // Cada elemento concluído (chave ou valor) consome um item do container pai
+            if (_depth > 0 && _remaining[_depth - 1] > 0)
+            {
+                _remaining[_depth - 1]--;
+            }
+            return;
+        }
+
+        // Dentro de objeto, depois de um valor vem outra chave
+        _expectKey = _depth > 0 && (_objectMask & (1u << (_depth - 1)));
+    }
+
+    bool Tokenizer::next(Token &tok)
+    {
+        if (_failed)
+        {
+            return fail(tok);
+        }
+
+        if (_format == FORMAT_MSGPACK)
+        {
+            return nextMsgPack(tok);
+        }
+
+        // Pula espaços e separadores; a estrutura é validada pelos delimitadores
+        while (_pos < _length)
+        {
+            char c = _data[_pos];
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',' || c == ':')
+            {
+                _pos++;
+                continue;
+            }
+            break;
+        }
+
+        tok.number = 0;
+        tok.text.ptr = _data + _pos;
+        tok.text.len = 0;
+        tok.depth = _depth;
+
+        if (_pos >= _length)
+        {
+            tok.type = TOK_END;
+            return false;
+        }
+
+        char c = _data[_pos];
+
+        switch (c)
+        {
+        case '{':
+        case '[':
+            if (_depth >= MAX_DEPTH)
+            {
+                return fail(tok);
+            }
+            tok.type = (c == '{') ? TOK_OBJECT_START : TOK_ARRAY_START;
+            if (c == '{')
+            {
+                _objectMask |= (1u << _depth);
+            }
+            else
+            {
+                _objectMask &= ~(1u << _depth);
+            }
+            _depth++;
+            _pos++;
+            _expectKey = (c == '{');
+            return true;
+
+        case '}':
+        case ']':
+        {
+            bool isObject = _depth > 0 && (_objectMask & (1u << (_depth - 1)));
+            if (_depth == 0 || isObject != (c == '}'))
+            {
+                return fail(tok);
+            }
+            _depth--;
+            _pos++;
+            tok.type = (c == '}') ? TOK_OBJECT_END : TOK_ARRAY_END;
+            tok.depth = _depth;
+            afterValue();
+            return true;
+        }
+
+        case '"':
+        {
+            size_t start = ++_pos;
+            while (_pos < _length && _data[_pos] != '"')
+            {
+                // Escapes são preservados na fatia; só pulamos o caractere escapado
+                _pos += (_data[_pos] == '\\') ? 2 : 1;
+            }
+            if (_pos >= _length)
+            {
+                _pos = _length; // escape no último byte pula além do fim
+                return _partial ? incomplete(tok, start - 1) : fail(tok);
+            }
+
+            tok.text.ptr = _data + start;
+            tok.text.len = _pos - start;
+            _pos++;
+
+            if (_expectKey)
+            {
+                tok.type = TOK_KEY;
+                _expectKey = false;
+            }
+            else
+            {
+                tok.type = TOK_STRING;
+                afterValue();
+            }
+            return true;
+        }
+
+        default:
+            break;
+        }
+
+        if (_expectKey)
+        {
+            return fail(tok); // chave sem aspas
+        }
+
+        if (c == '-' || (c >= '0' && c <= '9'))
+        {
+            size_t start = _pos;
+            _pos++;
+            while (_pos < _length)
+            {
+                char d = _data[_pos];
+                if ((d >= '0' && d <= '9') || d == '.' || d == 'e' || d == 'E' || d == '+' || d == '-')
+                {
+                    _pos++;
+                    continue;
+                }
+                break;
+            }
+
+            // O número pode continuar no próximo pedaço
+            if (_partial && _pos >= _length)
+            {
+                return incomplete(tok, start);
+            }
+
+            tok.type = TOK_NUMBER;
+            tok.text.len = _pos - start;
+            tok.number = tok.text.toLong();
+            afterValue();
+            return true;
+        }
+
+        struct Literal
+        {
+            const char *word;
+            size_t len;
+            TokenType type;
+        };
+        static const Literal literals[] = {
+            {"true", 4, TOK_TRUE},
+            {"false", 5, TOK_FALSE},
+            {"null", 4, TOK_NULL},
+        };
+
+        for (const Literal &lit : literals)
+        {
+            size_t available = _length - _pos;
+            if (available >= lit.len && memcmp(_data + _pos, lit.word, lit.len) == 0)
+            {
+                tok.type = lit.type;
+                tok.text.len = lit.len;
+                _pos += lit.len;
+                afterValue();
+                return true;
+            }
+
+            if (_partial && available < lit.len && memcmp(_data + _pos, lit.word, available) == 0)
+            {
+                return incomplete(tok, _pos);
+            }
+        }
+
+        return fail(tok);
+    }
+
+    // ===== MESSAGEPACK =====
+
+    namespace
+    {
+        uint32_t readBigEndian(const char *p, uint8_t bytes)
+        {
+            uint32_t value = 0;
+            for (uint8_t i = 0; i < bytes; i++)
+            {
+                value = (value << 8) | (uint8_t)p[i];
+            }
+            return value;
+        }
+
+        uint64_t readBigEndian64(const char *p)
+        {
+            return ((uint64_t)readBigEndian(p, 4) << 32) | readBigEndian(p + 4, 4);
+        }
+
+        // Token::number é long (32 bits na placa): fora da faixa satura
+        long clampLong(int64_t value)
+        {
+            if (value > LONG_MAX)
+                return LONG_MAX;
+            if (value < LONG_MIN)
+                return LONG_MIN;
+            return (long)value;
+        }
+
+        long clampLong(uint64_t value)
+        {
+            return value > (uint64_t)LONG_MAX ? LONG_MAX : (long)value;
+        }
+
+        long clampLong(double value)
+        {
+            if (value != value)
+                return 0; // NaN
+            if (value >= (double)LONG_MAX)
+                return LONG_MAX;
+            if (value <= (double)LONG_MIN)
+                return LONG_MIN;
+            return (long)value;
+        }
+    }
+
+    bool Tokenizer::openMsgPack(Token &tok, bool isObject, uint32_t count)
+    {
+        if (_depth >= MAX_DEPTH || (isObject && count > 0x7FFFFFFF))
+        {
+            return fail(tok);
+        }
+
+        tok.type = isObject ? TOK_OBJECT_START : TOK_ARRAY_START;
+        if (isObject)
+        {
+            _objectMask |= (1u << _depth);
+        }
+        else
+        {
+            _objectMask &= ~(1u << _depth);
+        }
+        _remaining[_depth] = isObject ? count * 2 : count;
+        _depth++;
+        return true;
+    }
+
+    bool Tokenizer::nextMsgPack(Token &tok)
+    {
+        tok.number = 0;
+        tok.text.ptr = _data + _pos;
+        tok.text.len = 0;
+        tok.depth = _depth;
+
+        // Container esgotado: emite o fechamento correspondente
+        if (_depth > 0 && _remaining[_depth - 1] == 0)
+        {
+            bool isObject = _objectMask & (1u << (_depth - 1));
+            _depth--;
+            tok.type = isObject ? TOK_OBJECT_END : TOK_ARRAY_END;
+            tok.depth = _depth;
+            afterValue();
+            return true;
+        }
+
+        if (_pos >= _length)
+        {
+            if (_depth > 0)
+            {
+                return fail(tok); // truncado
+            }
+            tok.type = TOK_END;
+            return false;
+        }
+
+        const uint8_t b = (uint8_t)_data[_pos++];
+        const size_t left = _length - _pos;
+        const bool inObject = _depth > 0 && (_objectMask & (1u << (_depth - 1)));
+        const bool isKey = inObject && (_remaining[_depth - 1] % 2 == 0);
+
+        // Tamanho de string/bin e de inteiros com largura explícita
+        uint32_t strLen = 0;
+        bool isString = false;
+
+        if (b <= 0x7F || b >= 0xE0)
+        {
+            tok.type = TOK_NUMBER;
+            tok.number = (int8_t)b;
+        }
+        else if (isKey && ((b >= 0x80 && b <= 0x9F) || b == 0xDC || b == 0xDD || b == 0xDE || b == 0xDF))
+        {
+            return fail(tok); // containers não podem ser chave
+        }
+        else if (b >= 0x80 && b <= 0x8F)
+        {
+            return openMsgPack(tok, true, b & 0x0F);
+        }
+        else if (b >= 0x90 && b <= 0x9F)
+        {
+            return openMsgPack(tok, false, b & 0x0F);
+        }
+        else if (b >= 0xA0 && b <= 0xBF)
+        {
+            isString = true;
+            strLen = b & 0x1F;
+        }
+        else
+        {
+            static const uint8_t widths[] = {
+                // 0xC0..0xDF: bytes de cabeçalho após o marcador (0xFF = inválido)
+                0, 0xFF, 0, 0, 1, 2, 4, 0xFF, 0xFF, 0xFF, 4, 8, 1, 2, 4, 8,
+                1, 2, 4, 8, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 1, 2, 4, 2, 4, 2, 4};
+            uint8_t width = widths[b - 0xC0];
+            if (width == 0xFF || left < width)
+            {
+                return fail(tok);
+            }
+
+            const char *p = _data + _pos;
+            _pos += width;
+
+            switch (b)
+            {
+            case 0xC0:
+                tok.type = TOK_NULL;
+                break;
+            case 0xC2:
+                tok.type = TOK_FALSE;
+                break;
+            case 0xC3:
+                tok.type = TOK_TRUE;
+                break;
+            case 0xC4: // bin 8/16/32 tratados como string bruta
+            case 0xC5:
+            case 0xC6:
+            case 0xD9: // str 8/16/32
+            case 0xDA:
+            case 0xDB:
+                isString = true;
+                strLen = readBigEndian(p, width);
+                break;
+            case 0xCA: // float32
+            {
+                uint32_t bits = readBigEndian(p, 4);
+                float f;
+                memcpy(&f, &bits, sizeof(f));
+                tok.type = TOK_NUMBER;
+                tok.number = clampLong((double)f);
+                break;
+            }
+            case 0xCB: // float64
+            {
+                uint64_t bits = readBigEndian64(p);
+                double d;
+                memcpy(&d, &bits, sizeof(d));
+                tok.type = TOK_NUMBER;
+                tok.number = clampLong(d);
+                break;
+            }
+            case 0xCC:
+            case 0xCD:
+                tok.type = TOK_NUMBER;
+                tok.number = (long)readBigEndian(p, width);
+                break;
+            case 0xCE: // uint32: acima de INT32_MAX não cabe em long de 32 bits
+                tok.type = TOK_NUMBER;
+                tok.number = clampLong((uint64_t)readBigEndian(p, 4));
+                break;
+            case 0xCF:
+                tok.type = TOK_NUMBER;
+                tok.number = clampLong(readBigEndian64(p));
+                break;
+            case 0xD0:
+                tok.type = TOK_NUMBER;
+                tok.number = (int8_t)readBigEndian(p, 1);
+                break;
+            case 0xD1:
+                tok.type = TOK_NUMBER;
+                tok.number = (int16_t)readBigEndian(p, 2);
+                break;
+            case 0xD2:
+                tok.type = TOK_NUMBER;
+                tok.number = (int32_t)readBigEndian(p, 4);
+                break;
+            case 0xD3:
+                tok.type = TOK_NUMBER;
+                tok.number = clampLong((int64_t)readBigEndian64(p));
+                break;
+            case 0xDC:
+            case 0xDD:
+                return openMsgPack(tok, false, readBigEndian(p, width));
+            case 0xDE:
+            case 0xDF:
+                return openMsgPack(tok, true, readBigEndian(p, width));
+            default:
+                return fail(tok);
+            }
+        }
+
+        if (isString)
+        {
+            if (_length - _pos < strLen)
+            {
+                return fail(tok);
+            }
+            tok.text.ptr = _data + _pos;
+            tok.text.len = strLen;
+            _pos += strLen;
+            tok.type = isKey ? TOK_KEY : TOK_STRING;
+        }
+        else if (isKey)
+        {
+            return fail(tok); // só chaves string são suportadas
+        }
+
+        afterValue();
+        return true;
+    }
+
+    bool Tokenizer::skip(const Token &opened)
+    {
+        if (opened.type != TOK_OBJECT_START && opened.type != TOK_ARRAY_START)
+        {
+            return true; // valores escalares já foram consumidos
+        }
+
+        Token tok;
+        while (next(tok))
+        {
+            if ((tok.type == TOK_OBJECT_END || tok.type == TOK_ARRAY_END) && tok.depth == opened.depth)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Tokenizador JSON "pull" sem alocação
+ *
+ * Percorre o payload recebido no próprio buffer (sem copiar para String)
+ * e entrega um token por chamada de next(). Chaves e valores são expostos
+ * como fatias (ponteiro + tamanho) apontando para dentro do buffer original,
+ * portanto só são válidos enquanto o payload existir.
+ *
+ * Não depende de Arduino.h para poder ser compilado também no host.
+ *
+ * O mesmo modelo de tokens é produzido a partir de MessagePack
+ * (FORMAT_MSGPACK), de modo que os parsers de mensagens funcionam igual
+ * para frames WStype_TEXT e WStype_BIN. Em MessagePack só chaves string
+ * são aceitas, números de ponto flutuante são truncados para inteiro e
+ * inteiros fora da faixa de long (32 bits na placa) saturam em
+ * LONG_MIN/LONG_MAX.
+ *
+ * Modo parcial (setPartial): um token cortado no fim do buffer não é erro;
+ * next() devolve TOK_INCOMPLETE sem consumi-lo e resume() continua de um
+ * novo buffer que comece por esse token, preservando profundidade e o tipo
+ * dos containers abertos. É a base do StreamTokenizer (json_stream.h).
+ * Só para JSON; MessagePack não tem modo parcial.
+ *
+ * Uso:
+ *   Json::Tokenizer tok(payload, length);
+ *   Json::Token t;
+ *   while (tok.next(t))
+ *   {
+ *       if (t.type == Json::TOK_KEY && t.text.equals("action")) ...
+ *   }
+ */
+
+namespace Json
+{
+
+    // ===== TIPOS DE TOKEN =====
+    enum TokenType : uint8_t
+    {
+        TOK_END = 0,      // Fim do buffer
+        TOK_ERROR,        // JSON malformado ou profundidade excedida
+        TOK_OBJECT_START, // {
+        TOK_OBJECT_END,   // }
+        TOK_ARRAY_START,  // [
+        TOK_ARRAY_END,    // ]
+        TOK_KEY,          // Chave de objeto (sem aspas)
+        TOK_STRING,       // Valor string (sem aspas, escapes preservados)
+        TOK_NUMBER,       // Número (inteiro em Token::number)
+        TOK_TRUE,
+        TOK_FALSE,
+        TOK_NULL,
+        TOK_INCOMPLETE // Modo parcial: token cortado no fim do buffer (não consumido)
+    };
+
+    // Codificação do payload
+    enum Format : uint8_t
+    {
+        FORMAT_JSON = 0,
+        FORMAT_MSGPACK
+    };
+
+    // Fatia de texto dentro do buffer original (sem cópia)
+    struct Slice
+    {
+        const char *ptr = nullptr;
+        size_t len = 0;
+
+        bool empty() const { return len == 0; }
+        bool equals(const char *lit) const;
+        bool startsWith(const char *lit) const;
+        bool endsWith(const char *lit) const;
+
+        // Lê um inteiro decimal a partir de 'from' (0 se não houver dígitos)
+        long toLong(size_t from = 0) const;
+
+        // Copia para 'dst' com terminador nulo, truncando se necessário
+        size_t copyTo(char *dst, size_t capacity) const;
+    };
+
+    struct Token
+    {
+        TokenType type = TOK_END;
+        uint8_t depth = 0; // Containers abertos que envolvem o token (chaves da raiz = 1)
+        Slice text;        // Conteúdo bruto de chaves e strings (e números em JSON)
+        long number = 0;   // Parte inteira quando TOK_NUMBER
+    };
+
+    class Tokenizer
+    {
+    public:
+        static const uint8_t MAX_DEPTH = 16;
+
+        Tokenizer(const uint8_t *data, size_t length, Format format = FORMAT_JSON);
+
+        // Lê o próximo token; retorna false em TOK_END ou TOK_ERROR
+        bool next(Token &tok);
+
+        // Consome o restante do valor aberto por 'opened' (objeto/array)
+        bool skip(const Token &opened);
+
+        size_t offset() const { return _pos; }
+        uint8_t depth() const { return _depth; }
+
+        // Modo parcial: ver descrição acima
+        void setPartial(bool partial) { _partial = partial; }
+
+        // Continua a partir de um novo buffer mantendo o estado estrutural
+        void resume(const uint8_t *data, size_t length);
+
+    private:
+        bool fail(Token &tok);
+        bool incomplete(Token &tok, size_t start);
+        void afterValue();
+        bool nextMsgPack(Token &tok);
+        bool openMsgPack(Token &tok, bool isObject, uint32_t count);
+
+        const char *_data;
+        size_t _length;
+        size_t _pos = 0;
+        uint8_t _depth = 0;
+        uint16_t _objectMask = 0; // bit n = 1 se o container n é objeto
+        bool _expectKey = false;
+        bool _failed = false;
+        bool _partial = false;
+        Format _format;
+        uint32_t _remaining[MAX_DEPTH]; // MessagePack: elementos restantes por container
+    };
+}
@@ -0,0 +1,144 @@
+#include "json_writer.h"
+
+namespace Json
+{
+
+    Writer::Writer(char *buffer, size_t capacity)
+        : _buffer(buffer), _capacity(capacity)
+    {
+        reset();
+    }
+
+    void Writer::reset()
+    {
+        _length = 0;
+        _overflow = (_capacity == 0);
+        if (_capacity)
+        {
+            _buffer[0] = '\0';
+        }
+    }
+
+    Writer &Writer::put(char c)
+    {
+        // Mantém sempre espaço para o terminador nulo
+        if (_length + 1 >= _capacity)
+        {
+            _overflow = true;
+            return *this;
+        }
+        _buffer[_length++] = c;
+        _buffer[_length] = '\0';
+        return *this;
+    }
+
+    Writer &Writer::rawP(PGM_P fragment, size_t length)
+    {
+        if (_length + length >= _capacity)
+        {
+            _overflow = true;
+            return *this;
+        }
+        memcpy_P(_buffer + _length, fragment, length);
+        _length += length;
+        _buffer[_length] = '\0';
+        return *this;
+    }
+
+    Writer &Writer::append(const char *data, size_t length)
+    {
+        if (_length + length >= _capacity)
+        {
+            _overflow = true;
+            return *this;
+        }
+        memcpy(_buffer + _length, data, length);
+        _length += length;
+        _buffer[_length] = '\0';
+        return *this;
+    }
+
+    Writer &Writer::str(const char *value)
+    {
+        if (!value)
+        {
+            return *this;
+        }
+
+        for (const char *p = value; *p; p++)
+        {
+            if (*p == '"' || *p == '\\')
+            {
+                put('\\');
+            }
+            put(*p);
+        }
+        return *this;
+    }
+
+    Writer &Writer::str(const char *value, size_t length)
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            if (value[i] == '"' || value[i] == '\\')
+            {
+                put('\\');
+            }
+            put(value[i]);
+        }
+        return *this;
+    }
+
+    Writer &Writer::number(unsigned long value)
+    {
+        char digits[12];
+        size_t n = 0;
+
+        do
+        {
+            digits[n++] = (char)('0' + (value % 10));
+            value /= 10;
+        } while (value && n < sizeof(digits));
+
+        while (n)
+        {
+            put(digits[--n]);
+        }
+        return *this;
+    }
+
+    Writer &Writer::number(long value)
+    {
+        if (value < 0)
+        {
+            put('-');
+            return number((unsigned long)(-(value + 1)) + 1UL);
+        }
+        return number((unsigned long)value);
+    }
+
+    Writer &Writer::boolean(bool value)
+    {
+        static const char TRUE_STR[] PROGMEM = "true";
+        static const char FALSE_STR[] PROGMEM = "false";
+        return value ? raw(TRUE_STR) : raw(FALSE_STR);
+    }
+
+    Writer &Writer::ip(const IPAddress &address)
+    {
+        if (!address.isSet())
+        {
+            return *this; // mesmo comportamento de Net::ip() sem conexão
+        }
+
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            if (i)
+            {
+                put('.');
+            }
+            number((unsigned long)address[i]);
+        }
+        return *this;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+/**
+ * Escritor JSON sobre buffer fixo
+ *
+ * Serializa direto em um buffer fornecido pelo chamador, sem String e sem
+ * heap. Trechos constantes (chaves, prefixos com CAR_ID_STR) são literais
+ * concatenados em tempo de compilação e mantidos em flash (PROGMEM); o
+ * tamanho de cada um vem do tipo do array, então não há strlen em runtime.
+ *
+ * Uso:
+ *   static const char HEAD[] PROGMEM = "{\"type\":\"x\"" JSON_KEY("n");
+ *   Json::Writer w(buffer, sizeof(buffer));
+ *   w.raw(HEAD).number(42).raw(JSON_CLOSE);
+ */
+
+// Literal ",\"name\":" montado pelo pré-processador
+#define JSON_KEY(name) ",\"" name "\":"
+// Literal ",\"name\":\"" para valores string
+#define JSON_KEY_STR(name) ",\"" name "\":\""
+
+namespace Json
+{
+    // Tamanho de um literal sem o terminador, disponível em compilação
+    template <size_t N>
+    constexpr size_t literalLength(const char (&)[N])
+    {
+        return N - 1;
+    }
+
+    class Writer
+    {
+    public:
+        Writer(char *buffer, size_t capacity);
+
+        // Fragmento constante em flash; tamanho resolvido pelo template
+        template <size_t N>
+        Writer &raw(const char (&fragment)[N])
+        {
+            return rawP(fragment, N - 1);
+        }
+
+        Writer &rawP(PGM_P fragment, size_t length);
+        Writer &append(const char *data, size_t length); // trecho já serializado em RAM (cache)
+        Writer &str(const char *value); // escapa '"' e '\\'
+        Writer &str(const char *value, size_t length);
+        Writer &number(long value);
+        Writer &number(unsigned long value);
+        Writer &number(int value) { return number((long)value); }
+        Writer &number(unsigned int value) { return number((unsigned long)value); }
+        Writer &boolean(bool value);
+        Writer &ip(const IPAddress &address);
+        Writer &put(char c);
+
+        const char *c_str() const { return _buffer; }
+        size_t length() const { return _length; }
+        bool overflowed() const { return _overflow; }
+        void reset();
+
+    private:
+        char *_buffer;
+        size_t _capacity;
+        size_t _length = 0;
+        bool _overflow = false;
+    };
+}
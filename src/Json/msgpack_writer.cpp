@@ -0,0 +1,239 @@
+#include "msgpack_writer.h"
+
+namespace MsgPack
+{
+
+    Writer::Writer(uint8_t *buffer, size_t capacity)
+        : _buffer(buffer), _capacity(capacity)
+    {
+    }
+
+    void Writer::reset()
+    {
+        _length = 0;
+        _overflow = false;
+    }
+
+    bool Writer::reserve(size_t bytes)
+    {
+        if (_overflow || _length + bytes > _capacity)
+        {
+            _overflow = true;
+            return false;
+        }
+        return true;
+    }
+
+    void Writer::putByte(uint8_t b)
+    {
+        if (reserve(1))
+        {
+            _buffer[_length++] = b;
+        }
+    }
+
+    void Writer::putBigEndian(uint32_t value, uint8_t bytes)
+    {
+        if (!reserve(bytes))
+        {
+            return;
+        }
+        for (int8_t i = bytes - 1; i >= 0; i--)
+        {
+            _buffer[_length++] = (uint8_t)(value >> (8 * i));
+        }
+    }
+
+    // fixmap/fixarray até 15 itens; depois marcador de 16 ou 32 bits
+    void Writer::header(uint8_t fixBase, uint8_t fixMax, uint8_t marker16, uint32_t count)
+    {
+        if (count <= fixMax)
+        {
+            putByte(fixBase | (uint8_t)count);
+        }
+        else if (count <= 0xFFFF)
+        {
+            putByte(marker16);
+            putBigEndian(count, 2);
+        }
+        else
+        {
+            putByte(marker16 + 1);
+            putBigEndian(count, 4);
+        }
+    }
+
+    Writer &Writer::map(uint32_t count)
+    {
+        header(0x80, 15, 0xDE, count);
+        return *this;
+    }
+
+    Writer &Writer::array(uint32_t count)
+    {
+        header(0x90, 15, 0xDC, count);
+        return *this;
+    }
+
+    void Writer::stringHeader(size_t length)
+    {
+        if (length <= 31)
+        {
+            putByte(0xA0 | (uint8_t)length);
+        }
+        else if (length <= 0xFF)
+        {
+            putByte(0xD9);
+            putByte((uint8_t)length);
+        }
+        else if (length <= 0xFFFF)
+        {
+            putByte(0xDA);
+            putBigEndian(length, 2);
+        }
+        else
+        {
+            putByte(0xDB);
+            putBigEndian(length, 4);
+        }
+    }
+
+    Writer &Writer::strP(PGM_P value, size_t length)
+    {
+        stringHeader(length);
+        if (reserve(length))
+        {
+            memcpy_P(_buffer + _length, value, length);
+            _length += length;
+        }
+        return *this;
+    }
+
+    Writer &Writer::str(const char *value, size_t length)
+    {
+        stringHeader(length);
+        if (reserve(length))
+        {
+            memcpy(_buffer + _length, value, length);
+            _length += length;
+        }
+        return *this;
+    }
+
+    Writer &Writer::append(const uint8_t *data, size_t length)
+    {
+        if (reserve(length))
+        {
+            memcpy(_buffer + _length, data, length);
+            _length += length;
+        }
+        return *this;
+    }
+
+    Writer &Writer::str(const char *value)
+    {
+        return str(value ? value : "", value ? strlen(value) : 0);
+    }
+
+    Writer &Writer::bin(const uint8_t *value, size_t length)
+    {
+        if (length <= 0xFF)
+        {
+            putByte(0xC4);
+            putByte((uint8_t)length);
+        }
+        else if (length <= 0xFFFF)
+        {
+            putByte(0xC5);
+            putBigEndian(length, 2);
+        }
+        else
+        {
+            putByte(0xC6);
+            putBigEndian(length, 4);
+        }
+        if (reserve(length))
+        {
+            memcpy(_buffer + _length, value, length);
+            _length += length;
+        }
+        return *this;
+    }
+
+    Writer &Writer::number(unsigned long value)
+    {
+        if (value <= 0x7F)
+        {
+            putByte((uint8_t)value);
+        }
+        else if (value <= 0xFF)
+        {
+            putByte(0xCC);
+            putByte((uint8_t)value);
+        }
+        else if (value <= 0xFFFF)
+        {
+            putByte(0xCD);
+            putBigEndian(value, 2);
+        }
+        else
+        {
+            putByte(0xCE);
+            putBigEndian(value, 4);
+        }
+        return *this;
+    }
+
+    Writer &Writer::number(long value)
+    {
+        if (value >= 0)
+        {
+            return number((unsigned long)value);
+        }
+
+        if (value >= -32)
+        {
+            putByte((uint8_t)(int8_t)value); // negative fixint
+        }
+        else if (value >= -128)
+        {
+            putByte(0xD0);
+            putByte((uint8_t)(int8_t)value);
+        }
+        else if (value >= -32768)
+        {
+            putByte(0xD1);
+            putBigEndian((uint16_t)(int16_t)value, 2);
+        }
+        else
+        {
+            putByte(0xD2);
+            putBigEndian((uint32_t)(int32_t)value, 4);
+        }
+        return *this;
+    }
+
+    Writer &Writer::boolean(bool value)
+    {
+        putByte(value ? 0xC3 : 0xC2);
+        return *this;
+    }
+
+    Writer &Writer::nil()
+    {
+        putByte(0xC0);
+        return *this;
+    }
+
+    Writer &Writer::ip(const IPAddress &address)
+    {
+        if (!address.isSet())
+        {
+            return str("", 0);
+        }
+
+        char text[16];
+        int n = snprintf(text, sizeof(text), "%u.%u.%u.%u", address[0], address[1], address[2], address[3]);
+        return str(text, n > 0 ? (size_t)n : 0);
+    }
+}
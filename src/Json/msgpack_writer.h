@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+/**
+ * Escritor MessagePack sobre buffer fixo
+ *
+ * Contraparte binária de Json::Writer: serializa direto no buffer do
+ * chamador, sem heap, sempre escolhendo a menor representação de cada
+ * inteiro. Chaves constantes devem ser arrays PROGMEM; o tamanho vem do
+ * tipo do array.
+ *
+ * Uso:
+ *   static const char K_TYPE[] PROGMEM = "type";
+ *   MsgPack::Writer w(buffer, sizeof(buffer));
+ *   w.map(1).key(K_TYPE).str("status");
+ */
+
+namespace MsgPack
+{
+    class Writer
+    {
+    public:
+        Writer(uint8_t *buffer, size_t capacity);
+
+        Writer &map(uint32_t count);
+        Writer &array(uint32_t count);
+
+        // Chave/literal constante em flash
+        template <size_t N>
+        Writer &key(const char (&name)[N])
+        {
+            return strP(name, N - 1);
+        }
+
+        Writer &strP(PGM_P value, size_t length);
+        Writer &str(const char *value);
+        Writer &str(const char *value, size_t length);
+        Writer &bin(const uint8_t *value, size_t length);
+        Writer &number(long value);
+        Writer &number(unsigned long value);
+        Writer &number(int value) { return number((long)value); }
+        Writer &number(unsigned int value) { return number((unsigned long)value); }
+        Writer &boolean(bool value);
+        Writer &nil();
+        Writer &ip(const IPAddress &address); // texto "a.b.c.d", como no JSON
+        Writer &append(const uint8_t *data, size_t length); // itens já serializados (cache)
+
+        const uint8_t *data() const { return _buffer; }
+        size_t length() const { return _length; }
+        bool overflowed() const { return _overflow; }
+        void reset();
+
+    private:
+        bool reserve(size_t bytes);
+        void putByte(uint8_t b);
+        void putBigEndian(uint32_t value, uint8_t bytes);
+        void header(uint8_t fixBase, uint8_t fixMax, uint8_t marker16, uint32_t count);
+        void stringHeader(size_t length);
+
+        uint8_t *_buffer;
+        size_t _capacity;
+        size_t _length = 0;
+        bool _overflow = false;
+    };
+}
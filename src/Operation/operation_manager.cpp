@@ -3,6 +3,9 @@
 #include "../Reley/reley.h"
 #include "../HC595/HC595.h"
 #include "../Config/config.h"
+#include "session_data.h"
+#include "../Journal/event_journal.h"
+#include "../Dispatch/perfect_hash.h"
 
 // Estado global da operação
 OperationState g_operationState;
@@ -237,6 +240,8 @@ namespace Operation
         int displayMinutes = totalSeconds / 60;
         int displaySeconds = totalSeconds % 60;
 
+        Journal::record(Journal::EV_START, g_operationState.status, totalSeconds);
+
         Serial.println(F("\n🚀 === OPERACAO INICIADA ==="));
         Serial.printf("⏰ Duracao: %d min %02d seg (%d seg)\n", displayMinutes, displaySeconds, totalSeconds);
         Serial.printf("📊 Status: %s\n", getStatusString());
@@ -260,6 +265,8 @@ namespace Operation
             g_operationState.relayState = false;
         }
 
+        Journal::record(Journal::EV_STOP, g_operationState.status, 0);
+
         Serial.println(F("\n🛑 === OPERACAO PARADA ==="));
         Serial.printf("⏱️  Tempo total: %lu seg\n",
                       (millis() - (g_operationState.lastCountUpdate > 0 ? g_operationState.lastCountUpdate : millis())) / 1000);
@@ -274,6 +281,7 @@ namespace Operation
             g_operationState.status == OP_LIBERATED_TIME)
         {
             g_operationState.status = OP_PAUSED;
+            Journal::record(Journal::EV_PAUSE, g_operationState.status, g_operationState.remainingSeconds);
             int remainingMins = g_operationState.remainingSeconds / 60;
             int remainingSecs = g_operationState.remainingSeconds % 60;
             Serial.printf("⏸️  PAUSADO - Restam: %02d:%02d\n", remainingMins, remainingSecs);
@@ -286,6 +294,7 @@ namespace Operation
         {
             g_operationState.status = OP_ACTIVE;
             g_operationState.lastCountUpdate = millis();
+            Journal::record(Journal::EV_RESUME, g_operationState.status, g_operationState.remainingSeconds);
             int remainingMins = g_operationState.remainingSeconds / 60;
             int remainingSecs = g_operationState.remainingSeconds % 60;
             Serial.printf("▶️  RESUMIDO - Continuando: %02d:%02d\n", remainingMins, remainingSecs);
@@ -305,6 +314,8 @@ namespace Operation
             g_operationState.relayState = true;
         }
 
+        Journal::record(Journal::EV_LIBERATE, g_operationState.status, 0);
+
         Serial.println(F("[OPERATION] Liberada sem tempo"));
         updateDisplay();
     }
@@ -314,217 +325,387 @@ namespace Operation
         updateTimeCounter();
     }
 
-    // ===== PROCESSAMENTO DE MENSAGENS =====
+    // ===== HANDLERS DE AÇÃO =====
 
-    void handleAction(const String &action)
+    static void actionStart(const Dispatch::ActionArgs &)
     {
-        // Comandos simples
-        if (action == "start")
+        Serial.println(F("📥 COMANDO START RECEBIDO"));
+        Serial.println(F("🚀 Ativando operacao - aguardando tempo do servidor..."));
+        g_operationState.status = OP_ACTIVE; // Ativa para ligar relay
+        g_operationState.lastCountUpdate = millis();
+
+        // Configura valores temporários até receber dados do servidor
+        g_operationState.remainingSeconds = 0; // Será sobrescrito pelo servidor
+        g_operationState.extraSeconds = 0;
+        g_operationState.isCountingDown = true;
+
+        // Liga relay imediatamente
+        if (!g_operationState.relayState)
         {
-            Serial.println(F("📥 COMANDO START RECEBIDO"));
-            Serial.println(F("🚀 Ativando operacao - aguardando tempo do servidor..."));
-            g_operationState.status = OP_ACTIVE; // Ativa para ligar relay
-            g_operationState.lastCountUpdate = millis();
+            Relay::start();
+            g_operationState.relayState = true;
+            Serial.println(F("⚡ Relay ligado (aguardando tempo do servidor)"));
+        }
 
-            // Configura valores temporários até receber dados do servidor
-            g_operationState.remainingSeconds = 0; // Será sobrescrito pelo servidor
-            g_operationState.extraSeconds = 0;
-            g_operationState.isCountingDown = true;
+        // Início sem tempo ainda: restante 0 até o session_data chegar
+        Journal::record(Journal::EV_START, g_operationState.status, 0);
 
-            // Liga relay imediatamente
-            if (!g_operationState.relayState)
-            {
-                Relay::start();
-                g_operationState.relayState = true;
-                Serial.println(F("⚡ Relay ligado (aguardando tempo do servidor)"));
-            }
+        // Mostra "aguardando" no display
+        Disp::showText("----");
+        Serial.println(F("📺 Display: Aguardando dados do servidor..."));
+    }
 
-            // Mostra "aguardando" no display
-            Disp::showText("----");
-            Serial.println(F("📺 Display: Aguardando dados do servidor..."));
+    static void actionStop(const Dispatch::ActionArgs &)
+    {
+        stop();
+    }
+
+    static void actionPause(const Dispatch::ActionArgs &)
+    {
+        pause();
+    }
+
+    static void actionResume(const Dispatch::ActionArgs &)
+    {
+        resume();
+    }
+
+    static void actionLiberateFree(const Dispatch::ActionArgs &)
+    {
+        liberateWithoutTime();
+    }
+
+    static bool validPin(const Dispatch::ActionArgs &args)
+    {
+        long pinIndex;
+        return args.integer(0, 0, 7, pinIndex);
+    }
+
+    static bool validByte(const Dispatch::ActionArgs &args)
+    {
+        long value;
+        return args.integer(0, 0, 255, value);
+    }
+
+    static void setHc595Pin(const Dispatch::ActionArgs &args, bool state)
+    {
+        uint8_t pinIndex = (uint8_t)args.values[0];
+        HC595::setPin(pinIndex, state);
+        HC595::update();
+        Serial.print(F("[HC595] Pin "));
+        Serial.print(pinIndex);
+        Serial.println(state ? F(" ligado") : F(" desligado"));
+    }
+
+    static void actionHc595PinOn(const Dispatch::ActionArgs &args)
+    {
+        setHc595Pin(args, true);
+    }
+
+    static void actionHc595PinOff(const Dispatch::ActionArgs &args)
+    {
+        setHc595Pin(args, false);
+    }
+
+    static void actionHc595AllOn(const Dispatch::ActionArgs &)
+    {
+        HC595::allOn();
+        Serial.println(F("[HC595] Todas as saídas ligadas"));
+    }
+
+    static void actionHc595AllOff(const Dispatch::ActionArgs &)
+    {
+        HC595::allOff();
+        Serial.println(F("[HC595] Todas as saídas desligadas"));
+    }
+
+    static void actionHc595RunningLight(const Dispatch::ActionArgs &)
+    {
+        HC595::runningLight(200);
+        Serial.println(F("[HC595] Efeito running light iniciado"));
+    }
+
+    static void actionHc595Byte(const Dispatch::ActionArgs &args)
+    {
+        uint8_t value = (uint8_t)args.values[0];
+        HC595::setByte(value);
+        HC595::update();
+        Serial.print(F("[HC595] Byte definido: 0b"));
+        Serial.println(value, BIN);
+    }
+
+    // Validação separada da aplicação: um lote só é aplicado se todas as ações forem válidas
+    struct Action
+    {
+        bool (*validate)(const Dispatch::ActionArgs &args); // nullptr = sem argumentos
+        void (*apply)(const Dispatch::ActionArgs &args);
+    };
+
+    static constexpr Action START = {nullptr, actionStart};
+    static constexpr Action STOP = {nullptr, actionStop};
+    static constexpr Action PAUSE = {nullptr, actionPause};
+    static constexpr Action RESUME = {nullptr, actionResume};
+    static constexpr Action LIBERATE_FREE = {nullptr, actionLiberateFree};
+    static constexpr Action HC595_PIN_ON = {validPin, actionHc595PinOn};
+    static constexpr Action HC595_PIN_OFF = {validPin, actionHc595PinOff};
+    static constexpr Action HC595_ALL_ON = {nullptr, actionHc595AllOn};
+    static constexpr Action HC595_ALL_OFF = {nullptr, actionHc595AllOff};
+    static constexpr Action HC595_RUNNING_LIGHT = {nullptr, actionHc595RunningLight};
+    static constexpr Action HC595_BYTE = {validByte, actionHc595Byte};
+
+    // Nomes normalizados: cada número do nome vira '#' e chega em args
+    static constexpr Dispatch::Entry<const Action *> ACTIONS[] = {
+        {"start", &START},
+        {"stop", &STOP},
+        {"pause", &PAUSE},
+        {"resume", &RESUME},
+        {"liberate_free", &LIBERATE_FREE},
+        {"emergency", &STOP},
+        {"hc595_pin_#_on", &HC595_PIN_ON},
+        {"hc595_pin_#_off", &HC595_PIN_OFF},
+        {"hc595_all_on", &HC595_ALL_ON},
+        {"hc595_all_off", &HC595_ALL_OFF},
+        {"hc595_running_light", &HC595_RUNNING_LIGHT},
+        {"hc595_byte_#", &HC595_BYTE},
+    };
+
+    static constexpr auto ACTION_TABLE = Dispatch::makeTable(ACTIONS);
+    static_assert(ACTION_TABLE.valid(), "Sem semente de hash perfeito para ACTIONS");
+
+    // Resolve e valida sem aplicar
+    static ActionError resolveAction(const Json::Slice &name, const Action *&action, Dispatch::ActionArgs &args)
+    {
+        action = ACTION_TABLE.find(name, args);
+        if (!action)
+        {
+            return ACTION_UNKNOWN;
         }
-        else if (action == "stop")
+        if (action->validate && !action->validate(args))
         {
-            stop();
+            return ACTION_INVALID_ARGUMENT;
         }
-        else if (action == "pause")
+        return ACTION_OK;
+    }
+
+    // ===== PROCESSAMENTO DE MENSAGENS =====
+
+    ActionError handleAction(const Json::Slice &name)
+    {
+        const Action *action;
+        Dispatch::ActionArgs args;
+        ActionError error = resolveAction(name, action, args);
+
+        if (error != ACTION_OK)
         {
-            pause();
+            Serial.print(error == ACTION_UNKNOWN ? F("[OPERATION] Ação desconhecida: ")
+                                                 : F("[OPERATION] Argumento inválido na ação: "));
+            Serial.write(reinterpret_cast<const uint8_t *>(name.ptr), name.len);
+            Serial.println();
+            return error;
         }
-        else if (action == "resume")
+
+        action->apply(args);
+        return ACTION_OK;
+    }
+
+    BatchResult handleActionBatch(const Json::Slice *names, size_t count)
+    {
+        BatchResult result;
+        const Action *actions[OP_MAX_BATCH_ACTIONS];
+        Dispatch::ActionArgs args[OP_MAX_BATCH_ACTIONS];
+
+        if (count > OP_MAX_BATCH_ACTIONS)
         {
-            resume();
+            result.error = ACTION_TOO_MANY;
+            return result;
         }
-        else if (action == "liberate_free")
+
+        // Fase 1: tudo ou nada - nenhuma ação é aplicada se alguma for inválida
+        for (size_t i = 0; i < count; i++)
         {
-            liberateWithoutTime();
+            result.error = resolveAction(names[i], actions[i], args[i]);
+            if (result.error != ACTION_OK)
+            {
+                result.failedIndex = (int8_t)i;
+                Serial.print(F("[OPERATION][LOTE] Rejeitado na ação "));
+                Serial.print(i);
+                Serial.print(F(": "));
+                Serial.write(reinterpret_cast<const uint8_t *>(names[i].ptr), names[i].len);
+                Serial.println();
+                return result;
+            }
         }
-        else if (action == "emergency")
+
+        // Fase 2: aplica em sequência com um único latch do HC595 no final
+        uint32_t started = micros();
+        HC595::beginBatch();
+        for (size_t i = 0; i < count; i++)
         {
-            stop();
+            actions[i]->apply(args[i]);
+            result.applied++;
         }
-        // Comandos HC595
-        else if (action.startsWith("hc595_pin_"))
+        HC595::commitBatch();
+        result.applyMicros = micros() - started;
+
+        Serial.print(F("[OPERATION][LOTE] "));
+        Serial.print(result.applied);
+        Serial.print(F(" ações aplicadas em "));
+        Serial.print(result.applyMicros);
+        Serial.println(F(" us"));
+        return result;
+    }
+
+    const char *actionErrorToString(ActionError error)
+    {
+        switch (error)
         {
-            int pinIndex = action.substring(10, 11).toInt();
-            bool state = action.endsWith("_on");
+        case ACTION_OK:
+            return "ok";
+        case ACTION_UNKNOWN:
+            return "unknown_action";
+        case ACTION_INVALID_ARGUMENT:
+            return "invalid_argument";
+        case ACTION_TOO_MANY:
+            return "too_many_actions";
+        case ACTION_MALFORMED:
+            return "malformed";
+        case ACTION_EXPIRED:
+            return "expired";
+        case ACTION_BUSY:
+            return "busy";
+        case ACTION_RATE_LIMITED:
+            return "rate_limited";
+        default:
+            return "error";
+        }
+    }
 
-            if (pinIndex >= 0 && pinIndex <= 7)
+    // Ordem histórica da cadeia if/else, usada como referência no benchmark
+    static int legacyActionIndex(const Json::Slice &action)
+    {
+        static const char *const EXACT[] = {"start", "stop", "pause", "resume", "liberate_free", "emergency"};
+        for (size_t i = 0; i < sizeof(EXACT) / sizeof(EXACT[0]); i++)
+        {
+            if (action.equals(EXACT[i]))
             {
-                HC595::setPin(pinIndex, state);
-                HC595::update();
-                Serial.print(F("[HC595] Pin "));
-                Serial.print(pinIndex);
-                Serial.println(state ? F(" ligado") : F(" desligado"));
+                return (int)i;
             }
         }
-        else if (action == "hc595_all_on")
-        {
-            HC595::allOn();
-            Serial.println(F("[HC595] Todas as saídas ligadas"));
-        }
-        else if (action == "hc595_all_off")
+        if (action.startsWith("hc595_pin_"))
+            return action.endsWith("_on") ? 6 : 7;
+        if (action.equals("hc595_all_on"))
+            return 8;
+        if (action.equals("hc595_all_off"))
+            return 9;
+        if (action.equals("hc595_running_light"))
+            return 10;
+        if (action.startsWith("hc595_byte_"))
+            return 11;
+        return -1;
+    }
+
+    void benchmarkActionDispatch(uint32_t iterations)
+    {
+        static const char *const SAMPLES[] = {
+            "start", "stop", "pause", "resume", "liberate_free", "emergency", "hc595_pin_3_on",
+            "hc595_pin_5_off", "hc595_all_on", "hc595_all_off", "hc595_running_light", "hc595_byte_170"};
+        const size_t sampleCount = sizeof(SAMPLES) / sizeof(SAMPLES[0]);
+
+        Json::Slice slices[sampleCount];
+        for (size_t i = 0; i < sampleCount; i++)
         {
-            HC595::allOff();
-            Serial.println(F("[HC595] Todas as saídas desligadas"));
+            slices[i].ptr = SAMPLES[i];
+            slices[i].len = strlen(SAMPLES[i]);
         }
-        else if (action == "hc595_running_light")
+
+        volatile uintptr_t sink = 0;
+        uint32_t lookups = iterations * sampleCount;
+
+        uint32_t started = ESP.getCycleCount();
+        for (uint32_t n = 0; n < iterations; n++)
         {
-            HC595::runningLight(200);
-            Serial.println(F("[HC595] Efeito running light executado"));
+            for (size_t i = 0; i < sampleCount; i++)
+            {
+                Dispatch::ActionArgs args;
+                sink = sink + (uintptr_t)ACTION_TABLE.find(slices[i], args);
+            }
         }
-        else if (action.startsWith("hc595_byte_"))
+        uint32_t hashCycles = ESP.getCycleCount() - started;
+
+        started = ESP.getCycleCount();
+        for (uint32_t n = 0; n < iterations; n++)
         {
-            uint8_t value = action.substring(11).toInt();
-            HC595::setByte(value);
-            HC595::update();
-            Serial.print(F("[HC595] Byte definido: 0b"));
-            Serial.println(value, BIN);
+            for (size_t i = 0; i < sampleCount; i++)
+            {
+                sink = sink + legacyActionIndex(slices[i]);
+            }
         }
+        uint32_t chainCycles = ESP.getCycleCount() - started;
+
+        Serial.println(F("[BENCH] Despacho de ações"));
+        Serial.printf("[BENCH] entradas=%u slots=%u semente=%lu buscas=%lu\n",
+                      (unsigned)ACTION_TABLE.size(), (unsigned)decltype(ACTION_TABLE)::SIZE,
+                      (unsigned long)ACTION_TABLE.seed(), (unsigned long)lookups);
+        Serial.printf("[BENCH] hash perfeito : %lu ciclos/busca\n", (unsigned long)(hashCycles / lookups));
+        Serial.printf("[BENCH] cadeia if/else: %lu ciclos/busca\n", (unsigned long)(chainCycles / lookups));
     }
 
-    void handleOperationMessage(const String &message)
+    void handleOperationMessage(const char *message, size_t length)
     {
         // Implementação simplificada - usar apenas para comandos básicos
         Serial.print(F("[OPERATION] Processando mensagem de operação: "));
-        Serial.println(message.substring(0, 50) + "...");
+        Serial.write(message, length < 50 ? length : 50);
+        Serial.println(F("..."));
 
         // TODO: Implementar parser JSON completo
     }
 
-    void handleSessionData(const String &message)
+    void handleSessionData(const uint8_t *payload, size_t length, Json::Format format)
+    {
+        SessionData session;
+        parseSessionData(payload, length, session, format);
+        applySessionData(session, length);
+    }
+
+    void applySessionData(const SessionData &session, size_t length)
     {
         Serial.println(F("\n+==========================================+"));
         Serial.println(F("|   📦 SESSÃO RECEBIDA DO SERVIDOR        |"));
         Serial.println(F("+==========================================+"));
 
-        auto readNumberAfter = [&](const String &source, int anchorIndex) -> int
+        if (session.found)
         {
-            if (anchorIndex < 0)
-                return -1;
-            int colonIdx = source.indexOf(':', anchorIndex);
-            if (colonIdx < 0)
-                return -1;
-
-            String numStr = "";
-            int i = colonIdx + 1;
-            while ((unsigned int)i < source.length() && (source.charAt(i) == ' ' || source.charAt(i) == '\t'))
-                i++;
-            while ((unsigned int)i < source.length() && isDigit(source.charAt(i)))
+            if (session.totalSeconds >= 0)
             {
-                numStr += source.charAt(i);
-                i++;
+                Serial.printf("| ⏰ Tempo restante: %02d:%02d (%d s)    |\n",
+                              session.totalSeconds / 60, session.totalSeconds % 60, session.totalSeconds);
             }
-            return (numStr.length() > 0) ? numStr.toInt() : -1;
-        };
-
-        // Procura por "data" ou "session_data"
-        int dataIndex = message.indexOf("\"data\":");
-        int sessionDataIndex = message.indexOf("\"session_data\":");
-        int targetIndex = (dataIndex >= 0) ? dataIndex : sessionDataIndex;
-
-        if (targetIndex >= 0)
-        {
-            int startBrace = message.indexOf("{", targetIndex);
-            if (startBrace >= 0)
+            else if (session.duration >= 0)
             {
-                String sessionDataStr = message.substring(startBrace);
-                int parsedSeconds = -1;
-                int parsedMinutes = -1;
-
-                // 1. Tenta extrair remainingTime.total_seconds
-                int remainingTimeIdx = sessionDataStr.indexOf("\"remainingTime\":");
-                if (remainingTimeIdx >= 0)
-                {
-                    int objStart = sessionDataStr.indexOf("{", remainingTimeIdx);
-                    if (objStart >= 0)
-                    {
-                        String remainingTimeStr = sessionDataStr.substring(objStart);
-                        int totalSecondsIdx = remainingTimeStr.indexOf("\"total_seconds\":");
-                        int seconds = readNumberAfter(remainingTimeStr, totalSecondsIdx);
-                        if (seconds >= 0)
-                        {
-                            parsedSeconds = seconds;
-                            parsedMinutes = seconds / 60;
-                            Serial.printf("| ⏰ Tempo restante: %02d:%02d (%d s)    |\n",
-                                          parsedMinutes, seconds % 60, seconds);
-                        }
-                    }
-                }
-
-                // 2. Se não encontrou, tenta duration
-                if (parsedSeconds < 0)
-                {
-                    int durationIdx = sessionDataStr.indexOf("\"duration\":");
-                    int seconds = readNumberAfter(sessionDataStr, durationIdx);
-                    if (seconds >= 0)
-                    {
-                        parsedSeconds = seconds;
-                        parsedMinutes = seconds / 60;
-                        Serial.printf("| ⏰ Duração: %02d:%02d (%d s)           |\n",
-                                      parsedMinutes, seconds % 60, seconds);
-                    }
-                }
-
-                // 3. Extrai outras informações para exibir
-                int initialMinIdx = sessionDataStr.indexOf("\"initialMinutes\":");
-                if (initialMinIdx >= 0)
-                {
-                    int mins = readNumberAfter(sessionDataStr, initialMinIdx);
-                    if (mins >= 0)
-                    {
-                        Serial.printf("| 📊 Tempo inicial: %02d:00              |\n", mins);
-                    }
-                }
+                Serial.printf("| ⏰ Duração: %02d:%02d (%d s)           |\n",
+                              session.duration / 60, session.duration % 60, session.duration);
+            }
 
-                int statusIdx = sessionDataStr.indexOf("\"status\":");
-                if (statusIdx >= 0)
-                {
-                    int q1 = sessionDataStr.indexOf("\"", statusIdx + 9);
-                    int q2 = sessionDataStr.indexOf("\"", q1 + 1);
-                    if (q1 >= 0 && q2 > q1)
-                    {
-                        String status = sessionDataStr.substring(q1 + 1, q2);
-                        Serial.print(F("| 📌 Status: "));
-                        Serial.print(status);
-                        Serial.println(F("                       |"));
-                    }
-                }
+            if (session.initialMinutes >= 0)
+            {
+                Serial.printf("| 📊 Tempo inicial: %02d:00              |\n", session.initialMinutes);
+            }
 
-                Serial.println(F("+==========================================+\n"));
+            if (session.status[0])
+            {
+                Serial.print(F("| 📌 Status: "));
+                Serial.print(session.status);
+                Serial.println(F("                       |"));
+            }
 
-                // Inicia a operação com o tempo encontrado
-                if (parsedSeconds > 0)
-                {
-                    startFromSeconds(parsedSeconds);
-                    return;
-                }
+            Serial.printf("| ⚙️  Parse: %lu us (%u bytes)\n", (unsigned long)session.parseMicros, (unsigned)length);
+            Serial.println(F("+==========================================+\n"));
 
-                if (parsedMinutes > 0)
-                {
-                    start(parsedMinutes);
-                    return;
-                }
+            // Inicia a operação com o tempo encontrado
+            if (session.seconds() > 0)
+            {
+                startFromSeconds(session.seconds());
+                return;
             }
         }
 
@@ -2,10 +2,33 @@
 
 #include <Arduino.h>
 #include "../Operation/operation_state.h"
+#include "../Json/json_tokenizer.h"
+#include "session_data.h"
 
 namespace Operation
 {
 
+    // ===== RESULTADO DE AÇÕES =====
+    enum ActionError : uint8_t
+    {
+        ACTION_OK = 0,
+        ACTION_UNKNOWN,
+        ACTION_INVALID_ARGUMENT,
+        ACTION_TOO_MANY,
+        ACTION_MALFORMED,
+        ACTION_EXPIRED,     // ttl vencido antes de chegar
+        ACTION_BUSY,        // fila de comandos cheia; pode reenviar com o mesmo id
+        ACTION_RATE_LIMITED // acima do limite de taxa; pode reenviar com o mesmo id
+    };
+
+    struct BatchResult
+    {
+        ActionError error = ACTION_OK;
+        int8_t failedIndex = -1; // índice da primeira ação rejeitada
+        uint8_t applied = 0;
+        uint32_t applyMicros = 0;
+    };
+
     // ===== FUNÇÕES PRINCIPAIS =====
     void initialize();
     void update();
@@ -27,7 +50,16 @@ namespace Operation
     const char *getStatusString();
 
     // ===== PROCESSAMENTO DE MENSAGENS =====
-    void handleOperationMessage(const String &message);
-    void handleSessionData(const String &message);
-    void handleAction(const String &action);
+    void handleOperationMessage(const char *message, size_t length);
+    void handleSessionData(const uint8_t *payload, size_t length, Json::Format format = Json::FORMAT_JSON);
+    // Aplica uma sessão já extraída (ex.: por SessionDataParser em mensagem fragmentada)
+    void applySessionData(const SessionData &session, size_t length);
+    ActionError handleAction(const Json::Slice &action);
+
+    // Valida todas as ações antes de aplicar qualquer uma; HC595 com um único latch
+    BatchResult handleActionBatch(const Json::Slice *actions, size_t count);
+    const char *actionErrorToString(ActionError error);
+
+    // ===== DIAGNÓSTICO =====
+    void benchmarkActionDispatch(uint32_t iterations);
 }
\ No newline at end of file
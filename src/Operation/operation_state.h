@@ -40,10 +40,6 @@ struct OperationState
     bool wsInHandshake = false;
     unsigned long wsHandshakeStartedAt = 0;
 
-    // Hello pendente
-    bool pendingHelloSend = false;
-    unsigned long pendingHelloScheduledAt = 0;
-
     String lastStatus = "STOPPED";
 };
 
@@ -0,0 +1,138 @@
+#include "session_data.h"
+
+namespace
+{
+    // Números negativos ou não inteiros são ignorados, como no parser antigo
+    int readCount(const Json::Token &value)
+    {
+        if (value.type != Json::TOK_NUMBER || value.number < 0)
+        {
+            return -1;
+        }
+        return (int)value.number;
+    }
+}
+
+namespace Operation
+{
+
+    SessionDataParser::SessionDataParser()
+    {
+        _startedAt = micros();
+    }
+
+    SessionDataParser::PendingKey SessionDataParser::classifyKey(const Json::Token &key) const
+    {
+        if (_target)
+        {
+            // Dentro do objeto escolhido só interessam os filhos diretos e remainingTime.total_seconds
+            if (_inRemaining)
+            {
+                return (key.depth == _remainingDepth + 1 && key.text.equals("total_seconds")) ? KEY_TOTAL_SECONDS
+                                                                                               : KEY_NONE;
+            }
+            if (key.depth != _targetDepth + 1)
+            {
+                return KEY_NONE;
+            }
+            if (key.text.equals("remainingTime"))
+                return KEY_REMAINING_TIME;
+            if (key.text.equals("duration"))
+                return KEY_DURATION;
+            if (key.text.equals("initialMinutes"))
+                return KEY_INITIAL_MINUTES;
+            if (key.text.equals("status"))
+                return KEY_STATUS;
+            return KEY_NONE;
+        }
+
+        // Fora dele, "data"/"session_data" em qualquer profundidade, como no parser antigo
+        if (key.text.equals("data"))
+            return KEY_DATA;
+        if (key.text.equals("session_data"))
+            return KEY_SESSION_DATA;
+        return KEY_NONE;
+    }
+
+    void SessionDataParser::feed(const Json::Token &tok)
+    {
+        if (tok.type == Json::TOK_KEY)
+        {
+            _pending = classifyKey(tok);
+            return;
+        }
+
+        PendingKey key = _pending;
+        _pending = KEY_NONE;
+
+        switch (tok.type)
+        {
+        case Json::TOK_OBJECT_START:
+            if ((key == KEY_DATA || key == KEY_SESSION_DATA) && !_fromData.found)
+            {
+                // Primeira ocorrência de cada um vence; "data" encontrado encerra a busca
+                SessionData &target = (key == KEY_DATA) ? _fromData : _fromSessionData;
+                if (!target.found)
+                {
+                    _target = &target;
+                    _targetDepth = tok.depth;
+                }
+            }
+            else if (key == KEY_REMAINING_TIME)
+            {
+                _inRemaining = true;
+                _remainingDepth = tok.depth;
+            }
+            break;
+
+        case Json::TOK_OBJECT_END:
+            if (_inRemaining && tok.depth == _remainingDepth)
+            {
+                _inRemaining = false;
+            }
+            else if (_target && tok.depth == _targetDepth)
+            {
+                _target->found = true;
+                _target = nullptr;
+            }
+            break;
+
+        default:
+            if (!_target)
+            {
+                break;
+            }
+            if (key == KEY_TOTAL_SECONDS)
+                _target->totalSeconds = readCount(tok);
+            else if (key == KEY_DURATION)
+                _target->duration = readCount(tok);
+            else if (key == KEY_INITIAL_MINUTES)
+                _target->initialMinutes = readCount(tok);
+            else if (key == KEY_STATUS && tok.type == Json::TOK_STRING)
+                tok.text.copyTo(_target->status, sizeof(_target->status));
+            break;
+        }
+    }
+
+    bool SessionDataParser::finish(SessionData &out) const
+    {
+        // "data" tem prioridade; "session_data" só se "data" não existir
+        out = _fromData.found ? _fromData : _fromSessionData;
+        out.parseMicros = micros() - _startedAt;
+        return out.found;
+    }
+
+    bool parseSessionData(const uint8_t *payload, size_t length, SessionData &out, Json::Format format)
+    {
+        SessionDataParser parser;
+        Json::Tokenizer tok(payload, length, format);
+        Json::Token token;
+
+        while (tok.next(token))
+        {
+            parser.feed(token);
+        }
+
+        return parser.finish(out);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Arduino.h>
+#include "../Json/json_tokenizer.h"
+
+// ===== DADOS DE SESSÃO RECEBIDOS DO SERVIDOR =====
+struct SessionData
+{
+    int totalSeconds = -1;   // data.remainingTime.total_seconds
+    int duration = -1;       // data.duration (segundos)
+    int initialMinutes = -1; // data.initialMinutes
+    char status[24] = "";    // data.status (truncado se maior)
+    bool found = false;      // true se havia objeto "data" ou "session_data"
+    uint32_t parseMicros = 0;
+
+    // Segundos a aplicar: total_seconds tem prioridade sobre duration
+    int seconds() const
+    {
+        return (totalSeconds >= 0) ? totalSeconds : duration;
+    }
+};
+
+namespace Operation
+{
+    // Parser "push": recebe um token por vez, então serve tanto para o frame
+    // completo quanto para mensagens fragmentadas (Json::StreamTokenizer)
+    class SessionDataParser
+    {
+    public:
+        SessionDataParser();
+
+        void feed(const Json::Token &tok);
+
+        // Resultado final; false se nenhum objeto "data"/"session_data" fechou
+        bool finish(SessionData &out) const;
+
+    private:
+        enum PendingKey : uint8_t
+        {
+            KEY_NONE = 0,
+            KEY_DATA,
+            KEY_SESSION_DATA,
+            KEY_REMAINING_TIME,
+            KEY_TOTAL_SECONDS,
+            KEY_DURATION,
+            KEY_INITIAL_MINUTES,
+            KEY_STATUS
+        };
+
+        PendingKey classifyKey(const Json::Token &key) const;
+
+        SessionData _fromData;
+        SessionData _fromSessionData;
+        SessionData *_target = nullptr; // objeto sendo preenchido
+        uint8_t _targetDepth = 0;
+        uint8_t _remainingDepth = 0;
+        bool _inRemaining = false;
+        PendingKey _pending = KEY_NONE; // chave cujo valor é o próximo token
+        uint32_t _startedAt = 0;
+    };
+
+    // Extrai SessionData em uma única passada sobre o frame, sem alocação.
+    // Prefere o objeto "data"; usa "session_data" apenas se "data" não existir.
+    bool parseSessionData(const uint8_t *payload, size_t length, SessionData &out,
+                          Json::Format format = Json::FORMAT_JSON);
+}
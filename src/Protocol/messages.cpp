@@ -0,0 +1,1228 @@
+// Gerado por tools/gen_protocol.py a partir de protocol/messages.json - não editar.
+
+#include "messages.h"
+#include "../Config/config.h"
+
+namespace
+{
+    // Fragmentos JSON constantes (flash)
+    const char H_STATUS[] PROGMEM = "{\"type\":\"status\",\"carId\":\"" CAR_ID_STR "\"";
+    const char H_ACK[] PROGMEM = "{\"type\":\"ack\",\"carId\":\"" CAR_ID_STR "\"";
+    const char H_NACK[] PROGMEM = "{\"type\":\"nack\",\"carId\":\"" CAR_ID_STR "\"";
+    const char H_BATCH_RESULT[] PROGMEM = "{\"type\":\"batch_result\",\"carId\":\"" CAR_ID_STR "\"";
+    const char H_CAPS_SELECT[] PROGMEM = "{\"type\":\"caps_select\"";
+    const char H_ENCODING[] PROGMEM = "{\"type\":\"encoding\"";
+    const char H_HEARTBEAT_MODE[] PROGMEM = "{\"type\":\"heartbeat_mode\"";
+    const char H_HEARTBEAT_KEYFRAME[] PROGMEM = "{\"type\":\"heartbeat_keyframe\"";
+    const char H_JOURNAL_ACK[] PROGMEM = "{\"type\":\"journal_ack\"";
+    const char H_DISCOVER[] PROGMEM = "{\"type\":\"discover\",\"carId\":\"" CAR_ID_STR "\"";
+    const char H_DISCOVER_REPLY[] PROGMEM = "{\"type\":\"discover_reply\"";
+    const char J_STATUS_STR[] PROGMEM = JSON_KEY_STR("status");
+    const char J_RELAY_ON[] PROGMEM = JSON_KEY("relayOn");
+    const char J_ID[] PROGMEM = JSON_KEY("id");
+    const char J_RESULT_STR[] PROGMEM = JSON_KEY_STR("result");
+    const char J_LATENCY_US[] PROGMEM = JSON_KEY("latencyUs");
+    const char J_DUPLICATE[] PROGMEM = JSON_KEY("duplicate");
+    const char J_OK[] PROGMEM = JSON_KEY("ok");
+    const char J_APPLIED[] PROGMEM = JSON_KEY("applied");
+    const char J_FAILED[] PROGMEM = JSON_KEY("failed");
+    const char J_ERROR_STR[] PROGMEM = JSON_KEY_STR("error");
+    const char J_OPERATION_STATE_STR[] PROGMEM = JSON_KEY_STR("operationState");
+    const char J_HC595[] PROGMEM = JSON_KEY("hc595");
+    const char J_APPLY_US[] PROGMEM = JSON_KEY("applyUs");
+    const char J_PROTO[] PROGMEM = JSON_KEY("proto");
+    const char J_ENC_STR[] PROGMEM = JSON_KEY_STR("enc");
+    const char J_HB_DELTA[] PROGMEM = JSON_KEY("hbDelta");
+    const char J_KEYFRAME_EVERY[] PROGMEM = JSON_KEY("keyframeEvery");
+    const char J_COMPRESS_STR[] PROGMEM = JSON_KEY_STR("compress");
+    const char J_VALUE_STR[] PROGMEM = JSON_KEY_STR("value");
+    const char J_MODE_STR[] PROGMEM = JSON_KEY_STR("mode");
+    const char J_SEQ[] PROGMEM = JSON_KEY("seq");
+    const char J_PORT[] PROGMEM = JSON_KEY("port");
+    const char J_NAME_STR[] PROGMEM = JSON_KEY_STR("name");
+
+    // Chaves e valores MessagePack (mesmos nomes do JSON)
+    const char K_TYPE[] PROGMEM = "type";
+    const char K_CAR_ID[] PROGMEM = "carId";
+    const char K_STATUS[] PROGMEM = "status";
+    const char K_RELAY_ON[] PROGMEM = "relayOn";
+    const char K_ID[] PROGMEM = "id";
+    const char K_RESULT[] PROGMEM = "result";
+    const char K_LATENCY_US[] PROGMEM = "latencyUs";
+    const char K_DUPLICATE[] PROGMEM = "duplicate";
+    const char K_OK[] PROGMEM = "ok";
+    const char K_APPLIED[] PROGMEM = "applied";
+    const char K_FAILED[] PROGMEM = "failed";
+    const char K_ERROR[] PROGMEM = "error";
+    const char K_OPERATION_STATE[] PROGMEM = "operationState";
+    const char K_HC595[] PROGMEM = "hc595";
+    const char K_APPLY_US[] PROGMEM = "applyUs";
+    const char K_PROTO[] PROGMEM = "proto";
+    const char K_ENC[] PROGMEM = "enc";
+    const char K_HB_DELTA[] PROGMEM = "hbDelta";
+    const char K_KEYFRAME_EVERY[] PROGMEM = "keyframeEvery";
+    const char K_COMPRESS[] PROGMEM = "compress";
+    const char K_VALUE[] PROGMEM = "value";
+    const char K_MODE[] PROGMEM = "mode";
+    const char K_SEQ[] PROGMEM = "seq";
+    const char K_PORT[] PROGMEM = "port";
+    const char K_NAME[] PROGMEM = "name";
+    const char V_STATUS[] PROGMEM = "status";
+    const char V_ACK[] PROGMEM = "ack";
+    const char V_NACK[] PROGMEM = "nack";
+    const char V_BATCH_RESULT[] PROGMEM = "batch_result";
+    const char V_CAPS_SELECT[] PROGMEM = "caps_select";
+    const char V_ENCODING[] PROGMEM = "encoding";
+    const char V_HEARTBEAT_MODE[] PROGMEM = "heartbeat_mode";
+    const char V_HEARTBEAT_KEYFRAME[] PROGMEM = "heartbeat_keyframe";
+    const char V_JOURNAL_ACK[] PROGMEM = "journal_ack";
+    const char V_DISCOVER[] PROGMEM = "discover";
+    const char V_DISCOVER_REPLY[] PROGMEM = "discover_reply";
+    const char V_CAR_ID[] PROGMEM = CAR_ID_STR;
+
+    // Pior caso de cada frame da placa (strings sem escapes) cabe no buffer de saída
+    static_assert(Json::literalLength(H_STATUS) +
+                      Json::literalLength(J_STATUS_STR) +
+                      Json::literalLength(J_RELAY_ON) + 30 < WS_TX_BUFFER_SIZE,
+                  "WS_TX_BUFFER_SIZE pequeno para o frame status");
+    static_assert(Json::literalLength(H_ACK) +
+                      Json::literalLength(J_ID) +
+                      Json::literalLength(J_RESULT_STR) +
+                      Json::literalLength(J_LATENCY_US) +
+                      Json::literalLength(J_DUPLICATE) + 51 < WS_TX_BUFFER_SIZE,
+                  "WS_TX_BUFFER_SIZE pequeno para o frame ack");
+    static_assert(Json::literalLength(H_BATCH_RESULT) +
+                      Json::literalLength(J_OK) +
+                      Json::literalLength(J_ID) +
+                      Json::literalLength(J_DUPLICATE) +
+                      Json::literalLength(J_APPLIED) +
+                      Json::literalLength(J_FAILED) +
+                      Json::literalLength(J_ERROR_STR) +
+                      Json::literalLength(J_OPERATION_STATE_STR) +
+                      Json::literalLength(J_RELAY_ON) +
+                      Json::literalLength(J_HC595) +
+                      Json::literalLength(J_APPLY_US) +
+                      Json::literalLength(J_LATENCY_US) + 119 < WS_TX_BUFFER_SIZE,
+                  "WS_TX_BUFFER_SIZE pequeno para o frame batch_result");
+    static_assert(Json::literalLength(H_DISCOVER) +
+                      Json::literalLength(J_PROTO) + 11 < WS_TX_BUFFER_SIZE,
+                  "WS_TX_BUFFER_SIZE pequeno para o frame discover");
+
+    bool readString(const Json::Token &value, size_t max, Json::Slice &out)
+    {
+        if (value.type != Json::TOK_STRING || value.text.len > max)
+        {
+            return false;
+        }
+        out = value.text;
+        return true;
+    }
+
+    bool readInt(const Json::Token &value, long &out)
+    {
+        if (value.type != Json::TOK_NUMBER)
+        {
+            return false;
+        }
+        out = value.number;
+        return true;
+    }
+
+    bool readUint(const Json::Token &value, uint32_t &out)
+    {
+        if (value.type != Json::TOK_NUMBER || value.number < 0)
+        {
+            return false;
+        }
+        out = (uint32_t)value.number;
+        return true;
+    }
+
+    bool readBool(const Json::Token &value, bool &out)
+    {
+        if (value.type != Json::TOK_TRUE && value.type != Json::TOK_FALSE)
+        {
+            return false;
+        }
+        out = (value.type == Json::TOK_TRUE);
+        return true;
+    }
+
+    bool sameText(const Json::Slice &a, const Json::Slice &b)
+    {
+        return a.len == b.len && memcmp(a.ptr, b.ptr, a.len) == 0;
+    }
+
+    bool same(const Protocol::StatusMsg &a, const Protocol::StatusMsg &b)
+    {
+        return sameText(a.status, b.status)
+               && a.relayOn == b.relayOn;
+    }
+
+    bool same(const Protocol::AckMsg &a, const Protocol::AckMsg &b)
+    {
+        return a.id == b.id
+               && sameText(a.result, b.result)
+               && a.latencyUs == b.latencyUs
+               && a.hasDuplicate == b.hasDuplicate && (!a.hasDuplicate || a.duplicate == b.duplicate);
+    }
+
+    bool same(const Protocol::BatchResultMsg &a, const Protocol::BatchResultMsg &b)
+    {
+        return a.ok == b.ok
+               && a.hasId == b.hasId && (!a.hasId || a.id == b.id)
+               && a.hasDuplicate == b.hasDuplicate && (!a.hasDuplicate || a.duplicate == b.duplicate)
+               && a.applied == b.applied
+               && a.hasFailed == b.hasFailed && (!a.hasFailed || a.failed == b.failed)
+               && a.hasError == b.hasError && (!a.hasError || sameText(a.error, b.error))
+               && sameText(a.operationState, b.operationState)
+               && a.relayOn == b.relayOn
+               && a.hc595 == b.hc595
+               && a.applyUs == b.applyUs
+               && a.latencyUs == b.latencyUs;
+    }
+
+    bool same(const Protocol::CapsSelectMsg &a, const Protocol::CapsSelectMsg &b)
+    {
+        return a.hasProto == b.hasProto && (!a.hasProto || a.proto == b.proto)
+               && a.hasEnc == b.hasEnc && (!a.hasEnc || sameText(a.enc, b.enc))
+               && a.hasHbDelta == b.hasHbDelta && (!a.hasHbDelta || a.hbDelta == b.hbDelta)
+               && a.hasKeyframeEvery == b.hasKeyframeEvery && (!a.hasKeyframeEvery || a.keyframeEvery == b.keyframeEvery)
+               && a.hasCompress == b.hasCompress && (!a.hasCompress || sameText(a.compress, b.compress));
+    }
+
+    bool same(const Protocol::EncodingMsg &a, const Protocol::EncodingMsg &b)
+    {
+        return sameText(a.value, b.value);
+    }
+
+    bool same(const Protocol::HeartbeatModeMsg &a, const Protocol::HeartbeatModeMsg &b)
+    {
+        return a.hasMode == b.hasMode && (!a.hasMode || sameText(a.mode, b.mode))
+               && a.hasKeyframeEvery == b.hasKeyframeEvery && (!a.hasKeyframeEvery || a.keyframeEvery == b.keyframeEvery);
+    }
+
+    bool same(const Protocol::HeartbeatKeyframeMsg &a, const Protocol::HeartbeatKeyframeMsg &b)
+    {
+        (void)a;
+        (void)b;
+        return true;
+    }
+
+    bool same(const Protocol::JournalAckMsg &a, const Protocol::JournalAckMsg &b)
+    {
+        return a.seq == b.seq;
+    }
+
+    bool same(const Protocol::DiscoverMsg &a, const Protocol::DiscoverMsg &b)
+    {
+        return a.proto == b.proto;
+    }
+
+    bool same(const Protocol::DiscoverReplyMsg &a, const Protocol::DiscoverReplyMsg &b)
+    {
+        return a.port == b.port
+               && a.hasName == b.hasName && (!a.hasName || sameText(a.name, b.name));
+    }
+
+    template <typename Msg>
+    void benchmarkMessage(const char *name, const Msg &sample, uint32_t iterations,
+                          bool (*encodeJson)(const Msg &, Json::Writer &),
+                          bool (*encodeMsgPack)(const Msg &, MsgPack::Writer &),
+                          bool (*decode)(const uint8_t *, size_t, Json::Format, Msg &))
+    {
+        // Na pilha: static seria um buffer permanente por instanciação do template
+        uint8_t buffer[WS_TX_BUFFER_SIZE];
+
+        for (uint8_t f = 0; f < 2; f++)
+        {
+            const Json::Format format = f ? Json::FORMAT_MSGPACK : Json::FORMAT_JSON;
+            size_t length = 0;
+            bool ok = true;
+
+            uint32_t started = ESP.getCycleCount();
+            for (uint32_t n = 0; n < iterations; n++)
+            {
+                if (format == Json::FORMAT_MSGPACK)
+                {
+                    MsgPack::Writer out(buffer, sizeof(buffer));
+                    ok = encodeMsgPack(sample, out) && ok;
+                    length = out.length();
+                }
+                else
+                {
+                    Json::Writer json(reinterpret_cast<char *>(buffer), sizeof(buffer));
+                    ok = encodeJson(sample, json) && ok;
+                    length = json.length();
+                }
+            }
+            uint32_t encodeCycles = ESP.getCycleCount() - started;
+
+            Msg decoded;
+            started = ESP.getCycleCount();
+            for (uint32_t n = 0; n < iterations; n++)
+            {
+                ok = decode(buffer, length, format, decoded) && ok;
+            }
+            uint32_t decodeCycles = ESP.getCycleCount() - started;
+            ok = ok && same(sample, decoded);
+
+            Serial.printf("[BENCH] %-18s %-7s %3u B  enc %5lu  dec %5lu ciclos  %s\n", name,
+                          format == Json::FORMAT_MSGPACK ? "msgpack" : "json", (unsigned)length,
+                          (unsigned long)(encodeCycles / iterations), (unsigned long)(decodeCycles / iterations),
+                          ok ? "ok" : "DIVERGIU");
+        }
+    }
+}
+
+namespace Protocol
+{
+    // ===== status =====
+    bool encodeStatus(const StatusMsg &msg, Json::Writer &json)
+    {
+        json.raw(H_STATUS);
+        json.raw(J_STATUS_STR).str(msg.status.ptr, msg.status.len).put('"');
+        json.raw(J_RELAY_ON).boolean(msg.relayOn);
+        json.put('}');
+        return !json.overflowed();
+    }
+
+    bool encodeStatus(const StatusMsg &msg, MsgPack::Writer &out)
+    {
+        out.map(4);
+        out.key(K_TYPE).key(V_STATUS);
+        out.key(K_CAR_ID).key(V_CAR_ID);
+        out.key(K_STATUS).str(msg.status.ptr, msg.status.len);
+        out.key(K_RELAY_ON).boolean(msg.relayOn);
+        return !out.overflowed();
+    }
+
+    bool decodeStatus(const uint8_t *payload, size_t length, Json::Format format, StatusMsg &msg)
+    {
+        msg = StatusMsg();
+        bool seenStatus = false;
+        bool seenRelayOn = false;
+
+        Json::Tokenizer tok(payload, length, format);
+        Json::Token key;
+        while (tok.next(key))
+        {
+            if (key.type != Json::TOK_KEY || key.depth != 1)
+            {
+                continue;
+            }
+
+            Json::Token value;
+            if (!tok.next(value))
+            {
+                return false;
+            }
+            if (key.text.equals("status"))
+            {
+                if (!readString(value, StatusMsg::STATUS_MAX, msg.status))
+                {
+                    return false;
+                }
+                seenStatus = true;
+            }
+            else if (key.text.equals("relayOn"))
+            {
+                if (!readBool(value, msg.relayOn))
+                {
+                    return false;
+                }
+                seenRelayOn = true;
+            }
+        }
+
+        return key.type == Json::TOK_END && seenStatus && seenRelayOn;
+    }
+
+    // ===== ack =====
+    bool encodeAck(const AckMsg &msg, Json::Writer &json)
+    {
+        json.raw(H_ACK);
+        json.raw(J_ID).number((unsigned long)msg.id);
+        json.raw(J_RESULT_STR).str(msg.result.ptr, msg.result.len).put('"');
+        json.raw(J_LATENCY_US).number((unsigned long)msg.latencyUs);
+        if (msg.hasDuplicate)
+        {
+            json.raw(J_DUPLICATE).boolean(msg.duplicate);
+        }
+        json.put('}');
+        return !json.overflowed();
+    }
+
+    bool encodeAck(const AckMsg &msg, MsgPack::Writer &out)
+    {
+        out.map(5 + (msg.hasDuplicate ? 1 : 0));
+        out.key(K_TYPE).key(V_ACK);
+        out.key(K_CAR_ID).key(V_CAR_ID);
+        out.key(K_ID).number((unsigned long)msg.id);
+        out.key(K_RESULT).str(msg.result.ptr, msg.result.len);
+        out.key(K_LATENCY_US).number((unsigned long)msg.latencyUs);
+        if (msg.hasDuplicate)
+        {
+            out.key(K_DUPLICATE).boolean(msg.duplicate);
+        }
+        return !out.overflowed();
+    }
+
+    bool decodeAck(const uint8_t *payload, size_t length, Json::Format format, AckMsg &msg)
+    {
+        msg = AckMsg();
+        bool seenId = false;
+        bool seenResult = false;
+        bool seenLatencyUs = false;
+
+        Json::Tokenizer tok(payload, length, format);
+        Json::Token key;
+        while (tok.next(key))
+        {
+            if (key.type != Json::TOK_KEY || key.depth != 1)
+            {
+                continue;
+            }
+
+            Json::Token value;
+            if (!tok.next(value))
+            {
+                return false;
+            }
+            if (key.text.equals("id"))
+            {
+                if (!readUint(value, msg.id))
+                {
+                    return false;
+                }
+                seenId = true;
+            }
+            else if (key.text.equals("result"))
+            {
+                if (!readString(value, AckMsg::RESULT_MAX, msg.result))
+                {
+                    return false;
+                }
+                seenResult = true;
+            }
+            else if (key.text.equals("latencyUs"))
+            {
+                if (!readUint(value, msg.latencyUs))
+                {
+                    return false;
+                }
+                seenLatencyUs = true;
+            }
+            else if (key.text.equals("duplicate"))
+            {
+                if (!readBool(value, msg.duplicate))
+                {
+                    return false;
+                }
+                msg.hasDuplicate = true;
+            }
+        }
+
+        return key.type == Json::TOK_END && seenId && seenResult && seenLatencyUs;
+    }
+
+    // ===== nack =====
+    bool encodeNack(const AckMsg &msg, Json::Writer &json)
+    {
+        json.raw(H_NACK);
+        json.raw(J_ID).number((unsigned long)msg.id);
+        json.raw(J_RESULT_STR).str(msg.result.ptr, msg.result.len).put('"');
+        json.raw(J_LATENCY_US).number((unsigned long)msg.latencyUs);
+        if (msg.hasDuplicate)
+        {
+            json.raw(J_DUPLICATE).boolean(msg.duplicate);
+        }
+        json.put('}');
+        return !json.overflowed();
+    }
+
+    bool encodeNack(const AckMsg &msg, MsgPack::Writer &out)
+    {
+        out.map(5 + (msg.hasDuplicate ? 1 : 0));
+        out.key(K_TYPE).key(V_NACK);
+        out.key(K_CAR_ID).key(V_CAR_ID);
+        out.key(K_ID).number((unsigned long)msg.id);
+        out.key(K_RESULT).str(msg.result.ptr, msg.result.len);
+        out.key(K_LATENCY_US).number((unsigned long)msg.latencyUs);
+        if (msg.hasDuplicate)
+        {
+            out.key(K_DUPLICATE).boolean(msg.duplicate);
+        }
+        return !out.overflowed();
+    }
+
+    bool decodeNack(const uint8_t *payload, size_t length, Json::Format format, AckMsg &msg)
+    {
+        msg = AckMsg();
+        bool seenId = false;
+        bool seenResult = false;
+        bool seenLatencyUs = false;
+
+        Json::Tokenizer tok(payload, length, format);
+        Json::Token key;
+        while (tok.next(key))
+        {
+            if (key.type != Json::TOK_KEY || key.depth != 1)
+            {
+                continue;
+            }
+
+            Json::Token value;
+            if (!tok.next(value))
+            {
+                return false;
+            }
+            if (key.text.equals("id"))
+            {
+                if (!readUint(value, msg.id))
+                {
+                    return false;
+                }
+                seenId = true;
+            }
+            else if (key.text.equals("result"))
+            {
+                if (!readString(value, AckMsg::RESULT_MAX, msg.result))
+                {
+                    return false;
+                }
+                seenResult = true;
+            }
+            else if (key.text.equals("latencyUs"))
+            {
+                if (!readUint(value, msg.latencyUs))
+                {
+                    return false;
+                }
+                seenLatencyUs = true;
+            }
+            else if (key.text.equals("duplicate"))
+            {
+                if (!readBool(value, msg.duplicate))
+                {
+                    return false;
+                }
+                msg.hasDuplicate = true;
+            }
+        }
+
+        return key.type == Json::TOK_END && seenId && seenResult && seenLatencyUs;
+    }
+
+    // ===== batch_result =====
+    bool encodeBatchResult(const BatchResultMsg &msg, Json::Writer &json)
+    {
+        json.raw(H_BATCH_RESULT);
+        json.raw(J_OK).boolean(msg.ok);
+        if (msg.hasId)
+        {
+            json.raw(J_ID).number((unsigned long)msg.id);
+        }
+        if (msg.hasDuplicate)
+        {
+            json.raw(J_DUPLICATE).boolean(msg.duplicate);
+        }
+        json.raw(J_APPLIED).number((unsigned long)msg.applied);
+        if (msg.hasFailed)
+        {
+            json.raw(J_FAILED).number(msg.failed);
+        }
+        if (msg.hasError)
+        {
+            json.raw(J_ERROR_STR).str(msg.error.ptr, msg.error.len).put('"');
+        }
+        json.raw(J_OPERATION_STATE_STR).str(msg.operationState.ptr, msg.operationState.len).put('"');
+        json.raw(J_RELAY_ON).boolean(msg.relayOn);
+        json.raw(J_HC595).number((unsigned long)msg.hc595);
+        json.raw(J_APPLY_US).number((unsigned long)msg.applyUs);
+        json.raw(J_LATENCY_US).number((unsigned long)msg.latencyUs);
+        json.put('}');
+        return !json.overflowed();
+    }
+
+    bool encodeBatchResult(const BatchResultMsg &msg, MsgPack::Writer &out)
+    {
+        out.map(9 + (msg.hasId ? 1 : 0) + (msg.hasDuplicate ? 1 : 0) + (msg.hasFailed ? 1 : 0) + (msg.hasError ? 1 : 0));
+        out.key(K_TYPE).key(V_BATCH_RESULT);
+        out.key(K_CAR_ID).key(V_CAR_ID);
+        out.key(K_OK).boolean(msg.ok);
+        if (msg.hasId)
+        {
+            out.key(K_ID).number((unsigned long)msg.id);
+        }
+        if (msg.hasDuplicate)
+        {
+            out.key(K_DUPLICATE).boolean(msg.duplicate);
+        }
+        out.key(K_APPLIED).number((unsigned long)msg.applied);
+        if (msg.hasFailed)
+        {
+            out.key(K_FAILED).number(msg.failed);
+        }
+        if (msg.hasError)
+        {
+            out.key(K_ERROR).str(msg.error.ptr, msg.error.len);
+        }
+        out.key(K_OPERATION_STATE).str(msg.operationState.ptr, msg.operationState.len);
+        out.key(K_RELAY_ON).boolean(msg.relayOn);
+        out.key(K_HC595).number((unsigned long)msg.hc595);
+        out.key(K_APPLY_US).number((unsigned long)msg.applyUs);
+        out.key(K_LATENCY_US).number((unsigned long)msg.latencyUs);
+        return !out.overflowed();
+    }
+
+    bool decodeBatchResult(const uint8_t *payload, size_t length, Json::Format format, BatchResultMsg &msg)
+    {
+        msg = BatchResultMsg();
+        bool seenOk = false;
+        bool seenApplied = false;
+        bool seenOperationState = false;
+        bool seenRelayOn = false;
+        bool seenHc595 = false;
+        bool seenApplyUs = false;
+        bool seenLatencyUs = false;
+
+        Json::Tokenizer tok(payload, length, format);
+        Json::Token key;
+        while (tok.next(key))
+        {
+            if (key.type != Json::TOK_KEY || key.depth != 1)
+            {
+                continue;
+            }
+
+            Json::Token value;
+            if (!tok.next(value))
+            {
+                return false;
+            }
+            if (key.text.equals("ok"))
+            {
+                if (!readBool(value, msg.ok))
+                {
+                    return false;
+                }
+                seenOk = true;
+            }
+            else if (key.text.equals("id"))
+            {
+                if (!readUint(value, msg.id))
+                {
+                    return false;
+                }
+                msg.hasId = true;
+            }
+            else if (key.text.equals("duplicate"))
+            {
+                if (!readBool(value, msg.duplicate))
+                {
+                    return false;
+                }
+                msg.hasDuplicate = true;
+            }
+            else if (key.text.equals("applied"))
+            {
+                if (!readUint(value, msg.applied))
+                {
+                    return false;
+                }
+                seenApplied = true;
+            }
+            else if (key.text.equals("failed"))
+            {
+                if (!readInt(value, msg.failed))
+                {
+                    return false;
+                }
+                msg.hasFailed = true;
+            }
+            else if (key.text.equals("error"))
+            {
+                if (!readString(value, BatchResultMsg::ERROR_MAX, msg.error))
+                {
+                    return false;
+                }
+                msg.hasError = true;
+            }
+            else if (key.text.equals("operationState"))
+            {
+                if (!readString(value, BatchResultMsg::OPERATION_STATE_MAX, msg.operationState))
+                {
+                    return false;
+                }
+                seenOperationState = true;
+            }
+            else if (key.text.equals("relayOn"))
+            {
+                if (!readBool(value, msg.relayOn))
+                {
+                    return false;
+                }
+                seenRelayOn = true;
+            }
+            else if (key.text.equals("hc595"))
+            {
+                if (!readUint(value, msg.hc595))
+                {
+                    return false;
+                }
+                seenHc595 = true;
+            }
+            else if (key.text.equals("applyUs"))
+            {
+                if (!readUint(value, msg.applyUs))
+                {
+                    return false;
+                }
+                seenApplyUs = true;
+            }
+            else if (key.text.equals("latencyUs"))
+            {
+                if (!readUint(value, msg.latencyUs))
+                {
+                    return false;
+                }
+                seenLatencyUs = true;
+            }
+        }
+
+        return key.type == Json::TOK_END && seenOk && seenApplied && seenOperationState && seenRelayOn && seenHc595 && seenApplyUs && seenLatencyUs;
+    }
+
+    // ===== caps_select =====
+    bool encodeCapsSelect(const CapsSelectMsg &msg, Json::Writer &json)
+    {
+        json.raw(H_CAPS_SELECT);
+        if (msg.hasProto)
+        {
+            json.raw(J_PROTO).number(msg.proto);
+        }
+        if (msg.hasEnc)
+        {
+            json.raw(J_ENC_STR).str(msg.enc.ptr, msg.enc.len).put('"');
+        }
+        if (msg.hasHbDelta)
+        {
+            json.raw(J_HB_DELTA).boolean(msg.hbDelta);
+        }
+        if (msg.hasKeyframeEvery)
+        {
+            json.raw(J_KEYFRAME_EVERY).number(msg.keyframeEvery);
+        }
+        if (msg.hasCompress)
+        {
+            json.raw(J_COMPRESS_STR).str(msg.compress.ptr, msg.compress.len).put('"');
+        }
+        json.put('}');
+        return !json.overflowed();
+    }
+
+    bool encodeCapsSelect(const CapsSelectMsg &msg, MsgPack::Writer &out)
+    {
+        out.map(1 + (msg.hasProto ? 1 : 0) + (msg.hasEnc ? 1 : 0) + (msg.hasHbDelta ? 1 : 0) + (msg.hasKeyframeEvery ? 1 : 0) + (msg.hasCompress ? 1 : 0));
+        out.key(K_TYPE).key(V_CAPS_SELECT);
+        if (msg.hasProto)
+        {
+            out.key(K_PROTO).number(msg.proto);
+        }
+        if (msg.hasEnc)
+        {
+            out.key(K_ENC).str(msg.enc.ptr, msg.enc.len);
+        }
+        if (msg.hasHbDelta)
+        {
+            out.key(K_HB_DELTA).boolean(msg.hbDelta);
+        }
+        if (msg.hasKeyframeEvery)
+        {
+            out.key(K_KEYFRAME_EVERY).number(msg.keyframeEvery);
+        }
+        if (msg.hasCompress)
+        {
+            out.key(K_COMPRESS).str(msg.compress.ptr, msg.compress.len);
+        }
+        return !out.overflowed();
+    }
+
+    bool decodeCapsSelect(const uint8_t *payload, size_t length, Json::Format format, CapsSelectMsg &msg)
+    {
+        msg = CapsSelectMsg();
+
+        Json::Tokenizer tok(payload, length, format);
+        Json::Token key;
+        while (tok.next(key))
+        {
+            if (key.type != Json::TOK_KEY || key.depth != 1)
+            {
+                continue;
+            }
+
+            Json::Token value;
+            if (!tok.next(value))
+            {
+                return false;
+            }
+            if (key.text.equals("proto"))
+            {
+                if (!readInt(value, msg.proto))
+                {
+                    return false;
+                }
+                msg.hasProto = true;
+            }
+            else if (key.text.equals("enc"))
+            {
+                if (!readString(value, CapsSelectMsg::ENC_MAX, msg.enc))
+                {
+                    return false;
+                }
+                msg.hasEnc = true;
+            }
+            else if (key.text.equals("hbDelta"))
+            {
+                if (!readBool(value, msg.hbDelta))
+                {
+                    return false;
+                }
+                msg.hasHbDelta = true;
+            }
+            else if (key.text.equals("keyframeEvery"))
+            {
+                if (!readInt(value, msg.keyframeEvery))
+                {
+                    return false;
+                }
+                msg.hasKeyframeEvery = true;
+            }
+            else if (key.text.equals("compress"))
+            {
+                if (!readString(value, CapsSelectMsg::COMPRESS_MAX, msg.compress))
+                {
+                    return false;
+                }
+                msg.hasCompress = true;
+            }
+        }
+
+        return key.type == Json::TOK_END;
+    }
+
+    // ===== encoding =====
+    bool encodeEncoding(const EncodingMsg &msg, Json::Writer &json)
+    {
+        json.raw(H_ENCODING);
+        json.raw(J_VALUE_STR).str(msg.value.ptr, msg.value.len).put('"');
+        json.put('}');
+        return !json.overflowed();
+    }
+
+    bool encodeEncoding(const EncodingMsg &msg, MsgPack::Writer &out)
+    {
+        out.map(2);
+        out.key(K_TYPE).key(V_ENCODING);
+        out.key(K_VALUE).str(msg.value.ptr, msg.value.len);
+        return !out.overflowed();
+    }
+
+    bool decodeEncoding(const uint8_t *payload, size_t length, Json::Format format, EncodingMsg &msg)
+    {
+        msg = EncodingMsg();
+        bool seenValue = false;
+
+        Json::Tokenizer tok(payload, length, format);
+        Json::Token key;
+        while (tok.next(key))
+        {
+            if (key.type != Json::TOK_KEY || key.depth != 1)
+            {
+                continue;
+            }
+
+            Json::Token value;
+            if (!tok.next(value))
+            {
+                return false;
+            }
+            if (key.text.equals("value"))
+            {
+                if (!readString(value, EncodingMsg::VALUE_MAX, msg.value))
+                {
+                    return false;
+                }
+                seenValue = true;
+            }
+        }
+
+        return key.type == Json::TOK_END && seenValue;
+    }
+
+    // ===== heartbeat_mode =====
+    bool encodeHeartbeatMode(const HeartbeatModeMsg &msg, Json::Writer &json)
+    {
+        json.raw(H_HEARTBEAT_MODE);
+        if (msg.hasMode)
+        {
+            json.raw(J_MODE_STR).str(msg.mode.ptr, msg.mode.len).put('"');
+        }
+        if (msg.hasKeyframeEvery)
+        {
+            json.raw(J_KEYFRAME_EVERY).number(msg.keyframeEvery);
+        }
+        json.put('}');
+        return !json.overflowed();
+    }
+
+    bool encodeHeartbeatMode(const HeartbeatModeMsg &msg, MsgPack::Writer &out)
+    {
+        out.map(1 + (msg.hasMode ? 1 : 0) + (msg.hasKeyframeEvery ? 1 : 0));
+        out.key(K_TYPE).key(V_HEARTBEAT_MODE);
+        if (msg.hasMode)
+        {
+            out.key(K_MODE).str(msg.mode.ptr, msg.mode.len);
+        }
+        if (msg.hasKeyframeEvery)
+        {
+            out.key(K_KEYFRAME_EVERY).number(msg.keyframeEvery);
+        }
+        return !out.overflowed();
+    }
+
+    bool decodeHeartbeatMode(const uint8_t *payload, size_t length, Json::Format format, HeartbeatModeMsg &msg)
+    {
+        msg = HeartbeatModeMsg();
+
+        Json::Tokenizer tok(payload, length, format);
+        Json::Token key;
+        while (tok.next(key))
+        {
+            if (key.type != Json::TOK_KEY || key.depth != 1)
+            {
+                continue;
+            }
+
+            Json::Token value;
+            if (!tok.next(value))
+            {
+                return false;
+            }
+            if (key.text.equals("mode"))
+            {
+                if (!readString(value, HeartbeatModeMsg::MODE_MAX, msg.mode))
+                {
+                    return false;
+                }
+                msg.hasMode = true;
+            }
+            else if (key.text.equals("keyframeEvery"))
+            {
+                if (!readInt(value, msg.keyframeEvery))
+                {
+                    return false;
+                }
+                msg.hasKeyframeEvery = true;
+            }
+        }
+
+        return key.type == Json::TOK_END;
+    }
+
+    // ===== heartbeat_keyframe =====
+    bool encodeHeartbeatKeyframe(const HeartbeatKeyframeMsg &msg, Json::Writer &json)
+    {
+        (void)msg;
+        json.raw(H_HEARTBEAT_KEYFRAME);
+        json.put('}');
+        return !json.overflowed();
+    }
+
+    bool encodeHeartbeatKeyframe(const HeartbeatKeyframeMsg &msg, MsgPack::Writer &out)
+    {
+        (void)msg;
+        out.map(1);
+        out.key(K_TYPE).key(V_HEARTBEAT_KEYFRAME);
+        return !out.overflowed();
+    }
+
+    bool decodeHeartbeatKeyframe(const uint8_t *payload, size_t length, Json::Format format, HeartbeatKeyframeMsg &msg)
+    {
+        msg = HeartbeatKeyframeMsg();
+
+        Json::Tokenizer tok(payload, length, format);
+        Json::Token key;
+        while (tok.next(key))
+        {
+            if (key.type != Json::TOK_KEY || key.depth != 1)
+            {
+                continue;
+            }
+
+            Json::Token value;
+            if (!tok.next(value))
+            {
+                return false;
+            }
+            (void)msg;
+        }
+
+        return key.type == Json::TOK_END;
+    }
+
+    // ===== journal_ack =====
+    bool encodeJournalAck(const JournalAckMsg &msg, Json::Writer &json)
+    {
+        json.raw(H_JOURNAL_ACK);
+        json.raw(J_SEQ).number((unsigned long)msg.seq);
+        json.put('}');
+        return !json.overflowed();
+    }
+
+    bool encodeJournalAck(const JournalAckMsg &msg, MsgPack::Writer &out)
+    {
+        out.map(2);
+        out.key(K_TYPE).key(V_JOURNAL_ACK);
+        out.key(K_SEQ).number((unsigned long)msg.seq);
+        return !out.overflowed();
+    }
+
+    bool decodeJournalAck(const uint8_t *payload, size_t length, Json::Format format, JournalAckMsg &msg)
+    {
+        msg = JournalAckMsg();
+        bool seenSeq = false;
+
+        Json::Tokenizer tok(payload, length, format);
+        Json::Token key;
+        while (tok.next(key))
+        {
+            if (key.type != Json::TOK_KEY || key.depth != 1)
+            {
+                continue;
+            }
+
+            Json::Token value;
+            if (!tok.next(value))
+            {
+                return false;
+            }
+            if (key.text.equals("seq"))
+            {
+                if (!readUint(value, msg.seq))
+                {
+                    return false;
+                }
+                seenSeq = true;
+            }
+        }
+
+        return key.type == Json::TOK_END && seenSeq;
+    }
+
+    // ===== discover =====
+    bool encodeDiscover(const DiscoverMsg &msg, Json::Writer &json)
+    {
+        json.raw(H_DISCOVER);
+        json.raw(J_PROTO).number((unsigned long)msg.proto);
+        json.put('}');
+        return !json.overflowed();
+    }
+
+    bool encodeDiscover(const DiscoverMsg &msg, MsgPack::Writer &out)
+    {
+        out.map(3);
+        out.key(K_TYPE).key(V_DISCOVER);
+        out.key(K_CAR_ID).key(V_CAR_ID);
+        out.key(K_PROTO).number((unsigned long)msg.proto);
+        return !out.overflowed();
+    }
+
+    bool decodeDiscover(const uint8_t *payload, size_t length, Json::Format format, DiscoverMsg &msg)
+    {
+        msg = DiscoverMsg();
+        bool seenProto = false;
+
+        Json::Tokenizer tok(payload, length, format);
+        Json::Token key;
+        while (tok.next(key))
+        {
+            if (key.type != Json::TOK_KEY || key.depth != 1)
+            {
+                continue;
+            }
+
+            Json::Token value;
+            if (!tok.next(value))
+            {
+                return false;
+            }
+            if (key.text.equals("proto"))
+            {
+                if (!readUint(value, msg.proto))
+                {
+                    return false;
+                }
+                seenProto = true;
+            }
+        }
+
+        return key.type == Json::TOK_END && seenProto;
+    }
+
+    // ===== discover_reply =====
+    bool encodeDiscoverReply(const DiscoverReplyMsg &msg, Json::Writer &json)
+    {
+        json.raw(H_DISCOVER_REPLY);
+        json.raw(J_PORT).number((unsigned long)msg.port);
+        if (msg.hasName)
+        {
+            json.raw(J_NAME_STR).str(msg.name.ptr, msg.name.len).put('"');
+        }
+        json.put('}');
+        return !json.overflowed();
+    }
+
+    bool encodeDiscoverReply(const DiscoverReplyMsg &msg, MsgPack::Writer &out)
+    {
+        out.map(2 + (msg.hasName ? 1 : 0));
+        out.key(K_TYPE).key(V_DISCOVER_REPLY);
+        out.key(K_PORT).number((unsigned long)msg.port);
+        if (msg.hasName)
+        {
+            out.key(K_NAME).str(msg.name.ptr, msg.name.len);
+        }
+        return !out.overflowed();
+    }
+
+    bool decodeDiscoverReply(const uint8_t *payload, size_t length, Json::Format format, DiscoverReplyMsg &msg)
+    {
+        msg = DiscoverReplyMsg();
+        bool seenPort = false;
+
+        Json::Tokenizer tok(payload, length, format);
+        Json::Token key;
+        while (tok.next(key))
+        {
+            if (key.type != Json::TOK_KEY || key.depth != 1)
+            {
+                continue;
+            }
+
+            Json::Token value;
+            if (!tok.next(value))
+            {
+                return false;
+            }
+            if (key.text.equals("port"))
+            {
+                if (!readUint(value, msg.port))
+                {
+                    return false;
+                }
+                seenPort = true;
+            }
+            else if (key.text.equals("name"))
+            {
+                if (!readString(value, DiscoverReplyMsg::NAME_MAX, msg.name))
+                {
+                    return false;
+                }
+                msg.hasName = true;
+            }
+        }
+
+        return key.type == Json::TOK_END && seenPort;
+    }
+
+    void benchmarkRoundTrip(uint32_t iterations)
+    {
+        if (iterations == 0)
+        {
+            return;
+        }
+        Serial.printf("[BENCH] Codecs do protocolo (esquema v%u, %lu iterações)\n",
+                      (unsigned)SCHEMA_VERSION, (unsigned long)iterations);
+
+        StatusMsg status;
+        status.status = text("running");
+        status.relayOn = true;
+        benchmarkMessage<StatusMsg>("status", status, iterations, encodeStatus, encodeStatus, decodeStatus);
+
+        AckMsg ack;
+        ack.id = 123456789;
+        ack.result = text("ok");
+        ack.latencyUs = 812;
+        ack.duplicate = true;
+        ack.hasDuplicate = true;
+        benchmarkMessage<AckMsg>("ack", ack, iterations, encodeAck, encodeAck, decodeAck);
+
+        AckMsg nack;
+        nack.id = 123456789;
+        nack.result = text("ok");
+        nack.latencyUs = 812;
+        nack.duplicate = true;
+        nack.hasDuplicate = true;
+        benchmarkMessage<AckMsg>("nack", nack, iterations, encodeNack, encodeNack, decodeNack);
+
+        BatchResultMsg batchResult;
+        batchResult.ok = false;
+        batchResult.id = 42;
+        batchResult.hasId = true;
+        batchResult.duplicate = true;
+        batchResult.hasDuplicate = true;
+        batchResult.applied = 0;
+        batchResult.failed = 1;
+        batchResult.hasFailed = true;
+        batchResult.error = text("invalid_argument");
+        batchResult.hasError = true;
+        batchResult.operationState = text("ACTIVE");
+        batchResult.relayOn = true;
+        batchResult.hc595 = 255;
+        batchResult.applyUs = 140;
+        batchResult.latencyUs = 960;
+        benchmarkMessage<BatchResultMsg>("batch_result", batchResult, iterations, encodeBatchResult, encodeBatchResult, decodeBatchResult);
+
+        CapsSelectMsg capsSelect;
+        capsSelect.proto = 1;
+        capsSelect.hasProto = true;
+        capsSelect.enc = text("msgpack");
+        capsSelect.hasEnc = true;
+        capsSelect.hbDelta = true;
+        capsSelect.hasHbDelta = true;
+        capsSelect.keyframeEvery = 12;
+        capsSelect.hasKeyframeEvery = true;
+        capsSelect.compress = text("lzss");
+        capsSelect.hasCompress = true;
+        benchmarkMessage<CapsSelectMsg>("caps_select", capsSelect, iterations, encodeCapsSelect, encodeCapsSelect, decodeCapsSelect);
+
+        EncodingMsg encoding;
+        encoding.value = text("msgpack");
+        benchmarkMessage<EncodingMsg>("encoding", encoding, iterations, encodeEncoding, encodeEncoding, decodeEncoding);
+
+        HeartbeatModeMsg heartbeatMode;
+        heartbeatMode.mode = text("delta");
+        heartbeatMode.hasMode = true;
+        heartbeatMode.keyframeEvery = 12;
+        heartbeatMode.hasKeyframeEvery = true;
+        benchmarkMessage<HeartbeatModeMsg>("heartbeat_mode", heartbeatMode, iterations, encodeHeartbeatMode, encodeHeartbeatMode, decodeHeartbeatMode);
+
+        HeartbeatKeyframeMsg heartbeatKeyframe;
+        benchmarkMessage<HeartbeatKeyframeMsg>("heartbeat_keyframe", heartbeatKeyframe, iterations, encodeHeartbeatKeyframe, encodeHeartbeatKeyframe, decodeHeartbeatKeyframe);
+
+        JournalAckMsg journalAck;
+        journalAck.seq = 17;
+        benchmarkMessage<JournalAckMsg>("journal_ack", journalAck, iterations, encodeJournalAck, encodeJournalAck, decodeJournalAck);
+
+        DiscoverMsg discover;
+        discover.proto = 1;
+        benchmarkMessage<DiscoverMsg>("discover", discover, iterations, encodeDiscover, encodeDiscover, decodeDiscover);
+
+        DiscoverReplyMsg discoverReply;
+        discoverReply.port = 8081;
+        discoverReply.name = text("gateway-pc");
+        discoverReply.hasName = true;
+        benchmarkMessage<DiscoverReplyMsg>("discover_reply", discoverReply, iterations, encodeDiscoverReply, encodeDiscoverReply, decodeDiscoverReply);
+    }
+}
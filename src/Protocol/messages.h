@@ -0,0 +1,177 @@
+#pragma once
+
+// Gerado por tools/gen_protocol.py a partir de protocol/messages.json - não editar.
+
+#include <Arduino.h>
+#include "../Json/json_tokenizer.h"
+#include "../Json/json_writer.h"
+#include "../Json/msgpack_writer.h"
+
+/**
+ * Mensagens planas do protocolo WebSocket
+ *
+ * Para cada mensagem do esquema há uma struct e três funções sem alocação:
+ *   encodeX(msg, Json::Writer&) / encodeX(msg, MsgPack::Writer&) - frame
+ *     completo (com "type" e, nas mensagens da placa, "carId")
+ *   decodeX(payload, length, format, msg) - false se malformado, se faltar
+ *     campo obrigatório, se um tipo não bater ou se uma string passar do limite
+ * Strings são Json::Slice: no encode apontam para o texto do chamador
+ * (text()), no decode para dentro do payload (escapes preservados). Chaves
+ * desconhecidas são ignoradas no decode. Mensagens aninhadas (hello,
+ * heartbeat, telemetry, journal, session_data) continuam escritas à mão.
+ * O gateway usa protocol-codec.js, gerado do mesmo esquema.
+ */
+
+namespace Protocol
+{
+    const uint8_t SCHEMA_VERSION = 1;
+
+    // Fatia sobre uma string C (campos string dos encoders)
+    inline Json::Slice text(const char *value)
+    {
+        Json::Slice slice;
+        slice.ptr = value;
+        slice.len = value ? strlen(value) : 0;
+        return slice;
+    }
+
+    // ===== status (placa -> gateway): Status publicado pela placa =====
+    struct StatusMsg
+    {
+        static const size_t STATUS_MAX = 23;
+        Json::Slice status;
+        bool relayOn = false;
+    };
+    bool encodeStatus(const StatusMsg &msg, Json::Writer &json);
+    bool encodeStatus(const StatusMsg &msg, MsgPack::Writer &out);
+    bool decodeStatus(const uint8_t *payload, size_t length, Json::Format format, StatusMsg &msg);
+
+    // ===== ack (placa -> gateway): Comando com id aplicado =====
+    struct AckMsg
+    {
+        static const size_t RESULT_MAX = 24;
+        uint32_t id = 0;
+        Json::Slice result;
+        uint32_t latencyUs = 0;
+        bool duplicate = false;
+        bool hasDuplicate = false;
+    };
+    bool encodeAck(const AckMsg &msg, Json::Writer &json);
+    bool encodeAck(const AckMsg &msg, MsgPack::Writer &out);
+    bool decodeAck(const uint8_t *payload, size_t length, Json::Format format, AckMsg &msg);
+
+    // ===== nack (placa -> gateway): Comando com id recusado (mesmo layout do ack) =====
+    using NackMsg = AckMsg;
+    bool encodeNack(const AckMsg &msg, Json::Writer &json);
+    bool encodeNack(const AckMsg &msg, MsgPack::Writer &out);
+    bool decodeNack(const uint8_t *payload, size_t length, Json::Format format, AckMsg &msg);
+
+    // ===== batch_result (placa -> gateway): Resultado de um lote {"actions":[...]} =====
+    struct BatchResultMsg
+    {
+        static const size_t ERROR_MAX = 24;
+        static const size_t OPERATION_STATE_MAX = 16;
+        bool ok = false;
+        uint32_t id = 0;
+        bool hasId = false;
+        bool duplicate = false;
+        bool hasDuplicate = false;
+        uint32_t applied = 0;
+        long failed = 0;
+        bool hasFailed = false;
+        Json::Slice error;
+        bool hasError = false;
+        Json::Slice operationState;
+        bool relayOn = false;
+        uint32_t hc595 = 0;
+        uint32_t applyUs = 0;
+        uint32_t latencyUs = 0;
+    };
+    bool encodeBatchResult(const BatchResultMsg &msg, Json::Writer &json);
+    bool encodeBatchResult(const BatchResultMsg &msg, MsgPack::Writer &out);
+    bool decodeBatchResult(const uint8_t *payload, size_t length, Json::Format format, BatchResultMsg &msg);
+
+    // ===== caps_select (gateway -> placa): Resposta do gateway às capacidades anunciadas no hello =====
+    struct CapsSelectMsg
+    {
+        static const size_t ENC_MAX = 8;
+        static const size_t COMPRESS_MAX = 8;
+        long proto = 0;
+        bool hasProto = false;
+        Json::Slice enc;
+        bool hasEnc = false;
+        bool hbDelta = false;
+        bool hasHbDelta = false;
+        long keyframeEvery = 0;
+        bool hasKeyframeEvery = false;
+        Json::Slice compress;
+        bool hasCompress = false;
+    };
+    bool encodeCapsSelect(const CapsSelectMsg &msg, Json::Writer &json);
+    bool encodeCapsSelect(const CapsSelectMsg &msg, MsgPack::Writer &out);
+    bool decodeCapsSelect(const uint8_t *payload, size_t length, Json::Format format, CapsSelectMsg &msg);
+
+    // ===== encoding (gateway -> placa): Pedido avulso de codificação (gateways sem caps_select) =====
+    struct EncodingMsg
+    {
+        static const size_t VALUE_MAX = 8;
+        Json::Slice value;
+    };
+    bool encodeEncoding(const EncodingMsg &msg, Json::Writer &json);
+    bool encodeEncoding(const EncodingMsg &msg, MsgPack::Writer &out);
+    bool decodeEncoding(const uint8_t *payload, size_t length, Json::Format format, EncodingMsg &msg);
+
+    // ===== heartbeat_mode (gateway -> placa): Pedido avulso de modo de heartbeat (gateways sem caps_select) =====
+    struct HeartbeatModeMsg
+    {
+        static const size_t MODE_MAX = 8;
+        Json::Slice mode;
+        bool hasMode = false;
+        long keyframeEvery = 0;
+        bool hasKeyframeEvery = false;
+    };
+    bool encodeHeartbeatMode(const HeartbeatModeMsg &msg, Json::Writer &json);
+    bool encodeHeartbeatMode(const HeartbeatModeMsg &msg, MsgPack::Writer &out);
+    bool decodeHeartbeatMode(const uint8_t *payload, size_t length, Json::Format format, HeartbeatModeMsg &msg);
+
+    // ===== heartbeat_keyframe (gateway -> placa): Gateway perdeu a sequência de deltas e pede keyframe =====
+    struct HeartbeatKeyframeMsg
+    {
+    };
+    bool encodeHeartbeatKeyframe(const HeartbeatKeyframeMsg &msg, Json::Writer &json);
+    bool encodeHeartbeatKeyframe(const HeartbeatKeyframeMsg &msg, MsgPack::Writer &out);
+    bool decodeHeartbeatKeyframe(const uint8_t *payload, size_t length, Json::Format format, HeartbeatKeyframeMsg &msg);
+
+    // ===== journal_ack (gateway -> placa): Confirmação do replay do diário até seq =====
+    struct JournalAckMsg
+    {
+        uint32_t seq = 0;
+    };
+    bool encodeJournalAck(const JournalAckMsg &msg, Json::Writer &json);
+    bool encodeJournalAck(const JournalAckMsg &msg, MsgPack::Writer &out);
+    bool decodeJournalAck(const uint8_t *payload, size_t length, Json::Format format, JournalAckMsg &msg);
+
+    // ===== discover (placa -> gateway): Busca do gateway por broadcast UDP (DISCOVERY_PORT) =====
+    struct DiscoverMsg
+    {
+        uint32_t proto = 0;
+    };
+    bool encodeDiscover(const DiscoverMsg &msg, Json::Writer &json);
+    bool encodeDiscover(const DiscoverMsg &msg, MsgPack::Writer &out);
+    bool decodeDiscover(const uint8_t *payload, size_t length, Json::Format format, DiscoverMsg &msg);
+
+    // ===== discover_reply (gateway -> placa): Resposta unicast à busca; o host é o remetente do datagrama =====
+    struct DiscoverReplyMsg
+    {
+        static const size_t NAME_MAX = 24;
+        uint32_t port = 0;
+        Json::Slice name;
+        bool hasName = false;
+    };
+    bool encodeDiscoverReply(const DiscoverReplyMsg &msg, Json::Writer &json);
+    bool encodeDiscoverReply(const DiscoverReplyMsg &msg, MsgPack::Writer &out);
+    bool decodeDiscoverReply(const uint8_t *payload, size_t length, Json::Format format, DiscoverReplyMsg &msg);
+
+    // Ida e volta de todos os codecs (JSON e MessagePack) com os exemplos do esquema
+    void benchmarkRoundTrip(uint32_t iterations);
+}
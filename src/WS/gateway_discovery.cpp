@@ -0,0 +1,220 @@
+#include "gateway_discovery.h"
+#include "../Config/config.h"
+#include "../Json/json_writer.h"
+#include "../Protocol/messages.h"
+#include "rendezvous.h"
+#include <lwip/udp.h>
+
+namespace
+{
+    // Respostas maiores que isso não são do nosso gateway
+    const size_t REPLY_MAX = 96;
+
+    udp_pcb *g_pcb = nullptr;
+    Discovery::State g_state = Discovery::IDLE;
+    bool g_found = false;
+    char g_host[16] = "";
+    uint16_t g_port = 0;
+    unsigned long g_startedAt = 0;
+    unsigned long g_sentAt = 0;
+    unsigned long g_firstReplyAt = 0;
+    uint32_t g_bestWeight = 0; // WS_HOST_SHARDING: peso rendezvous do host guardado
+    Discovery::Stats g_stats;
+
+    void onReceive(void *, udp_pcb *, pbuf *p, const ip_addr_t *addr, uint16_t)
+    {
+        uint8_t buffer[REPLY_MAX];
+        uint16_t length = 0;
+        if (p)
+        {
+            if (p->tot_len <= sizeof(buffer))
+            {
+                length = pbuf_copy_partial(p, buffer, p->tot_len, 0);
+            }
+            pbuf_free(p);
+        }
+
+        Protocol::DiscoverReplyMsg reply;
+        if (g_state != Discovery::RUNNING || !length || !addr ||
+            !Protocol::decodeDiscoverReply(buffer, length, Json::FORMAT_JSON, reply) ||
+            reply.port == 0 || reply.port > 0xFFFF)
+        {
+            return;
+        }
+
+        // Endereço em ordem de rede: o primeiro octeto é o byte menos significativo
+        char host[sizeof(g_host)];
+        uint32_t ip = ip4_addr_get_u32(ip_2_ip4(addr));
+        snprintf(host, sizeof(host), "%u.%u.%u.%u",
+                 (unsigned)(ip & 0xFF), (unsigned)((ip >> 8) & 0xFF), (unsigned)((ip >> 16) & 0xFF), (unsigned)(ip >> 24));
+
+#if WS_HOST_SHARDING
+        // Fica com o gateway de maior peso para este carro entre os que responderem
+        uint32_t weight = Rendezvous::weight(CAR_ID_STR, host);
+        if (g_found && weight <= g_bestWeight)
+        {
+            return;
+        }
+        g_bestWeight = weight;
+#endif
+
+        memcpy(g_host, host, sizeof(g_host));
+        g_port = (uint16_t)reply.port;
+        if (!g_found)
+        {
+            g_found = true;
+            g_firstReplyAt = millis();
+            g_stats.found++;
+            g_stats.lastMs = g_firstReplyAt - g_startedAt;
+        }
+        if (!WS_HOST_SHARDING)
+        {
+            g_state = Discovery::DONE; // o primeiro que responder vence
+        }
+
+        Serial.print(F("[DISCOVERY] ✓ Gateway "));
+        Serial.print(g_host);
+        Serial.print(':');
+        Serial.print(g_port);
+        Serial.print(F(" respondeu em "));
+        Serial.print(millis() - g_startedAt);
+        Serial.println(F(" ms"));
+    }
+
+    bool open()
+    {
+        if (g_pcb)
+        {
+            return true;
+        }
+        g_pcb = udp_new();
+        if (!g_pcb)
+        {
+            return false;
+        }
+        ip_set_option(g_pcb, SOF_BROADCAST);
+        if (udp_bind(g_pcb, IP_ADDR_ANY, 0) != ERR_OK)
+        {
+            udp_remove(g_pcb);
+            g_pcb = nullptr;
+            return false;
+        }
+        udp_recv(g_pcb, onReceive, nullptr);
+        return true;
+    }
+
+    void sendQuery(unsigned long now)
+    {
+        char frame[Discovery::QUERY_SIZE];
+        Json::Writer json(frame, sizeof(frame));
+        Protocol::DiscoverMsg query;
+        query.proto = Protocol::SCHEMA_VERSION;
+        g_sentAt = now;
+        if (!Protocol::encodeDiscover(query, json))
+        {
+            Serial.print(F("[DISCOVERY][ERRO] Consulta não coube em "));
+            Serial.print(sizeof(frame));
+            Serial.println(F(" bytes"));
+            return;
+        }
+
+        pbuf *p = pbuf_alloc(PBUF_TRANSPORT, (uint16_t)json.length(), PBUF_RAM);
+        if (!p)
+        {
+            return; // sem memória: tenta de novo na próxima repetição
+        }
+        memcpy(p->payload, frame, json.length());
+        if (udp_sendto(g_pcb, p, IP_ADDR_BROADCAST, DISCOVERY_PORT) == ERR_OK)
+        {
+            g_stats.queries++;
+        }
+        pbuf_free(p);
+    }
+}
+
+namespace Discovery
+{
+    void start(unsigned long now)
+    {
+        g_found = false;
+        g_startedAt = now;
+        g_stats.rounds++;
+
+        if (!open())
+        {
+            Serial.println(F("[DISCOVERY][ERRO] Sem socket UDP livre"));
+            g_state = DONE;
+            return;
+        }
+
+        g_state = RUNNING;
+        if (LOG_VERBOSE)
+        {
+            Serial.print(F("[DISCOVERY] Broadcast na porta "));
+            Serial.println(DISCOVERY_PORT);
+        }
+        sendQuery(now);
+    }
+
+    void poll(unsigned long now)
+    {
+        if (g_state != RUNNING)
+        {
+            return;
+        }
+
+        // Sharding: janela curta depois da primeira resposta para ouvir os demais gateways
+        if (g_found)
+        {
+            if (now - g_firstReplyAt >= DISCOVERY_SHARD_WINDOW_MS)
+            {
+                g_state = DONE;
+            }
+            return;
+        }
+
+        if (now - g_startedAt > DISCOVERY_TIMEOUT_MS)
+        {
+            g_state = DONE;
+            g_stats.lastMs = now - g_startedAt;
+            Serial.println(F("[DISCOVERY] Nenhum gateway respondeu - usando a lista de hosts"));
+            return;
+        }
+
+        // Broadcast não tem retransmissão: repete a consulta
+        if (now - g_sentAt >= DISCOVERY_RETRY_MS)
+        {
+            sendQuery(now);
+        }
+    }
+
+    State state()
+    {
+        return g_state;
+    }
+
+    bool found()
+    {
+        return g_found;
+    }
+
+    const char *host()
+    {
+        return g_host;
+    }
+
+    uint16_t port()
+    {
+        return g_port;
+    }
+
+    void reset()
+    {
+        g_state = IDLE;
+    }
+
+    const Stats &stats()
+    {
+        return g_stats;
+    }
+}
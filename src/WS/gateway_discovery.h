@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Arduino.h>
+#include "../Config/config.h"
+#include "../Json/json_writer.h"
+
+/**
+ * Descoberta do gateway por broadcast UDP
+ *
+ * A placa envia {"type":"discover","carId":...,"proto":N} para
+ * 255.255.255.255:DISCOVERY_PORT e o primeiro gateway que responder
+ * {"type":"discover_reply","port":8081} vence; o host é o endereço de
+ * origem da resposta. Uma ida e volta na rede local substitui a sondagem
+ * dos IPs fixos de config.h, que fica como alternativa quando ninguém
+ * responde. O responder está em server-simple.js e server-discovery.js.
+ *
+ * API raw do lwIP (udp_sendto + callback de recepção), sem bloquear: a
+ * consulta é repetida a cada DISCOVERY_RETRY_MS até DISCOVERY_TIMEOUT_MS.
+ *
+ * Com WS_HOST_SHARDING, a busca espera DISCOVERY_SHARD_WINDOW_MS depois
+ * da primeira resposta e fica com o gateway de maior peso rendezvous para
+ * o CAR_ID_STR (rendezvous.h), em vez do mais rápido. O peso é o do IP de
+ * origem, o mesmo texto da entrada na lista de hosts (só IPs nesse modo).
+ *
+ * Uso:
+ *   Discovery::start(millis());
+ *   ...
+ *   Discovery::poll(millis());
+ *   if (Discovery::state() == Discovery::DONE && Discovery::found()) { Discovery::host(); Discovery::port(); }
+ */
+
+namespace Discovery
+{
+    // Buffer da consulta {"type":"discover","carId":CAR_ID_STR,"proto":<uint32>}:
+    // 10 dígitos, '}' e o terminador nulo do Json::Writer
+    const size_t QUERY_SIZE = Json::literalLength("{\"type\":\"discover\",\"carId\":\"" CAR_ID_STR "\",\"proto\":") + 12;
+
+    enum State : uint8_t
+    {
+        IDLE = 0,
+        RUNNING,
+        DONE
+    };
+
+    struct Stats
+    {
+        uint32_t rounds = 0;
+        uint32_t found = 0;     // rodadas com resposta
+        uint32_t queries = 0;   // datagramas enviados (com repetições)
+        uint32_t lastMs = 0;    // início da rodada -> resposta (ou timeout)
+    };
+
+    // Inicia uma rodada; sem socket UDP termina já em DONE, sem resposta
+    void start(unsigned long now);
+    void poll(unsigned long now);
+
+    State state();
+    bool found();       // a última rodada teve resposta
+    const char *host(); // IP de quem respondeu (mantido até a próxima resposta)
+    uint16_t port();    // porta WebSocket informada pelo gateway
+    void reset();       // volta a IDLE (ignora respostas atrasadas)
+
+    const Stats &stats();
+}
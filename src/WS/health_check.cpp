@@ -0,0 +1,329 @@
+#include "health_check.h"
+#include "../Config/config.h"
+#include "../Json/json_tokenizer.h"
+#include <lwip/tcp.h>
+#include <lwip/dns.h>
+
+namespace
+{
+    enum Step : uint8_t
+    {
+        S_RESOLVING = 0,
+        S_RESOLVED,   // endereço pronto; a conexão sai no próximo poll()
+        S_CONNECTING, // tcp_connect em andamento
+        S_WAITING,    // requisição enviada, aguardando resposta
+        S_FINISHED,   // servidor fechou ou o buffer encheu
+        S_FAILED
+    };
+
+    const char HEALTH_PATH[] = "/api/ws/health";
+
+    char g_buffer[HEALTH_RESPONSE_MAX];
+    char g_host[64];
+    uint16_t g_port = 0;
+    tcp_pcb *g_pcb = nullptr;
+    ip_addr_t g_addr;
+    Step g_step = S_FAILED;
+    uint8_t g_round = 0; // callbacks de verificações anteriores são ignorados
+    HealthCheck::State g_state = HealthCheck::IDLE;
+    HealthCheck::Result g_result;
+    unsigned long g_startedAt = 0;
+    unsigned long g_connectStartedAt = 0;
+    unsigned long g_firstByteAt = 0;
+
+    void *tag()
+    {
+        return reinterpret_cast<void *>((uintptr_t)g_round);
+    }
+
+    bool current(void *arg)
+    {
+        return g_state == HealthCheck::RUNNING && (uint8_t) reinterpret_cast<uintptr_t>(arg) == g_round;
+    }
+
+    void detach(tcp_pcb *pcb)
+    {
+        tcp_arg(pcb, nullptr);
+        tcp_err(pcb, nullptr);
+        tcp_recv(pcb, nullptr);
+        if (pcb == g_pcb)
+        {
+            g_pcb = nullptr;
+        }
+    }
+
+    void abortPcb()
+    {
+        if (g_pcb)
+        {
+            // Sem callbacks: tcp_abort chamaria onError com a verificação já descartada
+            tcp_pcb *pcb = g_pcb;
+            detach(pcb);
+            tcp_abort(pcb);
+        }
+    }
+
+    // Fecha com FIN (RST se faltar memória); dentro de callback devolve ERR_ABRT se abortou
+    err_t closePcb(tcp_pcb *pcb)
+    {
+        detach(pcb);
+        if (tcp_close(pcb) != ERR_OK)
+        {
+            tcp_abort(pcb);
+            return ERR_ABRT;
+        }
+        return ERR_OK;
+    }
+
+    // ===== CALLBACKS DO LWIP =====
+    err_t onRecv(void *arg, tcp_pcb *pcb, pbuf *p, err_t)
+    {
+        if (!current(arg))
+        {
+            if (p)
+            {
+                pbuf_free(p);
+            }
+            detach(pcb);
+            tcp_abort(pcb);
+            return ERR_ABRT;
+        }
+
+        if (!p)
+        {
+            g_step = S_FINISHED; // servidor fechou (Connection: close)
+            return closePcb(pcb);
+        }
+
+        if (!g_firstByteAt)
+        {
+            g_firstByteAt = millis();
+        }
+
+        uint16_t space = (uint16_t)(sizeof(g_buffer) - g_result.bytes);
+        uint16_t copy = p->tot_len < space ? p->tot_len : space;
+        g_result.bytes += pbuf_copy_partial(p, g_buffer + g_result.bytes, copy, 0);
+        tcp_recved(pcb, p->tot_len);
+        pbuf_free(p);
+
+        if (g_result.bytes == sizeof(g_buffer))
+        {
+            g_step = S_FINISHED; // o resto da resposta não interessa
+            return closePcb(pcb);
+        }
+        return ERR_OK;
+    }
+
+    err_t onConnected(void *arg, tcp_pcb *pcb, err_t err)
+    {
+        if (!current(arg) || err != ERR_OK)
+        {
+            if (current(arg))
+            {
+                g_step = S_FAILED;
+            }
+            detach(pcb);
+            tcp_abort(pcb);
+            return ERR_ABRT;
+        }
+
+        char request[128];
+        int length = snprintf(request, sizeof(request),
+                              "GET %s HTTP/1.0\r\nHost: %s\r\nConnection: close\r\n\r\n", HEALTH_PATH, g_host);
+        if (length <= 0 || length >= (int)sizeof(request) ||
+            tcp_write(pcb, request, (uint16_t)length, TCP_WRITE_FLAG_COPY) != ERR_OK)
+        {
+            g_step = S_FAILED;
+            detach(pcb);
+            tcp_abort(pcb);
+            return ERR_ABRT;
+        }
+
+        tcp_recv(pcb, onRecv);
+        tcp_output(pcb);
+        g_step = S_WAITING;
+        return ERR_OK;
+    }
+
+    void onError(void *arg, err_t)
+    {
+        // O PCB já foi liberado pelo lwIP
+        if (current(arg))
+        {
+            g_pcb = nullptr;
+            g_step = S_FAILED;
+        }
+    }
+
+    void onResolved(const char *, const ip_addr_t *addr, void *arg)
+    {
+        if (!current(arg) || g_step != S_RESOLVING)
+        {
+            return;
+        }
+        if (!addr)
+        {
+            g_step = S_FAILED;
+            return;
+        }
+        g_addr = *addr;
+        g_step = S_RESOLVED;
+    }
+
+    // ===== ETAPAS =====
+    void connect(unsigned long now)
+    {
+        tcp_pcb *pcb = tcp_new();
+        if (!pcb)
+        {
+            return; // sem PCB livre: tenta no próximo poll (até o timeout)
+        }
+
+        tcp_arg(pcb, tag());
+        tcp_err(pcb, onError);
+        g_pcb = pcb;
+        g_step = S_CONNECTING;
+        g_connectStartedAt = now;
+
+        if (tcp_connect(pcb, &g_addr, g_port, onConnected) != ERR_OK)
+        {
+            abortPcb();
+            g_step = S_FAILED;
+        }
+    }
+
+    // "HTTP/1.x NNN ..." e o campo "status" do corpo JSON
+    void parse()
+    {
+        size_t length = g_result.bytes;
+        if (length < 12 || memcmp(g_buffer, "HTTP/1.", 7) != 0 || g_buffer[8] != ' ')
+        {
+            return;
+        }
+
+        int code = 0;
+        for (size_t i = 9; i < 12; i++)
+        {
+            if (g_buffer[i] < '0' || g_buffer[i] > '9')
+            {
+                return;
+            }
+            code = code * 10 + (g_buffer[i] - '0');
+        }
+        g_result.httpStatus = (int16_t)code;
+
+        const char *body = nullptr;
+        for (size_t i = 12; i + 4 <= length; i++)
+        {
+            if (memcmp(g_buffer + i, "\r\n\r\n", 4) == 0)
+            {
+                body = g_buffer + i + 4;
+                break;
+            }
+        }
+        if (!body)
+        {
+            return;
+        }
+
+        // Parcial: corpo cortado pelo buffer não é erro enquanto o campo couber
+        Json::Tokenizer tok(reinterpret_cast<const uint8_t *>(body), g_buffer + length - body);
+        tok.setPartial(true);
+        Json::Token t;
+        while (tok.next(t))
+        {
+            if (t.type == Json::TOK_KEY && t.depth == 1 && t.text.equals("status"))
+            {
+                g_result.statusOk = tok.next(t) && t.type == Json::TOK_STRING && t.text.equals("ok");
+                return;
+            }
+        }
+    }
+
+    void finish(unsigned long now)
+    {
+        abortPcb();
+        if (g_firstByteAt)
+        {
+            g_result.latencyMs = g_firstByteAt - g_connectStartedAt;
+            parse();
+        }
+        else
+        {
+            g_result.latencyMs = now - g_startedAt;
+        }
+        g_state = HealthCheck::DONE;
+    }
+}
+
+namespace HealthCheck
+{
+    bool start(const char *host, uint16_t port, unsigned long now)
+    {
+        reset();
+        if (!host || !*host || strlen(host) >= sizeof(g_host))
+        {
+            return false;
+        }
+
+        g_round++;
+        strcpy(g_host, host);
+        g_port = port;
+        g_result = Result();
+        g_startedAt = now;
+        g_connectStartedAt = now;
+        g_firstByteAt = 0;
+        g_state = RUNNING;
+
+        // IP literal ou nome em cache resolve na hora (ERR_OK)
+        err_t result = dns_gethostbyname(g_host, &g_addr, onResolved, tag());
+        if (result == ERR_OK)
+        {
+            g_step = S_RESOLVED;
+            connect(now);
+        }
+        else if (result == ERR_INPROGRESS)
+        {
+            g_step = S_RESOLVING;
+        }
+        else
+        {
+            g_step = S_FAILED;
+        }
+        return true;
+    }
+
+    void poll(unsigned long now)
+    {
+        if (g_state != RUNNING)
+        {
+            return;
+        }
+
+        if (g_step == S_RESOLVED)
+        {
+            connect(now);
+        }
+
+        if (g_step == S_FINISHED || g_step == S_FAILED || now - g_startedAt > HEALTH_TIMEOUT_MS)
+        {
+            finish(now);
+        }
+    }
+
+    State state()
+    {
+        return g_state;
+    }
+
+    const Result &result()
+    {
+        return g_result;
+    }
+
+    void reset()
+    {
+        abortPcb();
+        g_state = IDLE;
+    }
+}
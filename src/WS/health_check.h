@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Health check HTTP assíncrono do gateway (GET /api/ws/health)
+ *
+ * Requisição mínima sobre a API raw do lwIP, no mesmo modelo do HostProbe:
+ * DNS assíncrono, tcp_connect não bloqueante e resposta copiada para um
+ * buffer fixo de HEALTH_RESPONSE_MAX bytes (o excedente é descartado, sem
+ * String nem heap). Só a linha de status e o campo "status" do corpo são
+ * interpretados; corpo cortado pelo buffer ainda vale se o campo couber.
+ *
+ * Uma verificação por vez. poll() roda a cada loop e só trata timeout e
+ * conclusão; os callbacks do lwIP apenas copiam bytes.
+ *
+ * Uso:
+ *   HealthCheck::start(host, port, millis());
+ *   ...
+ *   HealthCheck::poll(millis());
+ *   if (HealthCheck::state() == HealthCheck::DONE) { ... HealthCheck::result() ...; HealthCheck::reset(); }
+ */
+
+namespace HealthCheck
+{
+    enum State : uint8_t
+    {
+        IDLE = 0,
+        RUNNING,
+        DONE
+    };
+
+    struct Result
+    {
+        int16_t httpStatus = -1; // -1 = sem resposta (DNS, conexão recusada ou timeout)
+        bool statusOk = false;   // corpo com "status":"ok"
+        uint32_t latencyMs = 0;  // início da conexão -> primeiro byte da resposta
+        uint16_t bytes = 0;      // bytes guardados no buffer
+    };
+
+    // Inicia uma verificação (aborta a anterior, se houver); false se não pôde iniciar
+    bool start(const char *host, uint16_t port, unsigned long now);
+    void poll(unsigned long now);
+
+    State state();
+    const Result &result(); // válido em DONE
+    void reset();           // aborta a conexão pendente e volta a IDLE
+}
@@ -0,0 +1,356 @@
+#include "host_probe.h"
+#include "WSUtils.h"
+#include "../Config/config.h"
+#include <lwip/tcp.h>
+#include <lwip/dns.h>
+
+namespace
+{
+    enum ProbeState : uint8_t
+    {
+        P_SKIPPED = 0, // host vazio, loopback ou a própria placa
+        P_PENDING,     // aguardando vaga para resolver
+        P_RESOLVING,   // dns_gethostbyname em andamento
+        P_RESOLVED,    // endereço pronto, aguardando PCB livre
+        P_CONNECTING,  // tcp_connect em andamento
+        P_CONNECTED,
+        P_FAILED
+    };
+
+    struct Probe
+    {
+        ProbeState state;
+        tcp_pcb *pcb;
+        ip_addr_t addr;
+        unsigned long startedAt;
+        unsigned long doneAt;
+    };
+
+    Probe g_probes[WS_PROBE_MAX_HOSTS];
+    uint8_t g_order[WS_PROBE_MAX_HOSTS]; // prioridade: ordem de disparo e desempate
+    bool g_strict = false;               // vence o de maior prioridade que aceitar, não o mais rápido
+    const char *const *g_hosts = nullptr;
+    size_t g_count = 0;
+    uint16_t g_port = 0;
+    uint8_t g_round = 0; // callbacks de rodadas anteriores são ignorados
+    HostProbe::State g_state = HostProbe::IDLE;
+    int g_winner = -1;
+    unsigned long g_startedAt = 0;
+    HostProbe::Stats g_stats;
+
+    // Argumento dos callbacks do lwIP: rodada + índice da sonda
+    void *tag(size_t index)
+    {
+        return reinterpret_cast<void *>(((uintptr_t)g_round << 8) | index);
+    }
+
+    Probe *fromTag(void *arg)
+    {
+        uintptr_t value = reinterpret_cast<uintptr_t>(arg);
+        size_t index = value & 0xFF;
+        if ((uint8_t)(value >> 8) != g_round || index >= g_count || g_state != HostProbe::RUNNING)
+        {
+            return nullptr;
+        }
+        return &g_probes[index];
+    }
+
+    void abortPcb(Probe &probe)
+    {
+        if (probe.pcb)
+        {
+            // Sem callbacks: tcp_abort chamaria onError com a sonda já descartada
+            tcp_arg(probe.pcb, nullptr);
+            tcp_err(probe.pcb, nullptr);
+            tcp_abort(probe.pcb);
+            probe.pcb = nullptr;
+        }
+    }
+
+    // ===== CALLBACKS DO LWIP =====
+    err_t onConnected(void *arg, tcp_pcb *pcb, err_t err)
+    {
+        tcp_arg(pcb, nullptr);
+        tcp_err(pcb, nullptr);
+
+        Probe *probe = fromTag(arg);
+        if (probe)
+        {
+            probe->pcb = nullptr;
+            probe->state = (err == ERR_OK) ? P_CONNECTED : P_FAILED;
+            probe->doneAt = millis();
+        }
+
+        // Só queríamos saber se o host aceita: fecha com FIN (RST se faltar memória)
+        if (tcp_close(pcb) != ERR_OK)
+        {
+            tcp_abort(pcb);
+            return ERR_ABRT;
+        }
+        return ERR_OK;
+    }
+
+    void onError(void *arg, err_t)
+    {
+        // O PCB já foi liberado pelo lwIP
+        Probe *probe = fromTag(arg);
+        if (probe)
+        {
+            probe->pcb = nullptr;
+            probe->state = P_FAILED;
+        }
+    }
+
+    void onResolved(const char *, const ip_addr_t *addr, void *arg)
+    {
+        Probe *probe = fromTag(arg);
+        if (!probe || probe->state != P_RESOLVING)
+        {
+            return;
+        }
+        if (!addr)
+        {
+            probe->state = P_FAILED;
+            return;
+        }
+        // A conexão é aberta no próximo poll(), fora do contexto do lwIP
+        probe->addr = *addr;
+        probe->state = P_RESOLVED;
+    }
+
+    // ===== ETAPAS =====
+    void connect(size_t index, unsigned long now)
+    {
+        Probe &probe = g_probes[index];
+        tcp_pcb *pcb = tcp_new();
+        if (!pcb)
+        {
+            return; // sem PCB livre: continua P_RESOLVED e tenta no próximo poll
+        }
+
+        tcp_arg(pcb, tag(index));
+        tcp_err(pcb, onError);
+        probe.pcb = pcb;
+        probe.state = P_CONNECTING;
+        probe.startedAt = now;
+
+        if (tcp_connect(pcb, &probe.addr, g_port, onConnected) != ERR_OK)
+        {
+            abortPcb(probe);
+            probe.state = P_FAILED;
+        }
+    }
+
+    void resolve(size_t index, unsigned long now)
+    {
+        Probe &probe = g_probes[index];
+        probe.startedAt = now;
+
+        // IP literal ou nome em cache resolve na hora (ERR_OK)
+        err_t result = dns_gethostbyname(g_hosts[index], &probe.addr, onResolved, tag(index));
+        if (result == ERR_OK)
+        {
+            probe.state = P_RESOLVED;
+            connect(index, now);
+        }
+        else if (result == ERR_INPROGRESS)
+        {
+            probe.state = P_RESOLVING;
+        }
+        else
+        {
+            probe.state = P_FAILED;
+        }
+    }
+
+    void finish(int winner, unsigned long now)
+    {
+        for (size_t i = 0; i < g_count; i++)
+        {
+            abortPcb(g_probes[i]);
+        }
+
+        g_winner = winner;
+        g_state = HostProbe::DONE;
+        g_stats.lastDurationMs = now - g_startedAt;
+        g_stats.lastWinner = (int8_t)winner;
+
+        if (winner < 0)
+        {
+            Serial.print(F("[PROBE] Nenhum host respondeu em "));
+            Serial.print(g_stats.lastDurationMs);
+            Serial.println(F(" ms"));
+            return;
+        }
+
+        g_stats.found++;
+        Serial.print(F("[PROBE] ✓ Host selecionado: "));
+        Serial.print(g_hosts[winner]);
+        Serial.print(F(" (conexão em "));
+        Serial.print(g_probes[winner].doneAt - g_probes[winner].startedAt);
+        Serial.println(F(" ms)"));
+    }
+}
+
+namespace HostProbe
+{
+    bool start(const char *const *hosts, size_t count, uint16_t port, unsigned long now, const uint8_t *order,
+               bool strict)
+    {
+        reset();
+
+        g_round++;
+        g_hosts = hosts;
+        g_count = count < WS_PROBE_MAX_HOSTS ? count : WS_PROBE_MAX_HOSTS;
+        g_port = port;
+        g_strict = strict && order;
+        g_startedAt = now;
+        g_winner = -1;
+
+        size_t candidates = 0;
+        for (size_t i = 0; i < g_count; i++)
+        {
+            g_order[i] = (order && order[i] < g_count) ? order[i] : (uint8_t)i;
+
+            const char *host = hosts[i];
+            Probe &probe = g_probes[i];
+            probe.pcb = nullptr;
+
+            bool loopback = host && (strcmp(host, "localhost") == 0 || strcmp(host, "127.0.0.1") == 0);
+            if (!host || !*host || loopback || WSUtils::isSelfHost(host))
+            {
+                probe.state = P_SKIPPED;
+                continue;
+            }
+            probe.state = P_PENDING;
+            candidates++;
+        }
+
+        if (candidates == 0)
+        {
+            Serial.println(F("[PROBE] Nenhum host candidato (vazios, loopback ou IP da placa)"));
+            return false;
+        }
+
+        g_stats.rounds++;
+        g_state = RUNNING;
+        if (LOG_VERBOSE)
+        {
+            Serial.print(F("[PROBE] Sondando "));
+            Serial.print(candidates);
+            Serial.println(F(" hosts em paralelo"));
+        }
+
+        poll(now);
+        return true;
+    }
+
+    void poll(unsigned long now)
+    {
+        if (g_state != RUNNING)
+        {
+            return;
+        }
+
+        // Timeouts (contados do início da resolução, e de novo do início da conexão)
+        size_t active = 0;
+        bool remaining = false;
+        for (size_t k = 0; k < g_count; k++)
+        {
+            size_t i = g_order[k];
+            Probe &probe = g_probes[i];
+            if (probe.state >= P_RESOLVING && probe.state <= P_CONNECTING &&
+                now - probe.startedAt > WS_PROBE_TIMEOUT_MS)
+            {
+                abortPcb(probe);
+                probe.state = P_FAILED;
+            }
+
+            // O de maior prioridade entre os que já conectaram; estrito: só
+            // quando nenhum de prioridade maior ainda pode conectar
+            if (probe.state == P_CONNECTED && !(g_strict && remaining))
+            {
+                finish((int)i, now);
+                return;
+            }
+
+            if (probe.state == P_RESOLVING || probe.state == P_CONNECTING)
+            {
+                active++;
+            }
+            if (probe.state >= P_PENDING && probe.state <= P_CONNECTING)
+            {
+                remaining = true;
+            }
+        }
+
+        if (!remaining)
+        {
+            finish(-1, now);
+            return;
+        }
+
+        // Novas sondas por prioridade (sem ordem: host principal primeiro)
+        for (size_t k = 0; k < g_count && active < WS_PROBE_PARALLEL; k++)
+        {
+            size_t i = g_order[k];
+            Probe &probe = g_probes[i];
+            if (probe.state == P_PENDING)
+            {
+                resolve(i, now);
+            }
+            else if (probe.state == P_RESOLVED)
+            {
+                connect(i, now);
+            }
+            else
+            {
+                continue;
+            }
+
+            if (probe.state == P_RESOLVING || probe.state == P_CONNECTING)
+            {
+                active++;
+            }
+        }
+    }
+
+    State state()
+    {
+        return g_state;
+    }
+
+    int winner()
+    {
+        return g_winner;
+    }
+
+    bool connectTime(size_t index, uint32_t &ms)
+    {
+        if (index >= g_count || g_probes[index].state != P_CONNECTED)
+        {
+            return false;
+        }
+        ms = g_probes[index].doneAt - g_probes[index].startedAt;
+        return true;
+    }
+
+    bool failed(size_t index)
+    {
+        return index < g_count && g_probes[index].state == P_FAILED;
+    }
+
+    void reset()
+    {
+        for (size_t i = 0; i < g_count; i++)
+        {
+            abortPcb(g_probes[i]);
+        }
+        g_state = IDLE;
+    }
+
+    const Stats &stats()
+    {
+        return g_stats;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Busca assíncrona do gateway entre os hosts candidatos
+ *
+ * Sonda todos os hosts ao mesmo tempo com conexões TCP não bloqueantes
+ * (API raw do lwIP: tcp_connect com callbacks, até WS_PROBE_PARALLEL
+ * simultâneas); nomes passam por dns_gethostbyname, também assíncrono.
+ * O primeiro host que aceitar a conexão vence e as demais sondas são
+ * abortadas; se vários aceitarem no mesmo poll(), vence o de maior
+ * prioridade (parâmetro order de start(), ex. o ranking do HostScoreboard). Nada bloqueia: poll() roda a cada loop e só trata timeouts,
+ * inicia sondas que esperavam vaga e decide o vencedor.
+ *
+ * Hosts vazios, localhost/127.0.0.1 e o IP da própria placa são ignorados.
+ *
+ * Uso:
+ *   HostProbe::start(hosts, count, port, millis());
+ *   ...
+ *   HostProbe::poll(millis());
+ *   if (HostProbe::state() == HostProbe::DONE) { int i = HostProbe::winner(); HostProbe::reset(); }
+ */
+
+namespace HostProbe
+{
+    enum State : uint8_t
+    {
+        IDLE = 0,
+        RUNNING,
+        DONE
+    };
+
+    struct Stats
+    {
+        uint32_t rounds = 0;
+        uint32_t found = 0;          // rodadas com vencedor
+        uint32_t lastDurationMs = 0; // início da rodada -> resultado
+        int8_t lastWinner = -1;
+    };
+
+    // Inicia uma rodada (aborta a anterior, se houver); false se não há candidato.
+    // order: índices em ordem de prioridade (nullptr = ordem da lista).
+    // strict: o vencedor é o de maior prioridade que aceitar (espera os de
+    // prioridade maior falharem), não o primeiro a aceitar
+    bool start(const char *const *hosts, size_t count, uint16_t port, unsigned long now,
+               const uint8_t *order = nullptr, bool strict = false);
+    void poll(unsigned long now);
+
+    State state();
+    int winner(); // índice do host vencedor; -1 = nenhum respondeu
+    // Resultado de cada host na última rodada (válido até o próximo start)
+    bool connectTime(size_t index, uint32_t &ms); // true se o host aceitou a conexão
+    bool failed(size_t index);                    // recusou, não resolveu ou esgotou o timeout
+
+    void reset(); // aborta sondas pendentes e volta a IDLE
+
+    const Stats &stats();
+}
@@ -0,0 +1,326 @@
+#include "host_scoreboard.h"
+#include "../Config/config.h"
+
+namespace
+{
+    const uint32_t RTC_MAGIC = 0x48535333; // "HSS3"
+    const uint8_t NO_HOST = 0xFF;
+
+    struct HostScore
+    {
+        uint16_t connectMs;   // média móvel (1/4) da conexão TCP da sonda
+        uint16_t handshakeMs; // média móvel (1/4) de begin() até CONNECTED
+        uint16_t healthMs;    // média móvel (1/4) do health check (até o primeiro byte)
+        uint16_t sessionSec;  // média móvel (1/4) da duração das sessões
+        uint8_t failures;     // falhas recentes; cada sucesso divide por 2
+        uint8_t samples;      // medições de conexão/handshake/health (satura em 255)
+        uint16_t reserved;
+    };
+
+    // Bloco gravado na RTC: rtcUserMemory* trabalha em palavras de 4 bytes
+    struct RtcBlock
+    {
+        uint32_t magic;
+        uint32_t hostsHash; // lista de hosts do firmware que gravou
+        uint8_t lastGood;
+        uint8_t count;
+        uint16_t reserved;
+        HostScore hosts[WS_PROBE_MAX_HOSTS];
+        HostScore discovered;    // slot HostScoreboard::DISCOVERED
+        char discoveredHost[16]; // IPv4 pontuado de quem respondeu; "" = vazio
+        uint16_t discoveredPort;
+        uint16_t reserved2;
+        uint32_t checksum;
+    };
+
+    static_assert(sizeof(RtcBlock) % 4 == 0, "RtcBlock deve ocupar palavras inteiras");
+    static_assert(HOST_SCORE_RTC_OFFSET * 4 + sizeof(RtcBlock) <= 512, "RtcBlock não cabe na memória RTC do usuário");
+    static_assert(WS_PROBE_MAX_HOSTS < HostScoreboard::DISCOVERED, "Índice DISCOVERED colide com a lista de hosts");
+
+    RtcBlock g_block;
+    const char *const *g_hosts = nullptr;
+    bool g_restored = false;
+
+    // FNV-1a: identidade da lista de hosts e verificação do bloco
+    uint32_t fnv1a(const void *data, size_t length, uint32_t hash = 2166136261UL)
+    {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < length; i++)
+        {
+            hash = (hash ^ p[i]) * 16777619UL;
+        }
+        return hash;
+    }
+
+    uint32_t checksum(const RtcBlock &block)
+    {
+        return fnv1a(&block, offsetof(RtcBlock, checksum));
+    }
+
+    void save()
+    {
+        g_block.checksum = checksum(g_block);
+        ESP.rtcUserMemoryWrite(HOST_SCORE_RTC_OFFSET, reinterpret_cast<uint32_t *>(&g_block), sizeof(g_block));
+    }
+
+    uint16_t average(uint16_t current, uint32_t sample, bool first)
+    {
+        if (sample > 0xFFFF)
+        {
+            sample = 0xFFFF;
+        }
+        return first ? (uint16_t)sample : (uint16_t)((3UL * current + sample) / 4);
+    }
+
+    HostScore *slot(size_t index)
+    {
+        if (index == HostScoreboard::DISCOVERED)
+        {
+            return g_block.discoveredHost[0] ? &g_block.discovered : nullptr;
+        }
+        return index < g_block.count ? &g_block.hosts[index] : nullptr;
+    }
+
+    const char *name(size_t index)
+    {
+        if (index == HostScoreboard::DISCOVERED)
+        {
+            return g_block.discoveredHost;
+        }
+        return g_hosts[index] ? g_hosts[index] : "(null)";
+    }
+
+    void succeeded(HostScore &host)
+    {
+        host.failures /= 2;
+        if (host.samples < 0xFF)
+        {
+            host.samples++;
+        }
+    }
+}
+
+namespace HostScoreboard
+{
+    void begin(const char *const *hosts, size_t count)
+    {
+        g_hosts = hosts;
+        if (count > WS_PROBE_MAX_HOSTS)
+        {
+            count = WS_PROBE_MAX_HOSTS;
+        }
+
+        uint32_t hostsHash = fnv1a(&count, sizeof(count));
+        for (size_t i = 0; i < count; i++)
+        {
+            const char *host = hosts[i] ? hosts[i] : "";
+            hostsHash = fnv1a(host, strlen(host) + 1, hostsHash);
+        }
+
+        ESP.rtcUserMemoryRead(HOST_SCORE_RTC_OFFSET, reinterpret_cast<uint32_t *>(&g_block), sizeof(g_block));
+        g_restored = g_block.magic == RTC_MAGIC && g_block.hostsHash == hostsHash &&
+                     g_block.count == count && g_block.checksum == checksum(g_block);
+
+        if (!g_restored)
+        {
+            memset(&g_block, 0, sizeof(g_block));
+            g_block.magic = RTC_MAGIC;
+            g_block.hostsHash = hostsHash;
+            g_block.count = (uint8_t)count;
+            g_block.lastGood = NO_HOST;
+            save();
+        }
+
+        Serial.print(F("[HOSTS] Placar "));
+        Serial.print(g_restored ? F("restaurado da RTC") : F("novo"));
+        if (lastGood() >= 0)
+        {
+            Serial.print(F(" - último host bom: "));
+            Serial.print(name(lastGood()));
+        }
+        Serial.println();
+    }
+
+    bool restored()
+    {
+        return g_restored;
+    }
+
+    int lastGood()
+    {
+        return slot(g_block.lastGood) ? g_block.lastGood : -1;
+    }
+
+    void setDiscovered(const char *host, uint16_t port)
+    {
+        if (!host || strlen(host) >= sizeof(g_block.discoveredHost))
+        {
+            return;
+        }
+        if (port == g_block.discoveredPort && strcmp(host, g_block.discoveredHost) == 0)
+        {
+            return; // mesmo gateway: mantém as medições
+        }
+
+        memset(&g_block.discovered, 0, sizeof(g_block.discovered));
+        memset(g_block.discoveredHost, 0, sizeof(g_block.discoveredHost));
+        strcpy(g_block.discoveredHost, host);
+        g_block.discoveredPort = port;
+        if (g_block.lastGood == DISCOVERED)
+        {
+            g_block.lastGood = NO_HOST; // era outro endereço
+        }
+        save();
+    }
+
+    const char *discoveredHost()
+    {
+        return g_block.discoveredHost;
+    }
+
+    uint16_t discoveredPort()
+    {
+        return g_block.discoveredPort;
+    }
+
+    uint32_t score(size_t index)
+    {
+        const HostScore *host = slot(index);
+        if (!host)
+        {
+            return UINT32_MAX;
+        }
+
+        uint32_t total = (uint32_t)host->failures * HOST_FAIL_PENALTY_MS;
+        if (host->samples == 0)
+        {
+            return total + WS_PROBE_TIMEOUT_MS;
+        }
+
+        total += host->connectMs + host->handshakeMs + host->healthMs;
+
+        // Sessões longas: até 1 s de bônus (100 ms por minuto de sessão média)
+        uint32_t bonus = (host->sessionSec / 60) * 100;
+        if (bonus > 1000)
+        {
+            bonus = 1000;
+        }
+        return total > bonus ? total - bonus : 0;
+    }
+
+    size_t ranking(uint8_t *order, size_t capacity)
+    {
+        size_t n = g_block.count < capacity ? g_block.count : capacity;
+        for (size_t i = 0; i < n; i++)
+        {
+            order[i] = (uint8_t)i;
+        }
+
+        // Inserção estável: empate mantém a ordem de ALT_WS_HOSTS
+        for (size_t i = 1; i < n; i++)
+        {
+            uint8_t current = order[i];
+            uint32_t currentScore = score(current);
+            size_t j = i;
+            while (j > 0 && score(order[j - 1]) > currentScore)
+            {
+                order[j] = order[j - 1];
+                j--;
+            }
+            order[j] = current;
+        }
+        return n;
+    }
+
+    void recordConnect(size_t index, uint32_t ms)
+    {
+        HostScore *host = slot(index);
+        if (!host)
+        {
+            return;
+        }
+        host->connectMs = average(host->connectMs, ms, host->samples == 0);
+        succeeded(*host);
+        save();
+    }
+
+    void recordHandshake(size_t index, uint32_t ms)
+    {
+        HostScore *host = slot(index);
+        if (!host)
+        {
+            return;
+        }
+        host->handshakeMs = average(host->handshakeMs, ms, host->handshakeMs == 0);
+        succeeded(*host);
+        g_block.lastGood = (uint8_t)index;
+        save();
+    }
+
+    void recordHealth(size_t index, uint32_t ms)
+    {
+        HostScore *host = slot(index);
+        if (!host)
+        {
+            return;
+        }
+        host->healthMs = average(host->healthMs, ms, host->healthMs == 0);
+        succeeded(*host);
+        save();
+    }
+
+    void recordSession(size_t index, uint32_t seconds)
+    {
+        HostScore *host = slot(index);
+        if (!host)
+        {
+            return;
+        }
+        host->sessionSec = average(host->sessionSec, seconds, host->sessionSec == 0);
+        save();
+    }
+
+    void recordFailure(size_t index)
+    {
+        HostScore *host = slot(index);
+        if (!host)
+        {
+            return;
+        }
+        if (host->failures < 0xFF)
+        {
+            host->failures++;
+        }
+        if (g_block.lastGood == index)
+        {
+            g_block.lastGood = NO_HOST; // o próximo boot volta a sondar
+        }
+        save();
+    }
+
+    void print()
+    {
+        uint8_t order[WS_PROBE_MAX_HOSTS];
+        size_t n = ranking(order, WS_PROBE_MAX_HOSTS);
+
+        Serial.println(F("[HOSTS] Placar (melhor primeiro):"));
+        for (size_t i = 0; i < n; i++)
+        {
+            const HostScore &host = g_block.hosts[order[i]];
+            Serial.printf("  [%u] %-16s score=%lu conn=%ums hs=%ums health=%ums sess=%us falhas=%u%s\n",
+                          (unsigned)order[i], name(order[i]),
+                          (unsigned long)score(order[i]), (unsigned)host.connectMs, (unsigned)host.handshakeMs, (unsigned)host.healthMs,
+                          (unsigned)host.sessionSec, (unsigned)host.failures,
+                          order[i] == g_block.lastGood ? " (último bom)" : "");
+        }
+
+        if (g_block.discoveredHost[0])
+        {
+            const HostScore &host = g_block.discovered;
+            Serial.printf("  [d] %s:%u score=%lu hs=%ums health=%ums sess=%us falhas=%u%s\n",
+                          g_block.discoveredHost, (unsigned)g_block.discoveredPort, (unsigned long)score(DISCOVERED),
+                          (unsigned)host.handshakeMs, (unsigned)host.healthMs, (unsigned)host.sessionSec,
+                          (unsigned)host.failures, g_block.lastGood == DISCOVERED ? " (último bom)" : "");
+        }
+    }
+}
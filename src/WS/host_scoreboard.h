@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Placar dos hosts candidatos, preservado na memória RTC
+ *
+ * Cada host acumula médias móveis de tempo de conexão TCP (sonda),
+ * tempo de handshake WebSocket, latência do health check HTTP e duração
+ * de sessão, mais um contador de falhas. O placar define a ordem de sondagem (melhor primeiro) e guarda
+ * o último host bom. Fica na memória RTC do usuário, que sobrevive a
+ * reset por software/WDT/brownout: no boot seguinte a placa conecta
+ * direto nesse host, sem rodada de sondas. Power-on (RTC sem conteúdo
+ * válido) ou mudança na lista de hosts zeram o placar.
+ *
+ * Pontuação (ms, menor é melhor): conexão + handshake + health + falhas x
+ * HOST_FAIL_PENALTY_MS - bônus por sessões longas. Host nunca medido
+ * fica com WS_PROBE_TIMEOUT_MS: depois dos bons, antes dos que falham.
+ *
+ * O gateway achado pela descoberta por broadcast (fora da lista) tem um
+ * slot próprio, índice DISCOVERED, chaveado pelo endereço e porta: outro
+ * endereço zera o slot. Ele também pode ser o último host bom; fica fora
+ * de ranking(), que ordena só a lista sondada.
+ */
+
+namespace HostScoreboard
+{
+    // Índice do slot do gateway descoberto (fora de qualquer lista de hosts)
+    const uint8_t DISCOVERED = 0xFE;
+
+    // Carrega o placar da RTC; inválido ou de outra lista de hosts = zerado
+    void begin(const char *const *hosts, size_t count);
+    bool restored(); // placar veio da RTC (reset a quente)
+
+    int lastGood(); // índice do último host com handshake completo (ou DISCOVERED); -1 = nenhum
+
+    // Ocupa o slot DISCOVERED com o gateway que respondeu à descoberta
+    void setDiscovered(const char *host, uint16_t port);
+    const char *discoveredHost(); // "" se o slot está vazio
+    uint16_t discoveredPort();
+
+    // Índices em ordem de pontuação (melhor primeiro); retorna quantos
+    size_t ranking(uint8_t *order, size_t capacity);
+    uint32_t score(size_t index);
+
+    void recordConnect(size_t index, uint32_t ms);   // sonda TCP aceita
+    void recordHandshake(size_t index, uint32_t ms); // WebSocket conectado (vira o último bom)
+    void recordHealth(size_t index, uint32_t ms);    // health check HTTP respondeu 200
+    void recordSession(size_t index, uint32_t seconds);
+    void recordFailure(size_t index); // sonda/health check sem sucesso ou handshake esgotado
+
+    void print();
+}
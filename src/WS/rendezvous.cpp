@@ -0,0 +1,79 @@
+#include "rendezvous.h"
+#include "../Config/config.h"
+
+namespace
+{
+    uint32_t fnv1a(const char *text, uint32_t hash)
+    {
+        for (const char *p = text; *p; p++)
+        {
+            hash = (hash ^ (uint8_t)*p) * 16777619UL;
+        }
+        return hash;
+    }
+
+    uint32_t fmix32(uint32_t h)
+    {
+        h ^= h >> 16;
+        h *= 0x85EBCA6BUL;
+        h ^= h >> 13;
+        h *= 0xC2B2AE35UL;
+        h ^= h >> 16;
+        return h;
+    }
+
+#if WS_HOST_SHARDING
+    // Entrada vazia (WS_HOST_STR não definido) nunca aceita conexão e só é pulada
+    constexpr bool shardableHosts()
+    {
+        for (const char *host : ALT_WS_HOSTS)
+        {
+            if (*host && !Rendezvous::isIpLiteral(host))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(shardableHosts(),
+                  "WS_HOST_SHARDING: a lista de hosts deve ter só IPs a.b.c.d (a descoberta pesa o IP de quem responde)");
+#endif
+}
+
+namespace Rendezvous
+{
+    uint32_t weight(const char *key, const char *host)
+    {
+        uint32_t hash = fnv1a(key ? key : "", 2166136261UL);
+        hash *= 16777619UL; // byte 0 entre os dois: "ab"+"c" != "a"+"bc"
+        return fmix32(fnv1a(host ? host : "", hash));
+    }
+
+    void order(const char *const *hosts, size_t count, const char *key, uint8_t *out)
+    {
+        uint32_t weights[WS_PROBE_MAX_HOSTS];
+        if (count > WS_PROBE_MAX_HOSTS)
+        {
+            count = WS_PROBE_MAX_HOSTS;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            out[i] = (uint8_t)i;
+            weights[i] = weight(key, hosts[i]);
+        }
+
+        // Inserção estável: listas curtas (WS_PROBE_MAX_HOSTS)
+        for (size_t i = 1; i < count; i++)
+        {
+            uint8_t current = out[i];
+            size_t j = i;
+            while (j > 0 && weights[out[j - 1]] < weights[current])
+            {
+                out[j] = out[j - 1];
+                j--;
+            }
+            out[j] = current;
+        }
+    }
+}
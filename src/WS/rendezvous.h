@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Rendezvous hashing (highest random weight) dos gateways por carro
+ *
+ * Cada par (carId, host) recebe um peso pseudoaleatório; o carro prefere
+ * os hosts em ordem decrescente de peso. Com vários gateways a frota se
+ * divide por igual, e se um gateway cai só os carros que o tinham em
+ * primeiro lugar mudam (para o segundo da própria lista); os demais não
+ * se mexem. A mesma função está em simulate-sharding.js.
+ *
+ * Peso: FNV-1a 32 bits de carId + '\0' + host, seguido do finalizador do
+ * MurmurHash3 (fmix32) para espalhar os bits.
+ *
+ * O peso é do texto do host: a descoberta por broadcast pesa o IP de quem
+ * respondeu ("a.b.c.d", sem zeros à esquerda) e a sondagem pesa a entrada
+ * da lista. Para os dois caminhos escolherem o mesmo gateway, com
+ * WS_HOST_SHARDING a lista só aceita IPs nessa forma (static_assert em
+ * rendezvous.cpp com isIpLiteral); nomes DNS não compilam.
+ */
+
+namespace Rendezvous
+{
+    uint32_t weight(const char *key, const char *host);
+
+    // Índices de 'hosts' do maior para o menor peso (empate: ordem da lista);
+    // no máximo WS_PROBE_MAX_HOSTS, como a busca de host
+    void order(const char *const *hosts, size_t count, const char *key, uint8_t *out);
+
+    // IPv4 pontuado como a descoberta escreve o endereço de origem
+    constexpr bool isIpLiteral(const char *host)
+    {
+        for (int octets = 1;; octets++)
+        {
+            int value = 0;
+            int digits = 0;
+            for (; *host >= '0' && *host <= '9'; host++)
+            {
+                if (digits == 3 || (digits > 0 && value == 0))
+                {
+                    return false; // octeto longo demais ou com zero à esquerda
+                }
+                value = value * 10 + (*host - '0');
+                digits++;
+            }
+            if (digits == 0 || value > 255)
+            {
+                return false;
+            }
+            if (*host == '\0')
+            {
+                return octets == 4;
+            }
+            if (*host != '.' || octets == 4)
+            {
+                return false;
+            }
+            host++;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#include "command_ack.h"
+#include "../Config/config.h"
+#include "../Protocol/messages.h"
+#include <sys/time.h>
+
+namespace
+{
+    // Janela circular dos últimos ids processados
+    struct Seen
+    {
+        uint32_t id;
+        Operation::ActionError result;
+        bool used;
+    };
+
+    Seen g_seen[CMD_DEDUPE_WINDOW];
+    uint8_t g_seenNext = 0;
+}
+
+namespace CommandAck
+{
+
+    bool isExpired(const Command &command)
+    {
+        if (command.ttlMs < 0 || command.issuedAt == 0)
+        {
+            return false;
+        }
+
+        struct timeval now;
+        gettimeofday(&now, nullptr);
+        if (now.tv_sec < 1600000000) // NTP ainda não sincronizou
+        {
+            return false;
+        }
+
+        int64_t ageMs = ((int64_t)now.tv_sec - (int64_t)command.issuedAt) * 1000 + now.tv_usec / 1000;
+        return ageMs > command.ttlMs;
+    }
+
+    bool lookup(uint32_t id, Operation::ActionError &result)
+    {
+        for (const Seen &seen : g_seen)
+        {
+            if (seen.used && seen.id == id)
+            {
+                result = seen.result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void remember(uint32_t id, Operation::ActionError result)
+    {
+        Seen &slot = g_seen[g_seenNext];
+        slot.id = id;
+        slot.result = result;
+        slot.used = true;
+        g_seenNext = (g_seenNext + 1) % CMD_DEDUPE_WINDOW;
+    }
+
+    uint32_t latencyUs(const Command &command)
+    {
+        return micros() - command.arrivedAtUs;
+    }
+
+    // ack e nack têm o mesmo layout; só o "type" muda
+    static Protocol::AckMsg describe(const Command &command, Operation::ActionError result, bool duplicate)
+    {
+        Protocol::AckMsg msg;
+        msg.id = command.id;
+        msg.result = Protocol::text(Operation::actionErrorToString(result));
+        msg.latencyUs = latencyUs(command);
+        msg.hasDuplicate = duplicate;
+        msg.duplicate = true;
+        return msg;
+    }
+
+    void build(Json::Writer &json, const Command &command, Operation::ActionError result, bool duplicate)
+    {
+        const Protocol::AckMsg msg = describe(command, result, duplicate);
+        if (result == Operation::ACTION_OK)
+        {
+            Protocol::encodeAck(msg, json);
+        }
+        else
+        {
+            Protocol::encodeNack(msg, json);
+        }
+    }
+
+    void build(MsgPack::Writer &msg, const Command &command, Operation::ActionError result, bool duplicate)
+    {
+        const Protocol::AckMsg ack = describe(command, result, duplicate);
+        if (result == Operation::ACTION_OK)
+        {
+            Protocol::encodeAck(ack, msg);
+        }
+        else
+        {
+            Protocol::encodeNack(ack, msg);
+        }
+    }
+}
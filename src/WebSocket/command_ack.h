@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+#include "../Operation/operation_manager.h"
+#include "../Json/json_writer.h"
+#include "../Json/msgpack_writer.h"
+
+/**
+ * Identificação, validade e confirmação de comandos
+ *
+ * Frames de comando podem trazer:
+ *   "id"  - inteiro único por comando (o gateway não deve reutilizar ids)
+ *   "ts"  - epoch em segundos em que o gateway emitiu o comando
+ *   "ttl" - validade em ms a partir de "ts"; vencido => nack "expired"
+ * Com "id", a placa responde {"type":"ack"|"nack","id":N,"result":...,
+ * "latencyUs":...} (chegada do frame -> aplicação). Os últimos
+ * CMD_DEDUPE_WINDOW ids ficam memorizados: um reenvio do mesmo id não é
+ * reaplicado, só recebe de novo o resultado original com "duplicate":true.
+ */
+
+namespace CommandAck
+{
+    struct Command
+    {
+        bool hasId = false;
+        uint32_t id = 0;
+        long ttlMs = -1;         // -1 = sem validade
+        uint32_t issuedAt = 0;   // "ts" (epoch s); 0 = ausente
+        uint32_t arrivedAtUs = 0; // micros() na chegada do frame
+    };
+
+    // Vencido pelo relógio NTP; sem "ts"/"ttl" ou sem NTP nunca vence
+    bool isExpired(const Command &command);
+
+    // true se o id já foi processado; 'result' recebe o resultado original
+    bool lookup(uint32_t id, Operation::ActionError &result);
+    void remember(uint32_t id, Operation::ActionError result);
+
+    uint32_t latencyUs(const Command &command);
+
+    // Frame ack/nack para um comando com id
+    void build(Json::Writer &json, const Command &command, Operation::ActionError result, bool duplicate);
+    void build(MsgPack::Writer &msg, const Command &command, Operation::ActionError result, bool duplicate);
+}
@@ -0,0 +1,487 @@
+#include "heartbeat.h"
+#include "../Config/config.h"
+#include "../Operation/operation_manager.h"
+#include "../Wifi/wifi.h"
+#include "../Reley/reley.h"
+#include "rate_limiter.h"
+#include "../Json/json_tokenizer.h"
+#include "../Json/msgpack_writer.h"
+#include "../Protocol/messages.h"
+
+namespace
+{
+    // Fragmentos constantes: resolvidos em compilação, ficam em flash
+    const char HB_HEAD[] PROGMEM = "{\"type\":\"heartbeat\",\"carId\":\"" CAR_ID_STR "\"";
+    const char HB_DELTA_HEAD[] PROGMEM = "{\"type\":\"heartbeat_delta\",\"carId\":\"" CAR_ID_STR "\"" JSON_KEY("seq");
+    const char HB_SEQ[] PROGMEM = JSON_KEY("seq");
+    const char HB_BASE[] PROGMEM = JSON_KEY("base");
+    const char HB_KEYFRAME_TAIL[] PROGMEM = JSON_KEY("keyframe") "true}";
+    const char HB_STATUS[] PROGMEM = JSON_KEY_STR("status");
+    const char HB_RELAY_ON[] PROGMEM = JSON_KEY("relayOn");
+    const char HB_RSSI[] PROGMEM = JSON_KEY("rssi");
+    const char HB_IP[] PROGMEM = JSON_KEY_STR("ip");
+    const char HB_UPTIME[] PROGMEM = JSON_KEY("uptimeSec");
+    const char HB_HEAP[] PROGMEM = JSON_KEY("heap");
+    const char HB_OPERATION_STATE[] PROGMEM = JSON_KEY_STR("operationState");
+    const char HB_REMAINING[] PROGMEM = JSON_KEY("remainingSeconds");
+    const char HB_EXTRA[] PROGMEM = JSON_KEY("extraSeconds");
+    const char HB_COUNTING_DOWN[] PROGMEM = JSON_KEY("isCountingDown");
+    const char HB_RATE_LIMITED[] PROGMEM = JSON_KEY("rateLimited");
+
+    // Pior caso (keyframe): fragmentos fixos + status/estado (24) + ip (15) + 9 números (11) + bools
+    static_assert(Json::literalLength(HB_HEAD) + Json::literalLength(HB_STATUS) + Json::literalLength(HB_RELAY_ON) +
+                          Json::literalLength(HB_RSSI) + Json::literalLength(HB_IP) + Json::literalLength(HB_UPTIME) +
+                          Json::literalLength(HB_HEAP) + Json::literalLength(HB_OPERATION_STATE) +
+                          Json::literalLength(HB_REMAINING) + Json::literalLength(HB_EXTRA) +
+                          Json::literalLength(HB_COUNTING_DOWN) + Json::literalLength(HB_RATE_LIMITED) +
+                          Json::literalLength(HB_SEQ) + Json::literalLength(HB_KEYFRAME_TAIL) + 2 * 24 + 15 +
+                          9 * 11 + 2 * 5 + 8 <
+                      WS_TX_BUFFER_SIZE,
+                  "WS_TX_BUFFER_SIZE pequeno demais para o heartbeat");
+
+    // Chaves MessagePack (mesmos nomes do JSON)
+    const char K_TYPE[] PROGMEM = "type";
+    const char K_CAR_ID[] PROGMEM = "carId";
+    const char K_SEQ[] PROGMEM = "seq";
+    const char K_BASE[] PROGMEM = "base";
+    const char K_KEYFRAME[] PROGMEM = "keyframe";
+    const char K_STATUS[] PROGMEM = "status";
+    const char K_RELAY_ON[] PROGMEM = "relayOn";
+    const char K_RSSI[] PROGMEM = "rssi";
+    const char K_IP[] PROGMEM = "ip";
+    const char K_UPTIME[] PROGMEM = "uptimeSec";
+    const char K_HEAP[] PROGMEM = "heap";
+    const char K_OPERATION_STATE[] PROGMEM = "operationState";
+    const char K_REMAINING[] PROGMEM = "remainingSeconds";
+    const char K_EXTRA[] PROGMEM = "extraSeconds";
+    const char K_COUNTING_DOWN[] PROGMEM = "isCountingDown";
+    const char K_RATE_LIMITED[] PROGMEM = "rateLimited";
+    const char V_HEARTBEAT[] PROGMEM = "heartbeat";
+    const char V_HEARTBEAT_DELTA[] PROGMEM = "heartbeat_delta";
+    const char V_CAR_ID[] PROGMEM = CAR_ID_STR;
+
+    enum Field : uint16_t
+    {
+        F_STATUS = 1 << 0,
+        F_RELAY = 1 << 1,
+        F_RSSI = 1 << 2,
+        F_IP = 1 << 3,
+        F_UPTIME = 1 << 4,
+        F_HEAP = 1 << 5,
+        F_OPERATION = 1 << 6,
+        F_REMAINING = 1 << 7,
+        F_EXTRA = 1 << 8,
+        F_COUNTING = 1 << 9,
+        F_RATE_LIMITED = 1 << 10, // só aparece depois da primeira recusa
+        F_ALL = 0x7FF
+    };
+
+    struct Snapshot
+    {
+        char status[24];
+        OperationStatus operation;
+        uint32_t ip;
+        uint32_t heap;
+        long rssi;
+        int remainingSeconds;
+        int extraSeconds;
+        uint32_t rateLimited;
+        bool relayOn;
+        bool countingDown;
+    };
+
+    // Próxima batida já decidida (tipo, campos e sequência), independente da codificação
+    struct Frame
+    {
+        Snapshot snap;
+        uint16_t mask;
+        Heartbeat::FrameKind kind;
+        uint32_t seq;
+        uint32_t base;
+    };
+
+    // Prefixo dos frames completos (type + carId + ip) já serializado nas duas
+    // codificações; carId é fixo e o IP quase nunca muda, então só é refeito
+    // quando o IP difere do guardado
+    const size_t PREFIX_SIZE = sizeof(HB_HEAD) + sizeof(HB_IP) + 16;
+
+    struct Prefix
+    {
+        bool valid;
+        uint32_t ip;
+        uint8_t jsonLength;
+        uint8_t msgLength;
+        char json[PREFIX_SIZE];
+        uint8_t msg[PREFIX_SIZE];
+    };
+
+    static_assert(PREFIX_SIZE <= 0xFF, "Prefixo do heartbeat guardado com tamanho em uint8_t");
+
+    Prefix g_prefix = {};
+
+    bool g_deltaMode = false;
+    uint16_t g_keyframeEvery = HB_KEYFRAME_EVERY;
+    uint16_t g_beatsSinceKeyframe = 0;
+    bool g_keyframePending = true;
+    uint32_t g_sequence = 0;
+    uint32_t g_keyframeSequence = 0;
+    Snapshot g_lastSent = {};
+
+    uint32_t freeHeap()
+    {
+#if defined(ESP8266) || defined(ESP32)
+        return ESP.getFreeHeap();
+#else
+        return 0;
+#endif
+    }
+
+    void capture(Snapshot &snap)
+    {
+        const OperationState &op = Operation::getState();
+        strncpy(snap.status, op.lastStatus.c_str(), sizeof(snap.status) - 1);
+        snap.status[sizeof(snap.status) - 1] = '\0';
+        snap.operation = op.status;
+        snap.ip = (uint32_t)Net::localIp();
+        snap.heap = freeHeap();
+        snap.rssi = Net::rssi();
+        snap.remainingSeconds = op.remainingSeconds;
+        snap.extraSeconds = op.extraSeconds;
+        snap.relayOn = Relay::isOn();
+        snap.countingDown = op.isCountingDown;
+        snap.rateLimited = RateLimiter::totalRejected();
+    }
+
+    // Campos presentes em um frame completo: sem recusas, o heartbeat fica igual ao histórico
+    uint16_t fullMask(const Snapshot &snap)
+    {
+        return snap.rateLimited ? F_ALL : (F_ALL & ~F_RATE_LIMITED);
+    }
+
+    long distance(long a, long b)
+    {
+        return a > b ? a - b : b - a;
+    }
+
+    // Campos que mudaram desde a última batida enviada (com zona morta para ruído)
+    uint16_t changedFields(const Snapshot &now, const Snapshot &last)
+    {
+        uint16_t mask = 0;
+        if (strcmp(now.status, last.status) != 0)
+            mask |= F_STATUS;
+        if (now.relayOn != last.relayOn)
+            mask |= F_RELAY;
+        if (distance(now.rssi, last.rssi) >= HB_RSSI_DEADBAND_DBM)
+            mask |= F_RSSI;
+        if (now.ip != last.ip)
+            mask |= F_IP;
+        if (distance((long)now.heap, (long)last.heap) >= HB_HEAP_DEADBAND_BYTES)
+            mask |= F_HEAP;
+        if (now.operation != last.operation)
+            mask |= F_OPERATION;
+        if (now.remainingSeconds != last.remainingSeconds)
+            mask |= F_REMAINING;
+        if (now.extraSeconds != last.extraSeconds)
+            mask |= F_EXTRA;
+        if (now.countingDown != last.countingDown)
+            mask |= F_COUNTING;
+        if (now.rateLimited != last.rateLimited)
+            mask |= F_RATE_LIMITED;
+        return mask;
+    }
+
+    void writeFields(Json::Writer &json, const Snapshot &snap, uint16_t mask, unsigned long now)
+    {
+        if (mask & F_STATUS)
+            json.raw(HB_STATUS).str(snap.status).put('"');
+        if (mask & F_RELAY)
+            json.raw(HB_RELAY_ON).boolean(snap.relayOn);
+        if (mask & F_RSSI)
+            json.raw(HB_RSSI).number(snap.rssi);
+        if (mask & F_IP)
+            json.raw(HB_IP).ip(IPAddress(snap.ip)).put('"');
+        if (mask & F_UPTIME)
+            json.raw(HB_UPTIME).number(now / 1000);
+        if (mask & F_HEAP)
+            json.raw(HB_HEAP).number((unsigned long)snap.heap);
+        if (mask & F_OPERATION)
+            json.raw(HB_OPERATION_STATE).str(statusToString(snap.operation)).put('"');
+        if (mask & F_REMAINING)
+            json.raw(HB_REMAINING).number(snap.remainingSeconds);
+        if (mask & F_EXTRA)
+            json.raw(HB_EXTRA).number(snap.extraSeconds);
+        if (mask & F_COUNTING)
+            json.raw(HB_COUNTING_DOWN).boolean(snap.countingDown);
+        if (mask & F_RATE_LIMITED)
+            json.raw(HB_RATE_LIMITED).number((unsigned long)snap.rateLimited);
+    }
+
+    void writeFields(MsgPack::Writer &msg, const Snapshot &snap, uint16_t mask, unsigned long now)
+    {
+        if (mask & F_STATUS)
+            msg.key(K_STATUS).str(snap.status);
+        if (mask & F_RELAY)
+            msg.key(K_RELAY_ON).boolean(snap.relayOn);
+        if (mask & F_RSSI)
+            msg.key(K_RSSI).number(snap.rssi);
+        if (mask & F_IP)
+            msg.key(K_IP).ip(IPAddress(snap.ip));
+        if (mask & F_UPTIME)
+            msg.key(K_UPTIME).number(now / 1000);
+        if (mask & F_HEAP)
+            msg.key(K_HEAP).number((unsigned long)snap.heap);
+        if (mask & F_OPERATION)
+            msg.key(K_OPERATION_STATE).str(statusToString(snap.operation));
+        if (mask & F_REMAINING)
+            msg.key(K_REMAINING).number(snap.remainingSeconds);
+        if (mask & F_EXTRA)
+            msg.key(K_EXTRA).number(snap.extraSeconds);
+        if (mask & F_COUNTING)
+            msg.key(K_COUNTING_DOWN).boolean(snap.countingDown);
+        if (mask & F_RATE_LIMITED)
+            msg.key(K_RATE_LIMITED).number((unsigned long)snap.rateLimited);
+    }
+
+    // Decide o tipo da próxima batida e avança o estado de sequência
+    void nextFrame(Frame &frame)
+    {
+        Snapshot &snap = frame.snap;
+        capture(snap);
+        frame.seq = 0;
+        frame.base = 0;
+
+        if (!g_deltaMode)
+        {
+            frame.kind = Heartbeat::FRAME_FULL;
+            frame.mask = fullMask(snap);
+            g_lastSent = snap;
+            return;
+        }
+
+        frame.seq = ++g_sequence;
+
+        if (g_keyframePending || g_beatsSinceKeyframe + 1 >= g_keyframeEvery)
+        {
+            frame.kind = Heartbeat::FRAME_KEYFRAME;
+            frame.mask = fullMask(snap);
+            g_keyframePending = false;
+            g_beatsSinceKeyframe = 0;
+            g_keyframeSequence = g_sequence;
+            g_lastSent = snap;
+            return;
+        }
+
+        uint16_t mask = changedFields(snap, g_lastSent);
+        frame.kind = Heartbeat::FRAME_DELTA;
+        frame.mask = mask;
+        frame.base = g_keyframeSequence;
+
+        // Só avança a referência dos campos enviados; os demais continuam comparando com o último valor reportado
+        if (mask & F_STATUS)
+            memcpy(g_lastSent.status, snap.status, sizeof(snap.status));
+        if (mask & F_RELAY)
+            g_lastSent.relayOn = snap.relayOn;
+        if (mask & F_RSSI)
+            g_lastSent.rssi = snap.rssi;
+        if (mask & F_IP)
+            g_lastSent.ip = snap.ip;
+        if (mask & F_HEAP)
+            g_lastSent.heap = snap.heap;
+        if (mask & F_OPERATION)
+            g_lastSent.operation = snap.operation;
+        if (mask & F_REMAINING)
+            g_lastSent.remainingSeconds = snap.remainingSeconds;
+        if (mask & F_EXTRA)
+            g_lastSent.extraSeconds = snap.extraSeconds;
+        if (mask & F_COUNTING)
+            g_lastSent.countingDown = snap.countingDown;
+        if (mask & F_RATE_LIMITED)
+            g_lastSent.rateLimited = snap.rateLimited;
+
+        g_beatsSinceKeyframe++;
+    }
+
+    const Prefix &prefixFor(uint32_t ip)
+    {
+        if (g_prefix.valid && g_prefix.ip == ip)
+        {
+            return g_prefix;
+        }
+
+        Json::Writer json(g_prefix.json, sizeof(g_prefix.json));
+        json.raw(HB_HEAD).raw(HB_IP).ip(IPAddress(ip)).put('"');
+
+        MsgPack::Writer msg(g_prefix.msg, sizeof(g_prefix.msg));
+        msg.key(K_TYPE).key(V_HEARTBEAT).key(K_CAR_ID).key(V_CAR_ID).key(K_IP).ip(IPAddress(ip));
+
+        g_prefix.ip = ip;
+        g_prefix.jsonLength = (uint8_t)json.length();
+        g_prefix.msgLength = (uint8_t)msg.length();
+        g_prefix.valid = !json.overflowed() && !msg.overflowed();
+        return g_prefix;
+    }
+
+    uint8_t countFields(uint16_t mask)
+    {
+        uint8_t n = 0;
+        for (; mask; mask &= mask - 1)
+        {
+            n++;
+        }
+        return n;
+    }
+}
+
+namespace Heartbeat
+{
+
+    void reset()
+    {
+        g_prefix.valid = false;
+        g_deltaMode = false;
+        g_keyframeEvery = HB_KEYFRAME_EVERY;
+        g_beatsSinceKeyframe = 0;
+        g_keyframePending = true;
+        g_sequence = 0;
+        g_keyframeSequence = 0;
+    }
+
+    void configure(bool delta, uint16_t keyframeEvery)
+    {
+        g_deltaMode = delta;
+        g_keyframeEvery = keyframeEvery ? keyframeEvery : HB_KEYFRAME_EVERY;
+        g_keyframePending = true;
+
+        if (LOG_VERBOSE)
+        {
+            Serial.print(F("[HB] Modo "));
+            Serial.print(delta ? F("DELTA, keyframe a cada ") : F("COMPLETO"));
+            if (delta)
+            {
+                Serial.print(g_keyframeEvery);
+            }
+            Serial.println();
+        }
+    }
+
+    void requestKeyframe()
+    {
+        g_keyframePending = true;
+    }
+
+    void handleModeMessage(const uint8_t *payload, size_t length, Json::Format format)
+    {
+        Protocol::HeartbeatModeMsg msg;
+        if (!Protocol::decodeHeartbeatMode(payload, length, format, msg))
+        {
+            Serial.println(F("[HB] heartbeat_mode inválido - ignorado"));
+            return;
+        }
+
+        const bool delta = msg.hasMode ? msg.mode.equals("delta") : g_deltaMode;
+        long keyframeEvery = msg.hasKeyframeEvery ? msg.keyframeEvery : 0;
+        if (keyframeEvery < 0 || keyframeEvery > 0xFFFF)
+        {
+            keyframeEvery = 0;
+        }
+        configure(delta, (uint16_t)keyframeEvery);
+    }
+
+    bool isDeltaMode()
+    {
+        return g_deltaMode;
+    }
+
+    uint32_t lastSequence()
+    {
+        return g_sequence;
+    }
+
+    FrameKind build(Json::Writer &json, unsigned long now)
+    {
+        Frame frame;
+        nextFrame(frame);
+
+        switch (frame.kind)
+        {
+        case FRAME_FULL:
+        case FRAME_KEYFRAME:
+        {
+            // ip já vai no prefixo
+            const Prefix &prefix = prefixFor(frame.snap.ip);
+            json.append(prefix.json, prefix.jsonLength);
+            writeFields(json, frame.snap, frame.mask & ~F_IP, now);
+            if (frame.kind == FRAME_FULL)
+            {
+                json.put('}');
+                break;
+            }
+            json.raw(HB_SEQ).number((unsigned long)frame.seq).raw(HB_KEYFRAME_TAIL);
+            break;
+        }
+
+        case FRAME_DELTA:
+            json.raw(HB_DELTA_HEAD).number((unsigned long)frame.seq);
+            json.raw(HB_BASE).number((unsigned long)frame.base);
+            writeFields(json, frame.snap, frame.mask, now);
+            json.put('}');
+            break;
+        }
+
+        return frame.kind;
+    }
+
+    FrameKind build(MsgPack::Writer &msg, unsigned long now)
+    {
+        Frame frame;
+        nextFrame(frame);
+
+        // type + carId + campos (+ seq/keyframe ou seq/base)
+        uint8_t entries = 2 + countFields(frame.mask) + (frame.kind == FRAME_FULL ? 0 : 2);
+        msg.map(entries);
+
+        uint16_t fields = frame.mask;
+        if (frame.kind == FRAME_DELTA)
+        {
+            msg.key(K_TYPE).key(V_HEARTBEAT_DELTA).key(K_CAR_ID).key(V_CAR_ID);
+        }
+        else
+        {
+            // type + carId + ip já serializados
+            const Prefix &prefix = prefixFor(frame.snap.ip);
+            msg.append(prefix.msg, prefix.msgLength);
+            fields &= ~F_IP;
+        }
+
+        if (frame.kind != FRAME_FULL)
+        {
+            msg.key(K_SEQ).number((unsigned long)frame.seq);
+            if (frame.kind == FRAME_KEYFRAME)
+            {
+                msg.key(K_KEYFRAME).boolean(true);
+            }
+            else
+            {
+                msg.key(K_BASE).number((unsigned long)frame.base);
+            }
+        }
+
+        writeFields(msg, frame.snap, fields, now);
+        return frame.kind;
+    }
+
+    const char *kindToString(FrameKind kind)
+    {
+        switch (kind)
+        {
+        case FRAME_FULL:
+            return "FULL";
+        case FRAME_KEYFRAME:
+            return "KEYFRAME";
+        case FRAME_DELTA:
+            return "DELTA";
+        default:
+            return "UNKNOWN";
+        }
+    }
+}
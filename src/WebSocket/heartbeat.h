@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+#include "../Json/json_writer.h"
+#include "../Json/msgpack_writer.h"
+#include "../Json/json_tokenizer.h"
+
+/**
+ * Serialização do heartbeat
+ *
+ * Modo completo (padrão): frame "heartbeat" idêntico ao histórico.
+ * Modo delta (opt-in do gateway via {"type":"heartbeat_mode","mode":"delta"}):
+ *   - a cada N batidas envia um keyframe: heartbeat completo + "seq" + "keyframe":true
+ *   - entre keyframes envia "heartbeat_delta" só com os campos que mudaram
+ *     desde a batida anterior, mais "seq" e "base" (seq do último keyframe)
+ * O gateway detecta perda pelo salto de "seq" e pede novo keyframe com
+ * {"type":"heartbeat_keyframe"} ou reenviando heartbeat_mode.
+ */
+
+namespace Heartbeat
+{
+    enum FrameKind : uint8_t
+    {
+        FRAME_FULL = 0, // formato histórico, sem seq
+        FRAME_KEYFRAME,
+        FRAME_DELTA
+    };
+
+    // Nova sessão WebSocket: volta ao modo completo até o gateway optar de novo
+    void reset();
+
+    // Liga/desliga o modo delta; keyframeEvery = 0 usa HB_KEYFRAME_EVERY
+    void configure(bool delta, uint16_t keyframeEvery);
+
+    // Força keyframe na próxima batida
+    void requestKeyframe();
+
+    // Processa {"type":"heartbeat_mode",...} vindo do gateway
+    void handleModeMessage(const uint8_t *payload, size_t length, Json::Format format = Json::FORMAT_JSON);
+
+    bool isDeltaMode();
+    uint32_t lastSequence();
+
+    // Serializa a próxima batida e retorna o tipo gerado
+    FrameKind build(Json::Writer &json, unsigned long now);
+    FrameKind build(MsgPack::Writer &msg, unsigned long now);
+
+    const char *kindToString(FrameKind kind);
+}
@@ -0,0 +1,105 @@
+#include "inbound_queue.h"
+#include "../Config/config.h"
+
+namespace
+{
+    struct Slot
+    {
+        uint16_t length;
+        Json::Format format;
+        uint32_t arrivedAtUs;
+        uint8_t data[WS_INQ_SLOT_SIZE];
+    };
+
+    // Anel: g_head = próximo a executar, g_count = ocupados
+    Slot g_slots[WS_INQ_SLOTS];
+    uint8_t g_head = 0;
+    uint8_t g_count = 0;
+    InboundQueue::Stats g_stats;
+}
+
+namespace InboundQueue
+{
+
+    PushResult push(const uint8_t *payload, size_t length, Json::Format format, uint32_t arrivedAtUs)
+    {
+        if (length > WS_INQ_SLOT_SIZE)
+        {
+            g_stats.rejected++;
+            return PUSH_TOO_LARGE;
+        }
+
+        if (g_count >= WS_INQ_SLOTS)
+        {
+            g_stats.rejected++;
+            return PUSH_FULL;
+        }
+
+        Slot &slot = g_slots[(g_head + g_count) % WS_INQ_SLOTS];
+        slot.length = (uint16_t)length;
+        slot.format = format;
+        slot.arrivedAtUs = arrivedAtUs;
+        memcpy(slot.data, payload, length);
+
+        g_count++;
+        g_stats.queued++;
+        if (g_count > g_stats.maxDepth)
+        {
+            g_stats.maxDepth = g_count;
+        }
+        return PUSH_QUEUED;
+    }
+
+    bool peek(Frame &frame)
+    {
+        if (g_count == 0)
+        {
+            return false;
+        }
+
+        const Slot &slot = g_slots[g_head];
+        frame.data = slot.data;
+        frame.length = slot.length;
+        frame.format = slot.format;
+        frame.arrivedAtUs = slot.arrivedAtUs;
+        return true;
+    }
+
+    void pop()
+    {
+        if (g_count == 0)
+        {
+            return;
+        }
+
+        g_head = (g_head + 1) % WS_INQ_SLOTS;
+        g_count--;
+        g_stats.executed++;
+    }
+
+    void noteDeferred()
+    {
+        g_stats.deferred++;
+    }
+
+    size_t size()
+    {
+        return g_count;
+    }
+
+    bool empty()
+    {
+        return g_count == 0;
+    }
+
+    void clear()
+    {
+        g_head = 0;
+        g_count = 0;
+    }
+
+    const Stats &stats()
+    {
+        return g_stats;
+    }
+}
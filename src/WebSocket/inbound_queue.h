@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+#include "../Json/json_tokenizer.h"
+
+/**
+ * Fila de comandos recebidos (memória fixa, FIFO)
+ *
+ * onEvent roda dentro de g_webSocket.loop(): ali os frames de comando
+ * ("action"/"actions") só são copiados para cá. A execução acontece em uma
+ * etapa própria do loop (WebSocketManager::processCommands), com orçamento
+ * de tempo por iteração, então um comando demorado não segura PONGs,
+ * keepalive nem o display.
+ * O payload é copiado porque o buffer da biblioteca só vale durante o evento.
+ * Na desconexão a fila é esvaziada: o ack de um comando só vale na sessão
+ * em que ele chegou, e o gateway reenvia o id.
+ */
+
+namespace InboundQueue
+{
+    enum PushResult : uint8_t
+    {
+        PUSH_QUEUED = 0,
+        PUSH_FULL,     // todos os slots ocupados
+        PUSH_TOO_LARGE // frame maior que WS_INQ_SLOT_SIZE
+    };
+
+    // Frame na frente da fila; 'data' vale até pop()
+    struct Frame
+    {
+        const uint8_t *data;
+        size_t length;
+        Json::Format format;
+        uint32_t arrivedAtUs; // micros() na chegada (latência do ack)
+    };
+
+    struct Stats
+    {
+        uint32_t queued = 0;
+        uint32_t executed = 0;
+        uint32_t rejected = 0; // fila cheia ou frame grande demais
+        uint32_t deferred = 0; // iterações que pararam por orçamento com comandos na fila
+        uint8_t maxDepth = 0;
+    };
+
+    PushResult push(const uint8_t *payload, size_t length, Json::Format format, uint32_t arrivedAtUs);
+
+    bool peek(Frame &frame);
+    void pop();
+
+    void noteDeferred();
+
+    size_t size();
+    bool empty();
+    void clear();
+    const Stats &stats();
+}
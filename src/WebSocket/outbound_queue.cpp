@@ -0,0 +1,307 @@
+#include "outbound_queue.h"
+#include "../Config/config.h"
+
+namespace
+{
+    struct Slot
+    {
+        bool used;
+        bool binary;
+        bool held; // já contado como segurado por falta de espaço TCP
+        OutboundQueue::Kind kind;
+        OutboundQueue::Priority priority;
+        uint16_t length;
+        uint32_t order; // ordem de chegada (FIFO dentro da mesma prioridade)
+    };
+
+    static_assert(WS_OUTQ_SLOTS > 0, "A fila de saída precisa de ao menos um slot de frame cheio");
+    static_assert(WS_OUTQ_SMALL_SIZE <= WS_OUTQ_SLOT_SIZE, "Slot curto maior que o slot cheio");
+
+    // Os WS_OUTQ_SLOTS primeiros slots guardam frames até WS_OUTQ_SLOT_SIZE
+    // (hello, heartbeat, telemetria, diário); os demais só frames curtos
+    // (acks, status), sem reservar um buffer de frame cheio para cada um
+    const size_t SLOT_COUNT = WS_OUTQ_SLOTS + WS_OUTQ_SMALL_SLOTS;
+    Slot g_slots[SLOT_COUNT];
+    uint8_t g_large[WS_OUTQ_SLOTS][WS_OUTQ_SLOT_SIZE];
+    uint8_t g_small[WS_OUTQ_SMALL_SLOTS > 0 ? WS_OUTQ_SMALL_SLOTS : 1][WS_OUTQ_SMALL_SIZE];
+    uint32_t g_nextOrder = 0;
+    unsigned long g_nextSendAt = 0;
+    bool g_congested = false;
+    OutboundQueue::Stats g_stats;
+
+    // Cabeçalho de frame do cliente: 2-4 bytes + máscara de 4 (frames < 64 KB)
+    const size_t FRAME_OVERHEAD = 8;
+
+    size_t indexOf(const Slot &slot)
+    {
+        return (size_t)(&slot - g_slots);
+    }
+
+    uint8_t *dataOf(const Slot &slot)
+    {
+        size_t i = indexOf(slot);
+        return i < WS_OUTQ_SLOTS ? g_large[i] : g_small[i - WS_OUTQ_SLOTS];
+    }
+
+    size_t capacityOf(const Slot &slot)
+    {
+        return indexOf(slot) < WS_OUTQ_SLOTS ? WS_OUTQ_SLOT_SIZE : WS_OUTQ_SMALL_SIZE;
+    }
+
+    bool coalesces(OutboundQueue::Kind kind)
+    {
+        return kind == OutboundQueue::KIND_HELLO || kind == OutboundQueue::KIND_STATUS ||
+               kind == OutboundQueue::KIND_HEARTBEAT || kind == OutboundQueue::KIND_TELEMETRY;
+    }
+
+    void store(Slot &slot, OutboundQueue::Kind kind, OutboundQueue::Priority priority,
+               const uint8_t *data, size_t length, bool binary)
+    {
+        slot.used = true;
+        slot.binary = binary;
+        slot.held = false;
+        slot.kind = kind;
+        slot.priority = priority;
+        slot.length = (uint16_t)length;
+        slot.order = g_nextOrder++;
+        memcpy(dataOf(slot), data, length);
+    }
+
+    // Próximo a enviar: maior prioridade, depois o mais antigo
+    Slot *front()
+    {
+        Slot *best = nullptr;
+        for (Slot &slot : g_slots)
+        {
+            if (!slot.used)
+                continue;
+            if (!best || slot.priority < best->priority ||
+                (slot.priority == best->priority && slot.order < best->order))
+            {
+                best = &slot;
+            }
+        }
+        return best;
+    }
+
+    // Slot livre onde o frame cabe; frames curtos ocupam primeiro os slots curtos
+    Slot *freeSlot(size_t length)
+    {
+        Slot *best = nullptr;
+        for (Slot &slot : g_slots)
+        {
+            if (!slot.used && capacityOf(slot) >= length && (!best || capacityOf(slot) < capacityOf(*best)))
+            {
+                best = &slot;
+            }
+        }
+        return best;
+    }
+
+    // Candidato a despejo entre os slots onde o frame cabe: menor prioridade,
+    // depois o mais antigo
+    Slot *victim(size_t length)
+    {
+        Slot *worst = nullptr;
+        for (Slot &slot : g_slots)
+        {
+            if (!slot.used || capacityOf(slot) < length)
+                continue;
+            if (!worst || slot.priority > worst->priority ||
+                (slot.priority == worst->priority && slot.order < worst->order))
+            {
+                worst = &slot;
+            }
+        }
+        return worst;
+    }
+}
+
+namespace OutboundQueue
+{
+
+    PushResult push(Kind kind, Priority priority, const uint8_t *data, size_t length, bool binary)
+    {
+        if (length > WS_OUTQ_SLOT_SIZE)
+        {
+            g_stats.dropped++;
+            Serial.print(F("[OUTQ][ERRO] Frame de "));
+            Serial.print(length);
+            Serial.println(F(" bytes maior que WS_OUTQ_SLOT_SIZE - descartado"));
+            return PUSH_DROPPED;
+        }
+
+        // Versão mais nova substitui a anterior do mesmo tipo, no mesmo slot se couber
+        Slot *previous = nullptr;
+        if (coalesces(kind))
+        {
+            for (Slot &slot : g_slots)
+            {
+                if (slot.used && slot.kind == kind)
+                {
+                    previous = &slot;
+                    break;
+                }
+            }
+        }
+
+        if (previous && capacityOf(*previous) >= length)
+        {
+            if (previous->held && kind == KIND_HEARTBEAT)
+            {
+                g_stats.heartbeatsMerged++;
+            }
+            store(*previous, kind, priority, data, length, binary);
+            g_stats.coalesced++;
+            return PUSH_COALESCED;
+        }
+
+        Slot *target = freeSlot(length);
+        if (!target)
+        {
+            target = victim(length);
+            if (!target || target->priority < priority)
+            {
+                g_stats.dropped++;
+                return PUSH_DROPPED;
+            }
+
+            if (LOG_VERBOSE)
+            {
+                Serial.print(F("[OUTQ] Fila cheia - descartando frame prio="));
+                Serial.println(target->priority);
+            }
+            g_stats.dropped++;
+        }
+
+        // A versão anterior estava em um slot curto demais para a nova
+        if (previous)
+        {
+            if (previous->held && kind == KIND_HEARTBEAT)
+            {
+                g_stats.heartbeatsMerged++;
+            }
+            previous->used = false;
+            store(*target, kind, priority, data, length, binary);
+            g_stats.coalesced++;
+            return PUSH_COALESCED;
+        }
+
+        store(*target, kind, priority, data, length, binary);
+        g_stats.queued++;
+        return PUSH_QUEUED;
+    }
+
+    void drain(SendFn send, unsigned long now, size_t txFree)
+    {
+        g_stats.txFree = txFree;
+        if (txFree < g_stats.txFreeMin)
+        {
+            g_stats.txFreeMin = txFree;
+        }
+
+        if ((long)(now - g_nextSendAt) < 0)
+        {
+            return;
+        }
+
+        Slot *slot = front();
+        if (!slot)
+        {
+            g_congested = false;
+            return;
+        }
+
+        // Sem espaço no buffer TCP a escrita bloquearia o loop: espera esvaziar.
+        // O pacing não é reiniciado, então o frame sai assim que couber.
+        size_t needed = slot->length + FRAME_OVERHEAD;
+        if (slot->priority == PRIO_HEARTBEAT)
+        {
+            needed += WS_TX_RESERVE_BYTES;
+        }
+
+        if (txFree < needed)
+        {
+            if (!slot->held)
+            {
+                slot->held = true;
+                if (slot->priority == PRIO_HEARTBEAT)
+                {
+                    g_stats.heartbeatsHeld++;
+                }
+                else
+                {
+                    g_stats.deferred++;
+                }
+            }
+            g_congested = true;
+            return;
+        }
+        g_congested = false;
+
+        if (!send(dataOf(*slot), slot->length, slot->binary))
+        {
+            // Mantém o frame e tenta de novo no próximo intervalo
+            g_stats.sendFailures++;
+            g_nextSendAt = now + WS_OUTQ_PACING_MS;
+            return;
+        }
+
+        slot->used = false;
+        g_stats.sent++;
+        g_nextSendAt = now + WS_OUTQ_PACING_MS;
+    }
+
+    void onConnected(unsigned long now)
+    {
+        g_nextSendAt = now;
+        g_congested = false;
+    }
+
+    bool congested()
+    {
+        return g_congested;
+    }
+
+    void discardSessionFrames()
+    {
+        for (Slot &slot : g_slots)
+        {
+            if (!slot.used)
+                continue;
+            if (slot.kind == KIND_HELLO || slot.kind == KIND_STATUS || slot.kind == KIND_HEARTBEAT ||
+                slot.kind == KIND_JOURNAL || slot.kind == KIND_ACK || slot.binary)
+            {
+                slot.used = false;
+            }
+        }
+    }
+
+    size_t size()
+    {
+        size_t n = 0;
+        for (const Slot &slot : g_slots)
+        {
+            n += slot.used ? 1 : 0;
+        }
+        return n;
+    }
+
+    bool empty()
+    {
+        return size() == 0;
+    }
+
+    void clear()
+    {
+        for (Slot &slot : g_slots)
+        {
+            slot.used = false;
+        }
+    }
+
+    const Stats &stats()
+    {
+        return g_stats;
+    }
+}
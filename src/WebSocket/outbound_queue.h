@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Fila de saída do WebSocket (memória fixa)
+ *
+ * Todo frame serializado passa por aqui antes de sendTXT/sendBIN:
+ * - prioridade: comandos/acks > status > heartbeat
+ * - coalescência: para hello, status, heartbeat e telemetria só a versão mais recente
+ *   fica na fila (a anterior é substituída no mesmo slot)
+ * - fila cheia: descarta o item mais antigo de prioridade mais baixa,
+ *   ou o novo se todos os enfileirados forem mais importantes
+ * - drenagem com espaçamento (WS_OUTQ_PACING_MS) para não inundar o
+ *   gateway na rajada de reconexão
+ * - controle de fluxo: um frame só sai se couber no buffer de envio TCP
+ *   (lwIP); heartbeat ainda exige WS_TX_RESERVE_BYTES livres além dele,
+ *   então com o link lento ele espera na fila e é mesclado com o próximo
+ *   enquanto comandos e status continuam passando
+ * - memória: WS_OUTQ_SLOTS slots de frame cheio e WS_OUTQ_SMALL_SLOTS slots
+ *   curtos (WS_OUTQ_SMALL_SIZE) para acks e status; frame curto ocupa primeiro
+ *   um slot curto
+ * Enquanto o socket está fora, os frames ficam retidos em vez de perdidos.
+ */
+
+namespace OutboundQueue
+{
+    enum Priority : uint8_t
+    {
+        PRIO_COMMAND = 0, // comandos, acks e hello (abre a sessão)
+        PRIO_STATUS,
+        PRIO_HEARTBEAT,
+        PRIO_COUNT
+    };
+
+    enum Kind : uint8_t
+    {
+        KIND_OTHER = 0, // nunca coalesce
+        KIND_ACK,       // nunca coalesce
+        KIND_JOURNAL,   // nunca coalesce (lote de replay do diário)
+        KIND_HELLO,
+        KIND_STATUS,
+        KIND_HEARTBEAT,
+        KIND_TELEMETRY // janela agregada; a mais recente substitui a pendente
+    };
+
+    enum PushResult : uint8_t
+    {
+        PUSH_QUEUED = 0,
+        PUSH_COALESCED, // substituiu uma versão anterior do mesmo tipo
+        PUSH_DROPPED    // sem espaço ou frame maior que o slot
+    };
+
+    struct Stats
+    {
+        uint32_t queued = 0;
+        uint32_t sent = 0;
+        uint32_t coalesced = 0;
+        uint32_t dropped = 0;
+        uint32_t sendFailures = 0;
+        uint32_t deferred = 0;         // frames que esperaram espaço no buffer TCP
+        uint32_t heartbeatsHeld = 0;   // heartbeats segurados para reservar espaço
+        uint32_t heartbeatsMerged = 0; // heartbeats segurados substituídos pelo próximo
+        size_t txFree = 0;             // último espaço livre no buffer TCP
+        size_t txFreeMin = SIZE_MAX;   // menor espaço livre visto
+    };
+
+    // Função de envio efetivo (sendTXT/sendBIN); false se a biblioteca recusou
+    typedef bool (*SendFn)(const uint8_t *data, size_t length, bool binary);
+
+    PushResult push(Kind kind, Priority priority, const uint8_t *data, size_t length, bool binary);
+
+    // Envia no máximo um frame, respeitando o espaçamento mínimo e o espaço
+    // livre no buffer de envio TCP (txFree, em bytes)
+    void drain(SendFn send, unsigned long now, size_t txFree);
+
+    // true se o último frame que tentou sair esbarrou no buffer TCP
+    bool congested();
+
+    // Reinicia o espaçamento ao abrir uma nova sessão
+    void onConnected(unsigned long now);
+
+    // Remove frames que não fazem sentido em outra sessão: hello, status e heartbeat
+    // (o estado atual segue no frame de abertura da próxima), o lote do diário
+    // (Journal::onConnected refaz o replay a partir do último journal_ack), acks
+    // da sessão anterior (o gateway reenvia o id e recebe o ack com "duplicate")
+    // e binários.
+    void discardSessionFrames();
+
+    size_t size();
+    bool empty();
+    void clear();
+    const Stats &stats();
+}
@@ -0,0 +1,125 @@
+#include "rate_limiter.h"
+#include "../Config/config.h"
+
+namespace
+{
+    struct Bucket
+    {
+        uint32_t milliTokens; // fichas x 1000 (reabastecimento sem ponto flutuante)
+        unsigned long refilledAt;
+        uint32_t rejected;
+        bool limiting; // já avisou no Serial desde a última aceitação
+    };
+
+    struct Limit
+    {
+        uint16_t perSecond;
+        uint16_t burst;
+    };
+
+    const Limit LIMITS[RateLimiter::CAT_COUNT] = {
+        {RL_OPERATION_PER_S, RL_OPERATION_BURST},
+        {RL_HC595_PER_S, RL_HC595_BURST},
+        {RL_MESSAGE_PER_S, RL_MESSAGE_BURST},
+    };
+
+    Bucket g_buckets[RateLimiter::CAT_COUNT] = {};
+    bool g_started = false;
+
+    void refill(Bucket &bucket, const Limit &limit, unsigned long now)
+    {
+        // perSecond fichas/s == perSecond mili-fichas/ms
+        uint32_t elapsed = now - bucket.refilledAt;
+        uint32_t capacity = (uint32_t)limit.burst * 1000;
+        uint32_t gained = elapsed * limit.perSecond;
+
+        if (elapsed >= capacity || gained >= capacity - bucket.milliTokens)
+        {
+            bucket.milliTokens = capacity;
+        }
+        else
+        {
+            bucket.milliTokens += gained;
+        }
+        bucket.refilledAt = now;
+    }
+}
+
+namespace RateLimiter
+{
+
+    bool allow(Category category, uint8_t cost, unsigned long now)
+    {
+        if (category >= CAT_COUNT)
+        {
+            return false;
+        }
+
+        if (!g_started)
+        {
+            reset(now);
+        }
+
+        Bucket &bucket = g_buckets[category];
+        refill(bucket, LIMITS[category], now);
+
+        uint32_t needed = (uint32_t)cost * 1000;
+        if (bucket.milliTokens >= needed)
+        {
+            bucket.milliTokens -= needed;
+            bucket.limiting = false;
+            return true;
+        }
+
+        bucket.rejected++;
+        if (!bucket.limiting)
+        {
+            bucket.limiting = true;
+            Serial.print(F("[RL] Limite de "));
+            Serial.print(categoryToString(category));
+            Serial.println(F(" atingido - frames recusados até reabastecer"));
+        }
+        return false;
+    }
+
+    uint32_t rejected(Category category)
+    {
+        return category < CAT_COUNT ? g_buckets[category].rejected : 0;
+    }
+
+    uint32_t totalRejected()
+    {
+        uint32_t total = 0;
+        for (const Bucket &bucket : g_buckets)
+        {
+            total += bucket.rejected;
+        }
+        return total;
+    }
+
+    void reset(unsigned long now)
+    {
+        for (uint8_t i = 0; i < CAT_COUNT; i++)
+        {
+            g_buckets[i].milliTokens = (uint32_t)LIMITS[i].burst * 1000;
+            g_buckets[i].refilledAt = now;
+            g_buckets[i].limiting = false;
+        }
+        g_started = true;
+    }
+
+    const char *categoryToString(Category category)
+    {
+        switch (category)
+        {
+        case CAT_OPERATION:
+            return "operation";
+        case CAT_HC595:
+            return "hc595";
+        case CAT_MESSAGE:
+            return "message";
+        default:
+            return "unknown";
+        }
+    }
+}
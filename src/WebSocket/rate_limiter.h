@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Limite de taxa dos frames recebidos (token bucket por categoria)
+ *
+ * Cada categoria tem um balde com capacidade RL_<CAT>_BURST fichas,
+ * reabastecido a RL_<CAT>_PER_S fichas por segundo. Um frame consome uma
+ * ficha por ação (lotes consomem o número de ações); sem fichas ele é
+ * recusado antes de chegar a handleAction, então uma rajada do gateway
+ * (ou um replay em massa) não toma o loop do contador e do display.
+ * As recusas são contadas por categoria e o total segue no heartbeat.
+ */
+
+namespace RateLimiter
+{
+    enum Category : uint8_t
+    {
+        CAT_OPERATION = 0, // start/stop/pause/..., session_data, status do gateway
+        CAT_HC595,         // hc595_*
+        CAT_MESSAGE,       // demais mensagens (caps_select, heartbeat_mode, acks...)
+        CAT_COUNT
+    };
+
+    // Consome 'cost' fichas se houver; false = frame deve ser recusado
+    bool allow(Category category, uint8_t cost, unsigned long now);
+
+    uint32_t rejected(Category category);
+    uint32_t totalRejected();
+
+    // Enche todos os baldes (nova sessão ou testes)
+    void reset(unsigned long now);
+
+    const char *categoryToString(Category category);
+}
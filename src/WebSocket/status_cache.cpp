@@ -0,0 +1,109 @@
+#include "status_cache.h"
+#include "../Config/config.h"
+#include "../Json/json_writer.h"
+#include "../Json/msgpack_writer.h"
+#include "../Protocol/messages.h"
+
+namespace
+{
+    // Status até StatusMsg::STATUS_MAX caracteres (limite do esquema) sempre cabe em um slot
+    const size_t STATUS_MAX = Protocol::StatusMsg::STATUS_MAX;
+    static_assert(Json::literalLength("{\"type\":\"status\",\"carId\":\"" CAR_ID_STR "\",\"status\":\"\",\"relayOn\":false}") +
+                          STATUS_MAX <
+                      STATUS_CACHE_FRAME_SIZE,
+                  "STATUS_CACHE_FRAME_SIZE pequeno demais para o frame status");
+    static_assert(STATUS_CACHE_FRAME_SIZE <= 0xFF, "Tamanho do slot guardado em uint8_t");
+
+    struct Slot
+    {
+        bool used;
+        bool relayOn;
+        Json::Format format;
+        uint8_t length;
+        char status[STATUS_MAX + 1];
+        uint8_t frame[STATUS_CACHE_FRAME_SIZE];
+    };
+
+    Slot g_slots[STATUS_CACHE_SLOTS] = {};
+    uint8_t g_nextVictim = 0;
+    StatusCache::Stats g_stats;
+
+    size_t serialize(const char *status, bool relayOn, Json::Format format, uint8_t *buffer, size_t capacity)
+    {
+        Protocol::StatusMsg msg;
+        msg.status = Protocol::text(status);
+        msg.relayOn = relayOn;
+
+        if (format == Json::FORMAT_MSGPACK)
+        {
+            MsgPack::Writer out(buffer, capacity);
+            return Protocol::encodeStatus(msg, out) ? out.length() : 0;
+        }
+
+        Json::Writer json(reinterpret_cast<char *>(buffer), capacity);
+        return Protocol::encodeStatus(msg, json) ? json.length() : 0;
+    }
+}
+
+namespace StatusCache
+{
+    bool lookup(const char *status, bool relayOn, Json::Format format,
+                uint8_t *scratch, size_t scratchSize,
+                const uint8_t *&data, size_t &length)
+    {
+        for (Slot &slot : g_slots)
+        {
+            if (slot.used && slot.relayOn == relayOn && slot.format == format && strcmp(slot.status, status) == 0)
+            {
+                g_stats.hits++;
+                data = slot.frame;
+                length = slot.length;
+                return true;
+            }
+        }
+
+        // Serializa em 'scratch' primeiro: o slot da vez só é sobrescrito se o
+        // frame novo couber nele, senão a entrada válida continua no cache
+        length = serialize(status, relayOn, format, scratch, scratchSize);
+        data = scratch;
+        if (length == 0)
+        {
+            g_stats.bypass++;
+            return false;
+        }
+
+        // Status longo (ou com escapes) demais para um slot: entrega sem guardar
+        if (strlen(status) > STATUS_MAX || length > STATUS_CACHE_FRAME_SIZE)
+        {
+            g_stats.bypass++;
+            return true;
+        }
+
+        Slot &slot = g_slots[g_nextVictim];
+        memcpy(slot.frame, scratch, length);
+        g_nextVictim = (g_nextVictim + 1) % STATUS_CACHE_SLOTS;
+        g_stats.misses++;
+        slot.used = true;
+        slot.relayOn = relayOn;
+        slot.format = format;
+        slot.length = (uint8_t)length;
+        strcpy(slot.status, status);
+
+        data = slot.frame;
+        return true;
+    }
+
+    void invalidate()
+    {
+        for (Slot &slot : g_slots)
+        {
+            slot.used = false;
+        }
+        g_nextVictim = 0;
+    }
+
+    const Stats &stats()
+    {
+        return g_stats;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+#include "../Json/json_tokenizer.h"
+
+/**
+ * Cache de frames "status" já serializados
+ *
+ * Um frame status só depende de (status, relayOn, codificação) — carId é
+ * fixo — então há poucas combinações distintas. Cada uma é serializada na
+ * primeira publicação e guardada em um slot fixo (STATUS_CACHE_SLOTS x
+ * STATUS_CACHE_FRAME_SIZE); as seguintes só entregam ponteiro e tamanho.
+ * Slots são reaproveitados em rodízio. invalidate() descarta tudo quando a
+ * identidade anunciada muda (nova sessão).
+ */
+
+namespace StatusCache
+{
+    struct Stats
+    {
+        uint32_t hits = 0;
+        uint32_t misses = 0;  // serializados e guardados
+        uint32_t bypass = 0;  // grandes demais para um slot (serializados sem cache)
+    };
+
+    // Frame pronto para (status, relayOn, format). Sem slot possível, serializa
+    // em 'scratch' (buffer do chamador). false = não coube nem em 'scratch'.
+    bool lookup(const char *status, bool relayOn, Json::Format format,
+                uint8_t *scratch, size_t scratchSize,
+                const uint8_t *&data, size_t &length);
+
+    void invalidate();
+
+    const Stats &stats();
+}
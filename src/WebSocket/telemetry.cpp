@@ -0,0 +1,265 @@
+#include "telemetry.h"
+#include "../Config/config.h"
+#include "../Wifi/wifi.h"
+
+namespace
+{
+    // Fragmentos constantes: resolvidos em compilação, ficam em flash
+    const char TM_HEAD[] PROGMEM = "{\"type\":\"telemetry\",\"carId\":\"" CAR_ID_STR "\"" JSON_KEY("seq");
+    const char TM_SAMPLES[] PROGMEM = JSON_KEY("samples");
+    const char TM_RSSI[] PROGMEM = JSON_KEY("rssi") "[";
+    const char TM_HEAP[] PROGMEM = JSON_KEY("heap") "[";
+    const char TM_MAX_BLOCK[] PROGMEM = JSON_KEY("maxBlock") "[";
+    const char TM_LOOP_US[] PROGMEM = JSON_KEY("loopUs") "[";
+    const char TM_RTT_MS[] PROGMEM = JSON_KEY("rttMs") "[";
+
+    // Pior caso: cabeçalho + seq/samples (11) + 5 métricas com 4 números (11) e separadores
+    static_assert(Json::literalLength(TM_HEAD) + Json::literalLength(TM_SAMPLES) + Json::literalLength(TM_RSSI) +
+                          Json::literalLength(TM_HEAP) + Json::literalLength(TM_MAX_BLOCK) +
+                          Json::literalLength(TM_LOOP_US) + Json::literalLength(TM_RTT_MS) + 2 * 11 +
+                          Telemetry::METRIC_COUNT * (4 * 11 + 4) + 2 <
+                      WS_TX_BUFFER_SIZE,
+                  "WS_TX_BUFFER_SIZE pequeno demais para a telemetria");
+
+    // Chaves MessagePack (mesmos nomes do JSON)
+    const char K_TYPE[] PROGMEM = "type";
+    const char K_CAR_ID[] PROGMEM = "carId";
+    const char K_SEQ[] PROGMEM = "seq";
+    const char K_SAMPLES[] PROGMEM = "samples";
+    const char K_RSSI[] PROGMEM = "rssi";
+    const char K_HEAP[] PROGMEM = "heap";
+    const char K_MAX_BLOCK[] PROGMEM = "maxBlock";
+    const char K_LOOP_US[] PROGMEM = "loopUs";
+    const char K_RTT_MS[] PROGMEM = "rttMs";
+    const char V_TELEMETRY[] PROGMEM = "telemetry";
+    const char V_CAR_ID[] PROGMEM = CAR_ID_STR;
+
+    struct MetricNames
+    {
+        PGM_P json; // ,"nome":[
+        uint8_t jsonLength;
+        PGM_P key; // nome (MessagePack)
+        uint8_t keyLength;
+    };
+
+#define TM_NAMES(json, key) {json, sizeof(json) - 1, key, sizeof(key) - 1}
+    const MetricNames NAMES[Telemetry::METRIC_COUNT] = {
+        TM_NAMES(TM_RSSI, K_RSSI),
+        TM_NAMES(TM_HEAP, K_HEAP),
+        TM_NAMES(TM_MAX_BLOCK, K_MAX_BLOCK),
+        TM_NAMES(TM_LOOP_US, K_LOOP_US),
+        TM_NAMES(TM_RTT_MS, K_RTT_MS),
+    };
+#undef TM_NAMES
+
+    struct Aggregate
+    {
+        int32_t min;
+        int32_t max;
+        int64_t sum;
+        int32_t last;
+        uint16_t count;
+    };
+
+    struct Window
+    {
+        Aggregate metrics[Telemetry::METRIC_COUNT];
+        uint16_t samples;
+    };
+
+    Window g_open = {};   // janela em andamento
+    Window g_closed = {}; // última janela fechada (aguardando envio)
+    bool g_closedPending = false;
+    uint32_t g_windowsClosed = 0;
+    uint32_t g_windowsSent = 0;
+
+    unsigned long g_lastSampleAt = 0;
+    bool g_started = false;
+    uint32_t g_loopWorstUs = 0;
+    bool g_loopRecorded = false;
+
+    void add(Aggregate &agg, int32_t value)
+    {
+        if (agg.count == 0 || value < agg.min)
+            agg.min = value;
+        if (agg.count == 0 || value > agg.max)
+            agg.max = value;
+        agg.sum += value;
+        agg.last = value;
+        agg.count++;
+    }
+
+    // Média arredondada (RSSI é negativo: arredonda para longe do zero também)
+    int32_t average(const Aggregate &agg)
+    {
+        int64_t half = agg.count / 2;
+        return (int32_t)((agg.sum + (agg.sum < 0 ? -half : half)) / agg.count);
+    }
+
+    uint32_t freeHeap()
+    {
+#if defined(ESP8266) || defined(ESP32)
+        return ESP.getFreeHeap();
+#else
+        return 0;
+#endif
+    }
+
+    uint32_t maxFreeBlock()
+    {
+#if defined(ESP8266)
+        return ESP.getMaxFreeBlockSize();
+#elif defined(ESP32)
+        return ESP.getMaxAllocHeap();
+#else
+        return 0;
+#endif
+    }
+
+    void closeWindow()
+    {
+        if (g_closedPending && LOG_VERBOSE)
+        {
+            Serial.println(F("[TELEMETRY] Janela anterior não enviada - substituída"));
+        }
+        g_closed = g_open;
+        g_closedPending = true;
+        g_windowsClosed++;
+        g_open = {};
+    }
+
+    void takeSample()
+    {
+        Aggregate *metrics = g_open.metrics;
+
+        if (Net::isConnected())
+        {
+            add(metrics[Telemetry::METRIC_RSSI], (int32_t)Net::rssi());
+        }
+        add(metrics[Telemetry::METRIC_HEAP], (int32_t)freeHeap());
+        add(metrics[Telemetry::METRIC_MAX_BLOCK], (int32_t)maxFreeBlock());
+
+        if (g_loopRecorded)
+        {
+            add(metrics[Telemetry::METRIC_LOOP_US], (int32_t)g_loopWorstUs);
+            g_loopWorstUs = 0;
+            g_loopRecorded = false;
+        }
+
+        if (++g_open.samples >= TELEMETRY_WINDOW_SAMPLES)
+        {
+            closeWindow();
+        }
+    }
+}
+
+namespace Telemetry
+{
+    void recordLoop(uint32_t loopMicros)
+    {
+        if (!g_loopRecorded || loopMicros > g_loopWorstUs)
+        {
+            g_loopWorstUs = loopMicros;
+        }
+        g_loopRecorded = true;
+    }
+
+    void recordRtt(uint32_t rttMs)
+    {
+        add(g_open.metrics[METRIC_RTT_MS], (int32_t)rttMs);
+    }
+
+    void update(unsigned long now)
+    {
+#if TELEMETRY_WINDOW_SAMPLES
+        if (!g_started)
+        {
+            g_started = true;
+            g_lastSampleAt = now;
+            return;
+        }
+
+        if (now - g_lastSampleAt < TELEMETRY_SAMPLE_MS)
+        {
+            return;
+        }
+
+        // Mantém a cadência sem acumular atraso; após um travamento longo, recomeça de agora
+        g_lastSampleAt += TELEMETRY_SAMPLE_MS;
+        if (now - g_lastSampleAt >= TELEMETRY_SAMPLE_MS)
+        {
+            g_lastSampleAt = now;
+        }
+
+        takeSample();
+#else
+        (void)now;
+#endif
+    }
+
+    bool batchReady()
+    {
+        return g_closedPending;
+    }
+
+    void build(Json::Writer &json)
+    {
+        json.raw(TM_HEAD).number((unsigned long)g_windowsClosed);
+        json.raw(TM_SAMPLES).number((unsigned int)g_closed.samples);
+
+        for (uint8_t i = 0; i < METRIC_COUNT; i++)
+        {
+            const Aggregate &agg = g_closed.metrics[i];
+            if (agg.count == 0)
+                continue;
+
+            json.rawP(NAMES[i].json, NAMES[i].jsonLength);
+            json.number((long)agg.min).put(',');
+            json.number((long)agg.max).put(',');
+            json.number((long)average(agg)).put(',');
+            json.number((long)agg.last).put(']');
+        }
+        json.put('}');
+    }
+
+    void build(MsgPack::Writer &msg)
+    {
+        uint8_t present = 0;
+        for (uint8_t i = 0; i < METRIC_COUNT; i++)
+        {
+            present += g_closed.metrics[i].count ? 1 : 0;
+        }
+
+        msg.map(4 + present);
+        msg.key(K_TYPE).key(V_TELEMETRY);
+        msg.key(K_CAR_ID).key(V_CAR_ID);
+        msg.key(K_SEQ).number((unsigned long)g_windowsClosed);
+        msg.key(K_SAMPLES).number((unsigned int)g_closed.samples);
+
+        for (uint8_t i = 0; i < METRIC_COUNT; i++)
+        {
+            const Aggregate &agg = g_closed.metrics[i];
+            if (agg.count == 0)
+                continue;
+
+            msg.strP(NAMES[i].key, NAMES[i].keyLength).array(4);
+            msg.number((long)agg.min).number((long)agg.max).number((long)average(agg)).number((long)agg.last);
+        }
+    }
+
+    void markSent()
+    {
+        g_closedPending = false;
+        g_windowsSent++;
+    }
+
+    uint32_t windowsClosed()
+    {
+        return g_windowsClosed;
+    }
+
+    uint32_t windowsSent()
+    {
+        return g_windowsSent;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+#include "../Json/json_writer.h"
+#include "../Json/msgpack_writer.h"
+
+/**
+ * Telemetria agregada em janelas
+ *
+ * Amostra RSSI, heap livre, maior bloco livre, tempo de loop e RTT do
+ * WebSocket a cada TELEMETRY_SAMPLE_MS e acumula min/max/soma/último por
+ * métrica (memória fixa, sem guardar as amostras). A cada
+ * TELEMETRY_WINDOW_SAMPLES amostras a janela fecha e vira um único frame:
+ *   {"type":"telemetry","carId":"...","seq":N,"samples":30,
+ *    "rssi":[min,max,avg,last],"heap":[...],"maxBlock":[...],
+ *    "loopUs":[...],"rttMs":[...]}
+ * Métrica sem amostras na janela (ex.: RTT sem pong) é omitida.
+ * Só a última janela fechada é guardada: sem conexão, a próxima a substitui.
+ */
+
+namespace Telemetry
+{
+    enum Metric : uint8_t
+    {
+        METRIC_RSSI = 0,
+        METRIC_HEAP,
+        METRIC_MAX_BLOCK,
+        METRIC_LOOP_US, // pior iteração do loop desde a amostra anterior
+        METRIC_RTT_MS,  // ping/pong do WebSocket
+        METRIC_COUNT
+    };
+
+    // Duração de uma iteração do loop principal (sem o delay final)
+    void recordLoop(uint32_t loopMicros);
+
+    // Amostra de RTT medida pelo gerenciador WebSocket
+    void recordRtt(uint32_t rttMs);
+
+    // Amostragem periódica (chamar a cada iteração do loop)
+    void update(unsigned long now);
+
+    // Há uma janela fechada aguardando envio
+    bool batchReady();
+
+    // Serializa a última janela fechada
+    void build(Json::Writer &json);
+    void build(MsgPack::Writer &msg);
+
+    // Janela entregue à fila de saída: não será serializada de novo
+    void markSent();
+
+    uint32_t windowsClosed();
+    uint32_t windowsSent();
+}
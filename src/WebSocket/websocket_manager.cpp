@@ -4,23 +4,747 @@
 #include "../Wifi/wifi.h"
 #include "../Display/Display.h"
 #include "../Reley/reley.h"
+#include "../HC595/HC595.h"
 #include "../WS/WSUtils.h"
+#include "../WS/host_probe.h"
+#include "../WS/host_scoreboard.h"
+#include "../WS/health_check.h"
+#include "../WS/gateway_discovery.h"
+#include "../WS/rendezvous.h"
+#include "../Json/json_tokenizer.h"
+#include "../Json/json_stream.h"
+#include "../Json/json_writer.h"
+#include "../Json/msgpack_writer.h"
+#include "heartbeat.h"
+#include "outbound_queue.h"
+#include "inbound_queue.h"
+#include "rate_limiter.h"
+#include "telemetry.h"
+#include "status_cache.h"
+#include "../Compress/lzss.h"
+#include "../Protocol/messages.h"
+#include "command_ack.h"
+#include "../Journal/event_journal.h"
+#include "../Dispatch/perfect_hash.h"
 
 using namespace Operation;
-#include <ESP8266HTTPClient.h>
 
-static WebSocketsClient g_webSocket;
+// Cliente com acesso ao socket TCP para medir o buffer de envio do lwIP
+class TxAwareClient : public WebSocketsClient
+{
+public:
+    // Bytes que ainda cabem no buffer de envio TCP; 0 sem socket
+    size_t txAvailable()
+    {
+        return _client.tcp ? (size_t)_client.tcp->availableForWrite() : 0;
+    }
+};
+
+static TxAwareClient g_webSocket;
 static unsigned long g_lastHeartbeatAt = 0;
+
+// Ping próprio para medir RTT (o ping de keepalive da biblioteca tem outro payload)
+static uint8_t g_rttPingPayload[] = {'r', 't', 't'};
+static unsigned long g_rttPingSentAt = 0;
+static bool g_rttPingPending = false;
 static size_t g_currentHostIndex = 0;
+// false = o host atual precisa ser confirmado por uma rodada de HostProbe
+static bool g_hostVerified = false;
+// Host do health check em andamento (o atual pode mudar durante a verificação)
+static size_t g_healthHostIndex = 0;
+// Índice fora da lista: host veio da descoberta por broadcast (slot próprio
+// no placar, guardado na RTC junto com o endereço)
+static const size_t DISCOVERED_HOST = HostScoreboard::DISCOVERED;
+static_assert(ALT_WS_HOSTS_COUNT < HostScoreboard::DISCOVERED, "Lista de hosts colide com o índice do host descoberto");
+
+// Host em uso: um da lista ou o gateway que respondeu à descoberta
+static const char *currentHost()
+{
+    return g_currentHostIndex < ALT_WS_HOSTS_COUNT ? ALT_WS_HOSTS[g_currentHostIndex] : HostScoreboard::discoveredHost();
+}
+
+static uint16_t currentPort()
+{
+    return g_currentHostIndex < ALT_WS_HOSTS_COUNT ? WS_PORT : HostScoreboard::discoveredPort();
+}
+
+// Buffer único de serialização de saída (evita String/heap por frame)
+static char g_txBuffer[WS_TX_BUFFER_SIZE];
+
+// Codificação de saída escolhida pelo gateway (JSON até opt-in)
+static Json::Format g_wireFormat = Json::FORMAT_JSON;
+
+// Compressão LZSS de frames grandes (opt-in no caps_select), feita no próprio g_txBuffer
+static bool g_compressFrames = false;
+
+// Abertura de sessão: hello com capacidades + estado atual, em um só frame
+// (sempre JSON: é o frame de negociação)
+static const char HELLO_HEAD[] PROGMEM = "{\"type\":\"hello\",\"carId\":\"" CAR_ID_STR "\"" JSON_KEY("proto");
+static const char HELLO_IP[] PROGMEM = JSON_KEY_STR("ip");
+static const char HELLO_HOSTNAME[] PROGMEM = "\"" JSON_KEY_STR("hostname");
+static const char HELLO_CAPS[] PROGMEM = "\"" JSON_KEY("board") "\"ESP8266\"" JSON_KEY("caps")
+                                         "{\"enc\":[\"json\",\"msgpack\"]" JSON_KEY("hbDelta") "true"
+                                         JSON_KEY("cmdAck") "true" JSON_KEY("journal") "true"
+                                         JSON_KEY("compress") "[\"lzss\"]" JSON_KEY("batch");
+static const char HELLO_MAX_FRAME[] PROGMEM = JSON_KEY("maxFrame");
+static const char HELLO_STATUS[] PROGMEM = "}" JSON_KEY_STR("status");
+static const char HELLO_OPERATION_STATE[] PROGMEM = "\"" JSON_KEY_STR("operationState");
+static const char HELLO_REMAINING[] PROGMEM = "\"" JSON_KEY("remainingSeconds");
+static const char HELLO_RELAY_ON[] PROGMEM = JSON_KEY("relayOn");
+
+static_assert(Json::literalLength(HELLO_HEAD) + Json::literalLength(HELLO_IP) + Json::literalLength(HELLO_HOSTNAME) +
+                      Json::literalLength(HELLO_CAPS) + Json::literalLength(HELLO_MAX_FRAME) +
+                      Json::literalLength(HELLO_STATUS) + Json::literalLength(HELLO_OPERATION_STATE) +
+                      Json::literalLength(HELLO_REMAINING) + Json::literalLength(HELLO_RELAY_ON) +
+                      15 + 32 + 24 + 16 + 4 * 11 + 5 + 1 <
+                  WS_TX_BUFFER_SIZE,
+              "WS_TX_BUFFER_SIZE pequeno para o frame de abertura de sessão");
+
+// Função utilitária para heap livre
+static inline uint32_t getFreeHeap()
+{
+#if defined(ESP8266) || defined(ESP32)
+    return ESP.getFreeHeap();
+#else
+    return 0;
+#endif
+}
+
+// Campos usados no roteamento de um frame de texto (fatias dentro do payload)
+struct InboundFields
+{
+    Json::Slice action;
+    Json::Slice actions[OP_MAX_BATCH_ACTIONS]; // "actions":[...]
+    uint8_t actionCount = 0;
+    bool hasActions = false;
+    bool actionsMalformed = false; // item não-string
+    bool actionsOverflow = false;  // mais de OP_MAX_BATCH_ACTIONS itens
+    CommandAck::Command command;   // "id", "ts", "ttl" da raiz
+    Json::Slice type;
+    bool hasType = false;
+    bool hasCarId = false;
+    bool hasStatus = false;
+};
+
+// Lê os itens de "actions":[...] (o token ARRAY_START já foi consumido)
+static void readActionList(Json::Tokenizer &tok, InboundFields &fields)
+{
+    Json::Token item;
+    while (tok.next(item) && item.type != Json::TOK_ARRAY_END)
+    {
+        if (item.type == Json::TOK_OBJECT_START || item.type == Json::TOK_ARRAY_START)
+        {
+            fields.actionsMalformed = true;
+            tok.skip(item);
+        }
+        else if (item.type != Json::TOK_STRING)
+        {
+            fields.actionsMalformed = true;
+        }
+        else if (fields.actionCount >= OP_MAX_BATCH_ACTIONS)
+        {
+            fields.actionsOverflow = true;
+        }
+        else
+        {
+            fields.actions[fields.actionCount++] = item.text;
+        }
+    }
+}
+
+// Varre o payload uma única vez, sem copiá-lo, coletando os campos de roteamento
+static bool scanInboundFrame(const uint8_t *payload, size_t length, Json::Format format, InboundFields &fields)
+{
+    Json::Tokenizer tok(payload, length, format);
+    Json::Token key;
+
+    while (tok.next(key))
+    {
+        if (key.type != Json::TOK_KEY)
+        {
+            continue;
+        }
+
+        Json::Token value;
+        if (!tok.next(value))
+        {
+            break;
+        }
+
+        if (key.depth == 1 && value.type == Json::TOK_NUMBER && value.number >= 0 &&
+            (key.text.equals("id") || key.text.equals("ts") || key.text.equals("ttl")))
+        {
+            if (key.text.equals("id"))
+            {
+                fields.command.hasId = true;
+                fields.command.id = (uint32_t)value.number;
+            }
+            else if (key.text.equals("ts"))
+            {
+                fields.command.issuedAt = (uint32_t)value.number;
+            }
+            else
+            {
+                fields.command.ttlMs = value.number;
+            }
+        }
+        else if (key.text.equals("actions") && key.depth == 1)
+        {
+            fields.hasActions = true;
+            if (value.type == Json::TOK_ARRAY_START)
+            {
+                readActionList(tok, fields);
+            }
+            else
+            {
+                fields.actionsMalformed = true;
+            }
+        }
+        else if (key.text.equals("action"))
+        {
+            if (value.type == Json::TOK_STRING && fields.action.empty())
+            {
+                fields.action = value.text;
+            }
+        }
+        else if (key.text.equals("type"))
+        {
+            fields.hasType = true;
+            if (value.type == Json::TOK_STRING && key.depth == 1)
+            {
+                fields.type = value.text;
+            }
+        }
+        else if (key.text.equals("carId"))
+        {
+            fields.hasCarId = true;
+        }
+        else if (key.text.equals("status"))
+        {
+            fields.hasStatus = true;
+        }
+
+        // Objetos e arrays aninhados continuam sendo percorridos pelo laço
+    }
+
+    return key.type == Json::TOK_END;
+}
+
+// Lê {"type":"encoding","value":"msgpack"|"json"} enviado pelo gateway
+static void applyEncodingMessage(const uint8_t *payload, size_t length, Json::Format format)
+{
+    Protocol::EncodingMsg msg;
+    if (!Protocol::decodeEncoding(payload, length, format, msg))
+    {
+        Serial.println(F("[WS] encoding inválido - ignorado"));
+        return;
+    }
+    WebSocketManager::setEncoding(msg.value.equals("msgpack") ? Json::FORMAT_MSGPACK : Json::FORMAT_JSON);
+}
+
+// Lê {"type":"caps_select","proto":1,"enc":"msgpack","hbDelta":true,"keyframeEvery":N,"compress":"lzss"}
+static void applyCapsSelect(const uint8_t *payload, size_t length, Json::Format format)
+{
+    Protocol::CapsSelectMsg msg;
+    if (!Protocol::decodeCapsSelect(payload, length, format, msg))
+    {
+        Serial.println(F("[HELLO][CAPS] caps_select inválido - ignorado"));
+        return;
+    }
+
+    const long proto = msg.hasProto ? msg.proto : 0;
+    long keyframeEvery = msg.hasKeyframeEvery ? msg.keyframeEvery : 0;
+    const bool delta = msg.hasHbDelta && msg.hbDelta;
+    const bool compress = msg.hasCompress && msg.compress.equals("lzss");
+    const Json::Format encoding = (msg.hasEnc && msg.enc.equals("msgpack")) ? Json::FORMAT_MSGPACK : Json::FORMAT_JSON;
+
+    if (proto < 1 || proto > WS_PROTO_VERSION)
+    {
+        Serial.print(F("[HELLO][CAPS] Versão de protocolo não suportada: "));
+        Serial.println(proto);
+        return;
+    }
+
+    if (keyframeEvery < 0 || keyframeEvery > 0xFFFF)
+    {
+        keyframeEvery = 0;
+    }
+
+    Heartbeat::configure(delta, (uint16_t)keyframeEvery);
+    WebSocketManager::setEncoding(encoding);
+    g_compressFrames = compress;
+
+    Serial.print(F("[HELLO][CAPS] Selecionado: enc="));
+    Serial.print(encoding == Json::FORMAT_MSGPACK ? F("msgpack") : F("json"));
+    Serial.print(F(" hbDelta="));
+    Serial.print(delta ? F("sim") : F("não"));
+    Serial.print(F(" compress="));
+    Serial.println(compress ? F("lzss") : F("não"));
+}
+
+// ===== ROTEAMENTO POR "type" =====
+typedef void (*MessageHandler)(const uint8_t *payload, size_t length, Json::Format format);
+
+static void onSessionData(const uint8_t *payload, size_t length, Json::Format format)
+{
+    Serial.println(F("[WS] Recebido session_data"));
+    Operation::handleSessionData(payload, length, format);
+}
+
+static void onHeartbeatKeyframe(const uint8_t *, size_t, Json::Format)
+{
+    Heartbeat::requestKeyframe();
+}
+
+static constexpr Dispatch::Entry<MessageHandler> MESSAGE_TYPES[] = {
+    {"session_data", onSessionData},
+    {"heartbeat_mode", Heartbeat::handleModeMessage},
+    {"heartbeat_keyframe", onHeartbeatKeyframe},
+    {"journal_ack", Journal::handleAck},
+    {"encoding", applyEncodingMessage},
+    {"caps_select", applyCapsSelect},
+};
+
+static constexpr auto MESSAGE_TABLE = Dispatch::makeTable(MESSAGE_TYPES);
+static_assert(MESSAGE_TABLE.valid(), "Sem semente de hash perfeito para MESSAGE_TYPES");
+
+// Envio efetivo, chamado apenas pela drenagem da fila de saída
+static bool transmitFrame(const uint8_t *data, size_t length, bool binary)
+{
+    bool ok = binary ? g_webSocket.sendBIN(data, length)
+                     : g_webSocket.sendTXT(data, length);
+    if (ok)
+    {
+        Operation::getState().sessionSentFrames++;
+    }
+    return ok;
+}
+
+// Enfileira o frame já serializado (copiado para um slot da fila)
+static OutboundQueue::PushResult sendFrame(OutboundQueue::Kind kind, OutboundQueue::Priority priority,
+                                           const uint8_t *data, size_t length, bool binary)
+{
+    return OutboundQueue::push(kind, priority, data, length, binary);
+}
+
+static OutboundQueue::PushResult sendFrame(OutboundQueue::Kind kind, OutboundQueue::Priority priority,
+                                           const String &text)
+{
+    return sendFrame(kind, priority, reinterpret_cast<const uint8_t *>(text.c_str()), text.length(), false);
+}
+
+// Frames grandes e repetitivos (heartbeat, telemetria, replay do diário) saem
+// comprimidos em LZSS quando o gateway aceitou; o resultado é sempre binário.
+// A compressão é feita no lugar: 'data' é sobrescrito pelo frame comprimido.
+static OutboundQueue::PushResult sendCompressible(OutboundQueue::Kind kind, OutboundQueue::Priority priority,
+                                                  uint8_t *data, size_t length, bool binary)
+{
+    if (!g_compressFrames || length < WS_COMPRESS_MIN_BYTES)
+    {
+        return sendFrame(kind, priority, data, length, binary);
+    }
+
+    size_t packed = Lzss::compress(data, length, data, length);
+    if (LOG_VERBOSE)
+    {
+        Serial.print(F("[LZSS] "));
+        Serial.print(length);
+        Serial.print(F(" -> "));
+        Serial.print(packed ? packed : length);
+        Serial.print(F(" B ("));
+        Serial.print(packed ? packed * 100 / length : 100);
+        Serial.print(F("%) em "));
+        Serial.print(Lzss::stats().lastMicros);
+        Serial.println(F(" us"));
+    }
+
+    if (!packed)
+    {
+        return sendFrame(kind, priority, data, length, binary);
+    }
+    return sendFrame(kind, priority, data, packed, true);
+}
+
+// Próximo lote do diário offline, um por vez (o seguinte só após journal_ack)
+static void sendJournalBatch()
+{
+    unsigned long now = millis();
+    const bool binary = (g_wireFormat == Json::FORMAT_MSGPACK);
+    Json::Writer json(g_txBuffer, sizeof(g_txBuffer));
+    MsgPack::Writer msg(reinterpret_cast<uint8_t *>(g_txBuffer), sizeof(g_txBuffer));
+
+    if (!(binary ? Journal::buildReplay(msg, now) : Journal::buildReplay(json, now)))
+    {
+        return;
+    }
+
+    size_t frameLength = binary ? msg.length() : json.length();
+    sendCompressible(OutboundQueue::KIND_JOURNAL, OutboundQueue::PRIO_STATUS,
+                     reinterpret_cast<uint8_t *>(g_txBuffer), frameLength, binary);
+
+    if (LOG_VERBOSE)
+    {
+        Serial.print(F("[JOURNAL] Lote enviado size="));
+        Serial.print(frameLength);
+        Serial.print(F(" pendentes="));
+        Serial.println(Journal::pendingCount());
+    }
+}
+
+// Janela de telemetria fechada: um frame agregado, na prioridade do heartbeat
+static void sendTelemetry()
+{
+    if (!Telemetry::batchReady())
+    {
+        return;
+    }
+
+    const bool binary = (g_wireFormat == Json::FORMAT_MSGPACK);
+    Json::Writer json(g_txBuffer, sizeof(g_txBuffer));
+    MsgPack::Writer msg(reinterpret_cast<uint8_t *>(g_txBuffer), sizeof(g_txBuffer));
+    if (binary)
+        Telemetry::build(msg);
+    else
+        Telemetry::build(json);
+
+    if (binary ? msg.overflowed() : json.overflowed())
+    {
+        Serial.println(F("[TELEMETRY][ERRO] Janela excedeu WS_TX_BUFFER_SIZE - descartada"));
+        Telemetry::markSent();
+        return;
+    }
+
+    // Antes do envio: a compressão sobrescreve g_txBuffer
+    if (LOG_HEARTBEAT_JSON && !binary)
+    {
+        Serial.println(json.c_str());
+    }
+
+    size_t frameLength = binary ? msg.length() : json.length();
+    OutboundQueue::PushResult queued = sendCompressible(OutboundQueue::KIND_TELEMETRY, OutboundQueue::PRIO_HEARTBEAT,
+                                                        reinterpret_cast<uint8_t *>(g_txBuffer), frameLength, binary);
+    if (queued == OutboundQueue::PUSH_DROPPED)
+    {
+        return; // fila cheia: tenta de novo na próxima iteração
+    }
+    Telemetry::markSent();
+
+    if (LOG_VERBOSE)
+    {
+        Serial.print(F("[TELEMETRY] Janela enviada size="));
+        Serial.println(frameLength);
+    }
+}
+
+// Ping de medição de RTT; um por vez, o pong com o mesmo payload fecha a medida
+// (pong que não chega em TELEMETRY_RTT_PING_MS é abandonado pelo próximo ping)
+static void sendRttPing()
+{
+    unsigned long now = millis();
+    if (now - g_rttPingSentAt < TELEMETRY_RTT_PING_MS)
+    {
+        return;
+    }
+
+    // Sem espaço no buffer TCP o ping mediria a fila local, não o link
+    if (OutboundQueue::congested())
+    {
+        return;
+    }
+
+    g_rttPingSentAt = now;
+    g_rttPingPending = g_webSocket.sendPing(g_rttPingPayload, sizeof(g_rttPingPayload));
+}
+
+static void onPong(const uint8_t *payload, size_t length)
+{
+    if (!g_rttPingPending || length != sizeof(g_rttPingPayload) ||
+        memcmp(payload, g_rttPingPayload, length) != 0)
+    {
+        return;
+    }
+    g_rttPingPending = false;
+    Telemetry::recordRtt(millis() - g_rttPingSentAt);
+}
+
+// Um único frame com o resultado do lote e o estado resultante
+static void sendBatchResult(const Operation::BatchResult &result, const CommandAck::Command &command, bool duplicate)
+{
+    Protocol::BatchResultMsg msg;
+    msg.ok = (result.error == Operation::ACTION_OK);
+    msg.hasId = command.hasId;
+    msg.id = command.id;
+    msg.hasDuplicate = duplicate;
+    msg.duplicate = true;
+    msg.applied = result.applied;
+    msg.hasFailed = msg.hasError = !msg.ok;
+    msg.failed = result.failedIndex;
+    msg.error = Protocol::text(Operation::actionErrorToString(result.error));
+    msg.operationState = Protocol::text(Operation::getStatusString());
+    msg.relayOn = Relay::isOn();
+    msg.hc595 = HC595::getByte();
+    msg.applyUs = result.applyMicros;
+    msg.latencyUs = CommandAck::latencyUs(command);
+
+    if (g_wireFormat == Json::FORMAT_MSGPACK)
+    {
+        MsgPack::Writer out(reinterpret_cast<uint8_t *>(g_txBuffer), sizeof(g_txBuffer));
+        if (Protocol::encodeBatchResult(msg, out))
+        {
+            sendFrame(OutboundQueue::KIND_ACK, OutboundQueue::PRIO_COMMAND, out.data(), out.length(), true);
+        }
+        return;
+    }
+
+    Json::Writer json(g_txBuffer, sizeof(g_txBuffer));
+    if (Protocol::encodeBatchResult(msg, json))
+    {
+        sendFrame(OutboundQueue::KIND_ACK, OutboundQueue::PRIO_COMMAND,
+                  reinterpret_cast<const uint8_t *>(json.c_str()), json.length(), false);
+    }
+}
+
+// ack/nack de um comando "action" com id
+static void sendCommandAck(const CommandAck::Command &command, Operation::ActionError result, bool duplicate)
+{
+    if (g_wireFormat == Json::FORMAT_MSGPACK)
+    {
+        MsgPack::Writer msg(reinterpret_cast<uint8_t *>(g_txBuffer), sizeof(g_txBuffer));
+        CommandAck::build(msg, command, result, duplicate);
+        if (!msg.overflowed())
+        {
+            sendFrame(OutboundQueue::KIND_ACK, OutboundQueue::PRIO_COMMAND, msg.data(), msg.length(), true);
+        }
+        return;
+    }
+
+    Json::Writer json(g_txBuffer, sizeof(g_txBuffer));
+    CommandAck::build(json, command, result, duplicate);
+    if (!json.overflowed())
+    {
+        sendFrame(OutboundQueue::KIND_ACK, OutboundQueue::PRIO_COMMAND,
+                  reinterpret_cast<const uint8_t *>(json.c_str()), json.length(), false);
+    }
+}
+
+// Frame com "action" ou "actions": dedupe por id, validade e resposta
+// Lotes sempre respondem; ação simples só quando o gateway mandou id
+static void replyCommandFrame(const InboundFields &fields, const Operation::BatchResult &result, bool duplicate)
+{
+    const CommandAck::Command &command = fields.command;
+    if (fields.hasActions)
+    {
+        sendBatchResult(result, command, duplicate);
+    }
+    else if (command.hasId)
+    {
+        sendCommandAck(command, result.error, duplicate);
+    }
+}
+
+static void handleCommandFrame(const InboundFields &fields)
+{
+    const CommandAck::Command &command = fields.command;
+    Operation::BatchResult result;
+    bool duplicate = false;
+
+    if (command.hasId && CommandAck::lookup(command.id, result.error))
+    {
+        duplicate = true;
+        Serial.print(F("[CMD] id="));
+        Serial.print(command.id);
+        Serial.println(F(" repetido - não reaplicado"));
+    }
+    else if (CommandAck::isExpired(command))
+    {
+        result.error = Operation::ACTION_EXPIRED;
+        Serial.print(F("[CMD] id="));
+        Serial.print(command.id);
+        Serial.println(F(" expirado (ttl) - descartado"));
+    }
+    else if (fields.hasActions)
+    {
+        if (fields.actionsMalformed || fields.actionsOverflow)
+        {
+            result.error = fields.actionsMalformed ? Operation::ACTION_MALFORMED : Operation::ACTION_TOO_MANY;
+        }
+        else
+        {
+            result = Operation::handleActionBatch(fields.actions, fields.actionCount);
+        }
+    }
+    else
+    {
+        result.error = Operation::handleAction(fields.action);
+    }
+
+    if (command.hasId && !duplicate)
+    {
+        CommandAck::remember(command.id, result.error);
+    }
+
+    replyCommandFrame(fields, result, duplicate);
+}
+
+// Frame de comando recusado antes da execução (não entra na janela de ids,
+// então o gateway pode reenviar o mesmo id)
+static void rejectCommandFrame(const InboundFields &fields, Operation::ActionError error)
+{
+    Operation::BatchResult result;
+    result.error = error;
+    replyCommandFrame(fields, result, false);
+}
+
+// Categoria de limite de taxa de um frame de comando: hc595 só se todas as ações forem hc595_*
+static RateLimiter::Category commandCategory(const InboundFields &fields)
+{
+    if (!fields.hasActions)
+    {
+        return fields.action.startsWith("hc595_") ? RateLimiter::CAT_HC595 : RateLimiter::CAT_OPERATION;
+    }
+
+    for (uint8_t i = 0; i < fields.actionCount; i++)
+    {
+        if (!fields.actions[i].startsWith("hc595_"))
+        {
+            return RateLimiter::CAT_OPERATION;
+        }
+    }
+    return RateLimiter::CAT_HC595;
+}
+
+// Executa os comandos enfileirados até esgotar o orçamento da iteração
+static void runQueuedCommands()
+{
+    const uint32_t startedAt = micros();
+    InboundQueue::Frame frame;
+
+    while (InboundQueue::peek(frame))
+    {
+        // O payload já foi validado na chegada; a varredura é refeita sobre a cópia
+        InboundFields fields;
+        fields.command.arrivedAtUs = frame.arrivedAtUs;
+        if (scanInboundFrame(frame.data, frame.length, frame.format, fields))
+        {
+            handleCommandFrame(fields);
+        }
+        InboundQueue::pop();
+
+        if (micros() - startedAt >= WS_CMD_BUDGET_US)
+        {
+            if (!InboundQueue::empty())
+            {
+                InboundQueue::noteDeferred();
+            }
+            break;
+        }
+    }
+}
+
+// ===== MENSAGENS FRAGMENTADAS =====
+// Cada pedaço é tokenizado ao chegar, numa janela fixa: nenhuma mensagem
+// precisa ser remontada inteira no heap. Só session_data é aplicada por
+// esse caminho; comandos e demais tipos devem vir em frame único.
+struct StreamedFrame
+{
+    Operation::SessionDataParser session;
+    char type[24] = "";
+    bool expectType = false;
+    bool hasCommand = false;
+};
+
+static char g_streamWindow[WS_STREAM_WINDOW];
+static Json::StreamTokenizer g_stream(g_streamWindow, sizeof(g_streamWindow));
+static StreamedFrame g_streamed;
+static bool g_streamActive = false; // false: pedaços restantes são descartados
+
+static void onStreamToken(const Json::Token &tok, void *context)
+{
+    StreamedFrame &frame = *static_cast<StreamedFrame *>(context);
+
+    if (tok.type == Json::TOK_KEY && tok.depth == 1)
+    {
+        frame.expectType = tok.text.equals("type");
+        frame.hasCommand |= tok.text.equals("action") || tok.text.equals("actions");
+    }
+    else if (frame.expectType)
+    {
+        frame.expectType = false;
+        if (tok.type == Json::TOK_STRING)
+        {
+            tok.text.copyTo(frame.type, sizeof(frame.type));
+        }
+    }
+
+    frame.session.feed(tok);
+}
+
+static void abortStreamedFrame(const __FlashStringHelper *reason)
+{
+    g_streamActive = false;
+    Serial.print(F("[WS][FRAG] Mensagem fragmentada descartada: "));
+    Serial.println(reason);
+}
+
+static void beginStreamedFrame()
+{
+    g_stream.reset();
+    g_streamed = StreamedFrame();
+    g_streamActive = true;
+}
+
+// Tokeniza mais um pedaço; no último, aplica a mensagem
+static void feedStreamedFrame(const uint8_t *payload, size_t length, bool last)
+{
+    if (!g_streamActive)
+    {
+        return;
+    }
+
+    if (g_stream.consumed() + length > WS_STREAM_MAX_BYTES)
+    {
+        abortStreamedFrame(F("acima de WS_STREAM_MAX_BYTES"));
+        return;
+    }
+
+    if (!g_stream.feed(payload, length, onStreamToken, &g_streamed) ||
+        (last && !g_stream.finish(onStreamToken, &g_streamed)))
+    {
+        abortStreamedFrame(g_stream.error() == Json::STREAM_TOKEN_TOO_LARGE ? F("token maior que WS_STREAM_WINDOW")
+                                                                             : F("JSON inválido"));
+        return;
+    }
+
+    if (!last)
+    {
+        return;
+    }
+
+    g_streamActive = false;
+
+    if (LOG_VERBOSE)
+    {
+        Serial.print(F("[WS][FRAG] Mensagem completa: "));
+        Serial.print(g_stream.consumed());
+        Serial.print(F(" bytes type="));
+        Serial.println(g_streamed.type);
+    }
 
-// Função utilitária para heap livre
-static inline uint32_t getFreeHeap()
-{
-#if defined(ESP8266) || defined(ESP32)
-    return ESP.getFreeHeap();
-#else
-    return 0;
-#endif
+    if (strcmp(g_streamed.type, "session_data") != 0)
+    {
+        Serial.println(g_streamed.hasCommand ? F("[WS][FRAG] Comando fragmentado não suportado - envie em frame único")
+                                             : F("[WS][FRAG] Tipo fragmentado não suportado - ignorado"));
+        return;
+    }
+
+    if (!RateLimiter::allow(RateLimiter::CAT_OPERATION, 1, millis()))
+    {
+        return;
+    }
+
+    SessionData session;
+    g_streamed.session.finish(session);
+    Operation::applySessionData(session, g_stream.consumed());
 }
 
 namespace WebSocketManager
@@ -28,7 +752,17 @@ namespace WebSocketManager
 
     void initialize()
     {
-        // Configurações já são feitas na startConnection()
+        // Demais configurações são feitas na startConnection()
+        HostScoreboard::begin(ALT_WS_HOSTS, ALT_WS_HOSTS_COUNT);
+
+        // Reset a quente: volta direto ao último host bom (da lista ou o
+        // descoberto), sem rodada de sondas nem broadcast
+        int lastGood = HostScoreboard::lastGood();
+        if (lastGood >= 0)
+        {
+            g_currentHostIndex = (size_t)lastGood;
+            g_hostVerified = true;
+        }
     }
 
     WebSocketsClient &getClient()
@@ -41,7 +775,22 @@ namespace WebSocketManager
         return g_webSocket.isConnected();
     }
 
-    void sendHello()
+    void setEncoding(Json::Format format)
+    {
+        if (format != g_wireFormat && LOG_VERBOSE)
+        {
+            Serial.print(F("[WS] Codificação de saída: "));
+            Serial.println(format == Json::FORMAT_MSGPACK ? F("MessagePack (WStype_BIN)") : F("JSON (WStype_TEXT)"));
+        }
+        g_wireFormat = format;
+    }
+
+    Json::Format encoding()
+    {
+        return g_wireFormat;
+    }
+
+    void sendSessionOpen()
     {
         if (getFreeHeap() < 8000)
         {
@@ -51,11 +800,16 @@ namespace WebSocketManager
             return;
         }
 
-        // Modo simples para compatibilidade
+        auto &state = Operation::getState();
+
+        // Identidade reanunciada: frames status em cache são refeitos sob demanda
+        StatusCache::invalidate();
+
+        // Modo simples para compatibilidade: gateway antigo não entende o frame
+        // combinado, então hello e status seguem separados
 #if defined(WS_HELLO_SIMPLE)
         String plain = String("HELLO ") + CAR_ID_STR;
-        g_webSocket.sendTXT(plain);
-        Operation::getState().sessionSentFrames++;
+        sendFrame(OutboundQueue::KIND_HELLO, OutboundQueue::PRIO_COMMAND, plain);
 
         if (LOG_VERBOSE)
         {
@@ -63,29 +817,48 @@ namespace WebSocketManager
             Serial.print(plain);
             Serial.println('"');
         }
+
+        char lastStatus[24];
+        strlcpy(lastStatus, state.lastStatus.c_str(), sizeof(lastStatus));
+        publishStatus(lastStatus);
 #else
-        // JSON padrão
-        String json;
-        json.reserve(256);
-        json += "{\"type\":\"hello\",";
-        json += "\"carId\":\"";
-        json += CAR_ID_STR;
-        json += "\",";
-        json += "\"ip\":\"";
-        json += Net::ip();
-        json += "\",";
-        json += "\"hostname\":\"";
-        json += (Net::hostname() ? Net::hostname() : "");
-        json += "\",";
-        json += "\"board\":\"ESP8266\"";
-        json += "}";
-
-        g_webSocket.sendTXT(json);
-        Operation::getState().sessionSentFrames++;
+        // Identidade, capacidades e estado da operação/relay em um frame só
+        Json::Writer json(g_txBuffer, sizeof(g_txBuffer));
+        json.raw(HELLO_HEAD)
+            .number(WS_PROTO_VERSION)
+            .raw(HELLO_IP)
+            .ip(Net::localIp())
+            .raw(HELLO_HOSTNAME)
+            .str(Net::hostname())
+            .raw(HELLO_CAPS)
+            .number(OP_MAX_BATCH_ACTIONS)
+            .raw(HELLO_MAX_FRAME)
+            .number(WS_MAX_FRAME)
+            .raw(HELLO_STATUS)
+            .str(state.lastStatus.c_str())
+            .raw(HELLO_OPERATION_STATE)
+            .str(statusToString(state.status))
+            .raw(HELLO_REMAINING)
+            .number(state.remainingSeconds)
+            .raw(HELLO_RELAY_ON)
+            .boolean(Relay::isOn())
+            .put('}');
+
+        if (!json.overflowed())
+        {
+            sendFrame(OutboundQueue::KIND_HELLO, OutboundQueue::PRIO_COMMAND,
+                      reinterpret_cast<const uint8_t *>(json.c_str()), json.length(), false);
+        }
+
+        Disp::showStatus(state.lastStatus.c_str());
 
         if (LOG_VERBOSE)
         {
-            Serial.print(F("[HELLO][JSON] enviado size="));
+            Serial.print(F("[HELLO][JSON] enviado proto="));
+            Serial.print(WS_PROTO_VERSION);
+            Serial.print(F(" estado="));
+            Serial.print(statusToString(state.status));
+            Serial.print(F(" size="));
             Serial.println(json.length());
         }
 #endif
@@ -98,37 +871,37 @@ namespace WebSocketManager
     {
         getState().lastStatus = status;
 
-        String json;
-        json.reserve(128);
-        json += "{\"type\":\"status\",";
-        json += "\"carId\":\"";
-        json += CAR_ID_STR;
-        json += "\",";
-        json += "\"status\":\"";
-        json += status;
-        json += "\",";
-        json += "\"relayOn\":";
-        json += (Relay::isOn() ? "true" : "false");
-        json += "}";
-
-        g_webSocket.sendTXT(json);
-        Operation::getState().sessionSentFrames++;
+        const bool binary = (g_wireFormat == Json::FORMAT_MSGPACK);
+        const uint8_t *frame = nullptr;
+        size_t frameLength = 0;
+        if (StatusCache::lookup(status, Relay::isOn(), g_wireFormat,
+                                reinterpret_cast<uint8_t *>(g_txBuffer), sizeof(g_txBuffer), frame, frameLength))
+        {
+            sendFrame(OutboundQueue::KIND_STATUS, OutboundQueue::PRIO_STATUS, frame, frameLength, binary);
+        }
+        else
+        {
+            Serial.println(F("[STATUS][ERRO] Frame excedeu WS_TX_BUFFER_SIZE - não enviado"));
+        }
 
         Disp::showStatus(status);
 
         if (LOG_VERBOSE)
         {
-            Serial.print(F("[STATUS] carId="));
+            Serial.print(binary ? F("[STATUS][MSGPACK] carId=") : F("[STATUS] carId="));
             Serial.print(CAR_ID_STR);
             Serial.print(F(" status="));
             Serial.print(status);
             Serial.print(F(" relay="));
-            Serial.println(Relay::isOn() ? F("ON") : F("OFF"));
+            Serial.print(Relay::isOn() ? F("ON") : F("OFF"));
+            Serial.print(F(" size="));
+            Serial.println(frameLength);
         }
 
-        if (LOG_STATUS_JSON)
+        if (LOG_STATUS_JSON && !binary && frame)
         {
-            Serial.println(json);
+            Serial.write(frame, frameLength);
+            Serial.println();
         }
     }
 
@@ -142,49 +915,45 @@ namespace WebSocketManager
 
         g_lastHeartbeatAt = now;
 
-        String json;
-        json.reserve(256);
-        json += "{\"type\":\"heartbeat\",";
-        json += "\"carId\":\"";
-        json += CAR_ID_STR;
-        json += "\",";
-        json += "\"status\":\"";
-        json += getState().lastStatus;
-        json += "\",";
-        json += "\"relayOn\":";
-        json += (Relay::isOn() ? "true" : "false");
-        json += ",";
-        json += "\"rssi\":";
-        json += Net::rssi();
-        json += ",";
-        json += "\"ip\":\"";
-        json += Net::ip();
-        json += "\",";
-        json += "\"uptimeSec\":";
-        json += (now / 1000);
-        json += ",";
-        json += "\"heap\":";
-        json += getFreeHeap();
-        json += ",";
-        json += "\"operationState\":\"";
-        json += getState().status == OP_STOPPED ? "STOPPED" : getState().status == OP_ACTIVE       ? "ACTIVE"
-                                                          : getState().status == OP_PAUSED         ? "PAUSED"
-                                                          : getState().status == OP_LIBERATED_TIME ? "LIBERATED_TIME"
-                                                          : getState().status == OP_LIBERATED_FREE ? "LIBERATED_FREE"
-                                                                                                   : "UNKNOWN";
-        json += "\",";
-        json += "\"remainingSeconds\":";
-        json += getState().remainingSeconds;
-        json += ",";
-        json += "\"extraSeconds\":";
-        json += getState().extraSeconds;
-        json += ",";
-        json += "\"isCountingDown\":";
-        json += (getState().isCountingDown ? "true" : "false");
-        json += "}";
-
-        g_webSocket.sendTXT(json);
-        getState().sessionSentFrames++;
+#if defined(ESP8266)
+        uint32_t heapBefore = getFreeHeap();
+        uint32_t cyclesBefore = ESP.getCycleCount();
+#endif
+
+        const bool binary = (g_wireFormat == Json::FORMAT_MSGPACK);
+        Json::Writer json(g_txBuffer, sizeof(g_txBuffer));
+        MsgPack::Writer msg(reinterpret_cast<uint8_t *>(g_txBuffer), sizeof(g_txBuffer));
+        Heartbeat::FrameKind kind = binary ? Heartbeat::build(msg, now) : Heartbeat::build(json, now);
+        size_t frameLength = binary ? msg.length() : json.length();
+
+#if defined(ESP8266)
+        uint32_t buildCycles = ESP.getCycleCount() - cyclesBefore;
+        int32_t buildHeapDelta = (int32_t)heapBefore - (int32_t)getFreeHeap();
+#else
+        uint32_t buildCycles = 0;
+        int32_t buildHeapDelta = 0;
+#endif
+
+        if (binary ? msg.overflowed() : json.overflowed())
+        {
+            Serial.println(F("[HB][ERRO] Heartbeat excedeu WS_TX_BUFFER_SIZE - não enviado"));
+            return;
+        }
+
+        // Antes do envio: a compressão sobrescreve g_txBuffer
+        if (LOG_HEARTBEAT_JSON && !binary)
+        {
+            Serial.println(json.c_str());
+        }
+
+        OutboundQueue::PushResult queued = sendCompressible(OutboundQueue::KIND_HEARTBEAT, OutboundQueue::PRIO_HEARTBEAT,
+                                                            reinterpret_cast<uint8_t *>(g_txBuffer), frameLength, binary);
+
+        // Heartbeat anterior substituído/descartado: o próximo delta não teria base no gateway
+        if (queued != OutboundQueue::PUSH_QUEUED)
+        {
+            Heartbeat::requestKeyframe();
+        }
 
         if (LOG_VERBOSE)
         {
@@ -201,15 +970,14 @@ namespace WebSocketManager
             Serial.printf("| Relay      : %s\n", Relay::isOn() ? "ON" : "OFF");
             Serial.printf("| Uptime     : %lu s\n", now / 1000);
             Serial.printf("| Free Heap  : %d bytes\n", getFreeHeap());
+            Serial.printf("| Frame      : %s seq=%lu\n", Heartbeat::kindToString(kind), (unsigned long)Heartbeat::lastSequence());
+            Serial.printf("| Build      : %u bytes%s, %lu ciclos, heap %ld\n",
+                          (unsigned)frameLength, binary ? " (msgpack)" : "",
+                          (unsigned long)buildCycles, (long)buildHeapDelta);
             Serial.println(F("+==========================================+"));
             Serial.println();
         }
 
-        if (LOG_HEARTBEAT_JSON)
-        {
-            Serial.println(json);
-        }
-
         if (!LOG_VERBOSE)
         {
             printConnectionSnapshot();
@@ -270,16 +1038,187 @@ namespace WebSocketManager
 
         Serial.print(F(" heap="));
         Serial.print(getFreeHeap());
+
+        const OutboundQueue::Stats &outq = OutboundQueue::stats();
+        Serial.print(F(" outq="));
+        Serial.print(OutboundQueue::size());
+        Serial.print(F(" outq_coalesced="));
+        Serial.print(outq.coalesced);
+        Serial.print(F(" outq_dropped="));
+        Serial.print(outq.dropped);
+        Serial.print(F(" outq_deferred="));
+        Serial.print(outq.deferred);
+        const InboundQueue::Stats &inq = InboundQueue::stats();
+        Serial.print(F(" inq="));
+        Serial.print(InboundQueue::size());
+        Serial.print(F(" inq_max="));
+        Serial.print(inq.maxDepth);
+        Serial.print(F(" inq_rejected="));
+        Serial.print(inq.rejected);
+        Serial.print(F(" inq_deferred="));
+        Serial.print(inq.deferred);
+        Serial.print(F(" rl_op="));
+        Serial.print(RateLimiter::rejected(RateLimiter::CAT_OPERATION));
+        Serial.print(F(" rl_hc595="));
+        Serial.print(RateLimiter::rejected(RateLimiter::CAT_HC595));
+        Serial.print(F(" rl_msg="));
+        Serial.print(RateLimiter::rejected(RateLimiter::CAT_MESSAGE));
+        const StatusCache::Stats &sc = StatusCache::stats();
+        Serial.print(F(" status_hits="));
+        Serial.print(sc.hits);
+        Serial.print(F(" status_misses="));
+        Serial.print(sc.misses);
+        const Lzss::Stats &lz = Lzss::stats();
+        Serial.print(F(" lz_frames="));
+        Serial.print(lz.frames);
+        Serial.print(F(" lz_in="));
+        Serial.print(lz.bytesIn);
+        Serial.print(F(" lz_out="));
+        Serial.print(lz.bytesOut);
+        const HostProbe::Stats &probe = HostProbe::stats();
+        Serial.print(F(" probe_rounds="));
+        Serial.print(probe.rounds);
+        Serial.print(F(" probe_found="));
+        Serial.print(probe.found);
+        Serial.print(F(" probe_ms="));
+        Serial.print(probe.lastDurationMs);
+        const Discovery::Stats &disc = Discovery::stats();
+        Serial.print(F(" disc_rounds="));
+        Serial.print(disc.rounds);
+        Serial.print(F(" disc_found="));
+        Serial.print(disc.found);
+        Serial.print(F(" disc_ms="));
+        Serial.print(disc.lastMs);
+        Serial.print(F(" tm_windows="));
+        Serial.print(Telemetry::windowsClosed());
+        Serial.print(F(" tm_sent="));
+        Serial.print(Telemetry::windowsSent());
+        Serial.print(F(" hb_held="));
+        Serial.print(outq.heartbeatsHeld);
+        Serial.print(F(" hb_merged="));
+        Serial.print(outq.heartbeatsMerged);
+        Serial.print(F(" tx_free="));
+        Serial.print(outq.txFree);
+        Serial.print(F(" tx_free_min="));
+        Serial.print(outq.txFreeMin == SIZE_MAX ? 0 : outq.txFreeMin);
+        if (OutboundQueue::congested())
+        {
+            Serial.print(F(" tx=congestionado"));
+        }
         Serial.println();
     }
 
+    // Limite de taxa por categoria; false = frame recusado (comandos recebem nack)
+    static bool admitInboundFrame(const InboundFields &fields, bool isCommand, MessageHandler handler)
+    {
+        RateLimiter::Category category = RateLimiter::CAT_MESSAGE;
+        uint8_t cost = 1;
+
+        if (isCommand)
+        {
+            category = commandCategory(fields);
+            cost = fields.hasActions ? (fields.actionCount ? fields.actionCount : 1) : 1;
+        }
+        else if (handler == onSessionData || (!handler && fields.hasCarId && fields.hasStatus))
+        {
+            category = RateLimiter::CAT_OPERATION;
+        }
+
+        if (RateLimiter::allow(category, cost, millis()))
+        {
+            return true;
+        }
+
+        if (isCommand)
+        {
+            rejectCommandFrame(fields, Operation::ACTION_RATE_LIMITED);
+        }
+        return false;
+    }
+
+    // Roteia um frame completo (texto JSON ou binário MessagePack) para o handler
+    static void routeInboundFrame(const uint8_t *payload, size_t length, Json::Format format, uint32_t arrivedAtUs)
+    {
+        const bool binary = (format == Json::FORMAT_MSGPACK);
+        InboundFields fields;
+        fields.command.arrivedAtUs = arrivedAtUs;
+        bool parsed = scanInboundFrame(payload, length, format, fields);
+        MessageHandler handler = (parsed && !fields.type.empty()) ? MESSAGE_TABLE.find(fields.type) : nullptr;
+
+        // Processar mensagem: comandos só são enfileirados, a execução fica
+        // para processCommands() fora do callback da biblioteca
+        const bool isCommand = parsed && (fields.hasActions || !fields.action.empty());
+        if (!admitInboundFrame(fields, isCommand, handler))
+        {
+            return;
+        }
+
+        if (isCommand)
+        {
+            InboundQueue::PushResult queued = InboundQueue::push(payload, length, format, arrivedAtUs);
+            if (queued != InboundQueue::PUSH_QUEUED)
+            {
+                Serial.println(queued == InboundQueue::PUSH_FULL ? F("[CMD] Fila de comandos cheia - recusado")
+                                                                 : F("[CMD] Frame de comando maior que WS_INQ_SLOT_SIZE - recusado"));
+                rejectCommandFrame(fields, queued == InboundQueue::PUSH_FULL ? Operation::ACTION_BUSY
+                                                                             : Operation::ACTION_MALFORMED);
+            }
+        }
+        else if (handler)
+        {
+            handler(payload, length, format);
+        }
+        else if (parsed && fields.hasCarId && fields.hasStatus && !binary)
+        {
+            Operation::handleOperationMessage(reinterpret_cast<const char *>(payload), length);
+        }
+        else if (parsed && fields.hasType)
+        {
+            Serial.println(F("+==========================================+"));
+            Serial.println(F("| MENSAGEM DO SISTEMA                  |"));
+            Serial.println(F("+------------------------------------------+"));
+            Serial.print(F("| "));
+            if (binary)
+            {
+                Serial.print(F("[msgpack] type="));
+                Serial.write(reinterpret_cast<const uint8_t *>(fields.type.ptr), fields.type.len);
+            }
+            else
+            {
+                Serial.write(payload, length);
+            }
+            Serial.println();
+            Serial.println(F("+==========================================+"));
+        }
+        else
+        {
+            Serial.print(parsed ? F("[WS] Mensagem desconhecida: ") : F("[WS] Mensagem inválida: "));
+            if (binary)
+            {
+                Serial.print(length);
+                Serial.print(F(" bytes binários"));
+            }
+            else
+            {
+                Serial.write(payload, length);
+            }
+            Serial.println();
+        }
+    }
+
     void onEvent(WStype_t type, uint8_t *payload, size_t length)
     {
+        const uint32_t arrivedAtUs = micros();
         auto &state = Operation::getState();
 
         switch (type)
         {
         case WStype_CONNECTED:
+            // Toda conexão sai de startConnection() (loop() só roda em handshake ou sessão)
+            if (state.wsInHandshake)
+            {
+                HostScoreboard::recordHandshake(g_currentHostIndex, millis() - state.wsHandshakeStartedAt);
+            }
             state.lastInboundAt = millis();
             state.currentSessionStartedAt = millis();
             state.sessionSentFrames = 0;
@@ -287,8 +1226,16 @@ namespace WebSocketManager
             state.wsInHandshake = false;
             state.wsNextAllowedConnectAt = millis() + WS_BASE_RETRY_MS;
 
-            state.pendingHelloSend = true;
-            state.pendingHelloScheduledAt = millis();
+            HealthCheck::reset(); // só interessa enquanto desconectado
+            Heartbeat::reset();
+            g_wireFormat = Json::FORMAT_JSON;
+            g_compressFrames = false;
+            OutboundQueue::onConnected(millis());
+            Journal::setOnline(true);
+            Journal::onConnected();
+
+            // Abertura de sessão já no handshake: o gateway tem o estado em 1 RTT
+            sendSessionOpen();
 
             Serial.print(F("[WS][CONNECT] Heap livre: "));
             Serial.print(getFreeHeap());
@@ -312,7 +1259,7 @@ namespace WebSocketManager
             }
 
             Serial.print(F("[WS][INFO] host_atual="));
-            Serial.println(ALT_WS_HOSTS[g_currentHostIndex] ? ALT_WS_HOSTS[g_currentHostIndex] : "(null)");
+            Serial.println(currentHost() ? currentHost() : "(null)");
 
             if (state.currentSessionStartedAt)
             {
@@ -324,6 +1271,9 @@ namespace WebSocketManager
                 Serial.print(F(" recv="));
                 Serial.print(state.sessionRecvFrames);
                 Serial.println();
+
+                HostScoreboard::recordSession(g_currentHostIndex, dur / 1000);
+                state.currentSessionStartedAt = 0;
             }
 
             if (WS_CONNECT_ONCE)
@@ -350,69 +1300,78 @@ namespace WebSocketManager
                     Serial.println(F(" ms"));
                 }
 
-                WSUtils::rotateHost(ALT_WS_HOSTS, ALT_WS_HOSTS_COUNT, g_currentHostIndex, true);
+                // A próxima tentativa sonda todos os hosts de novo, em paralelo
+                g_hostVerified = false;
+            }
 
-                if (LOG_VERBOSE)
-                {
-                    Serial.print(F("[WS][BACKOFF] Próximo host: "));
-                    Serial.println(ALT_WS_HOSTS[g_currentHostIndex] ? ALT_WS_HOSTS[g_currentHostIndex] : "(null)");
-                }
+            Journal::setOnline(false);
+            g_streamActive = false;
+            g_rttPingPending = false;
+
+            // Descarta o que não vale na próxima sessão: hello/status/heartbeat e o
+            // lote do diário são refeitos na abertura, o ack volta com "duplicate"
+            // se o gateway reenviar o comando e binários só valem com o opt-in
+            g_wireFormat = Json::FORMAT_JSON;
+            g_compressFrames = false;
+            OutboundQueue::discardSessionFrames();
+
+            // Comandos ainda não executados morrem com a sessão: o ack deles
+            // sairia na próxima. O id só entra na janela de dedupe ao executar,
+            // então o reenvio do gateway roda normalmente
+            if (!InboundQueue::empty())
+            {
+                Serial.print(F("[CMD] Descartando comandos não executados: "));
+                Serial.println(InboundQueue::size());
+                InboundQueue::clear();
             }
 
             state.wsInHandshake = false;
             break;
 
         case WStype_TEXT:
-        {
             state.lastInboundAt = millis();
             state.sessionRecvFrames++;
-
-            String msg;
-            msg.reserve(length);
-            for (size_t i = 0; i < length; i++)
+            if (length > WS_MAX_FRAME)
             {
-                msg += (char)payload[i];
+                Serial.print(F("[WS] Frame acima de WS_MAX_FRAME descartado: "));
+                Serial.println(length);
+                break;
             }
+            routeInboundFrame(payload, length, Json::FORMAT_JSON, arrivedAtUs);
+            break;
 
-            // Processar mensagem
-            if (msg.indexOf("\"action\"") >= 0)
-            {
-                int idx = msg.indexOf("\"action\"");
-                int colon = msg.indexOf(':', idx);
-                int q1 = msg.indexOf('"', colon + 1);
-                int q2 = msg.indexOf('"', q1 + 1);
-
-                if (q1 >= 0 && q2 > q1)
-                {
-                    String action = msg.substring(q1 + 1, q2);
-                    Operation::handleAction(action);
-                }
-            }
-            else if (msg.indexOf("\"type\":\"session_data\"") >= 0)
-            {
-                Serial.println(F("[WS] Recebido session_data"));
-                Operation::handleSessionData(msg);
-            }
-            else if (msg.indexOf("\"carId\"") >= 0 && msg.indexOf("\"status\"") >= 0)
-            {
-                Operation::handleOperationMessage(msg);
-            }
-            else if (msg.indexOf("\"type\"") >= 0)
+        case WStype_BIN:
+            state.lastInboundAt = millis();
+            state.sessionRecvFrames++;
+            if (length > WS_MAX_FRAME)
             {
-                Serial.println(F("+==========================================+"));
-                Serial.println(F("| MENSAGEM DO SISTEMA                  |"));
-                Serial.println(F("+------------------------------------------+"));
-                Serial.print(F("| "));
-                Serial.println(msg);
-                Serial.println(F("+==========================================+"));
+                Serial.print(F("[WS] Frame acima de WS_MAX_FRAME descartado: "));
+                Serial.println(length);
+                break;
             }
-            else
+            routeInboundFrame(payload, length, Json::FORMAT_MSGPACK, arrivedAtUs);
+            break;
+
+        case WStype_FRAGMENT_TEXT_START:
+            state.lastInboundAt = millis();
+            beginStreamedFrame();
+            feedStreamedFrame(payload, length, false);
+            break;
+
+        case WStype_FRAGMENT_BIN_START:
+            state.lastInboundAt = millis();
+            abortStreamedFrame(F("MessagePack fragmentado não suportado"));
+            break;
+
+        case WStype_FRAGMENT:
+        case WStype_FRAGMENT_FIN:
+            state.lastInboundAt = millis();
+            if (type == WStype_FRAGMENT_FIN)
             {
-                Serial.print(F("[WS] Mensagem desconhecida: "));
-                Serial.println(msg);
+                state.sessionRecvFrames++;
             }
+            feedStreamedFrame(payload, length, type == WStype_FRAGMENT_FIN);
             break;
-        }
 
         case WStype_PING:
             state.lastInboundAt = millis();
@@ -426,6 +1385,7 @@ namespace WebSocketManager
         case WStype_PONG:
             state.lastInboundAt = millis();
             state.sessionRecvFrames++;
+            onPong(payload, length);
             if (LOG_VERBOSE)
             {
                 Serial.println(F("[WS] PONG recebido - Conexao ativa!"));
@@ -438,7 +1398,7 @@ namespace WebSocketManager
                 Serial.print(F("[WS][ERRO] Evento erro length="));
                 Serial.println(length);
                 Serial.print(F("[WS][ERRO] host_atual="));
-                Serial.println(ALT_WS_HOSTS[g_currentHostIndex] ? ALT_WS_HOSTS[g_currentHostIndex] : "(null)");
+                Serial.println(currentHost() ? currentHost() : "(null)");
             }
             break;
 
@@ -450,13 +1410,50 @@ namespace WebSocketManager
     void tryHttpHealthcheck()
     {
         auto &state = Operation::getState();
+        unsigned long now = millis();
+
+        // Verificação em andamento: só timeout e conclusão, sem bloquear
+        HealthCheck::poll(now);
+        if (HealthCheck::state() == HealthCheck::RUNNING)
+        {
+            return;
+        }
+        if (HealthCheck::state() == HealthCheck::DONE)
+        {
+            const HealthCheck::Result &result = HealthCheck::result();
+            if (result.httpStatus > 0)
+            {
+                Serial.print(F("[HTTP][HEALTH] status="));
+                Serial.print(result.httpStatus);
+                Serial.print(F(" ok="));
+                Serial.print(result.statusOk ? F("sim") : F("não"));
+                Serial.print(F(" ms="));
+                Serial.println(result.latencyMs);
+            }
+            else
+            {
+                Serial.print(F("[HTTP][HEALTH][ERRO] Sem resposta em "));
+                Serial.print(result.latencyMs);
+                Serial.println(F(" ms"));
+            }
+
+            if (result.httpStatus == 200)
+            {
+                HostScoreboard::recordHealth(g_healthHostIndex, result.latencyMs);
+            }
+            else
+            {
+                HostScoreboard::recordFailure(g_healthHostIndex);
+            }
+            HealthCheck::reset();
+        }
 
         if (WS_CONNECT_ONCE && state.wsConnectGaveUp)
         {
             return;
         }
 
-        const char *host = ALT_WS_HOSTS[g_currentHostIndex];
+        const char *host = currentHost();
         if (!host || strlen(host) == 0)
         {
             return;
@@ -471,42 +1468,21 @@ namespace WebSocketManager
             return;
         }
 
-        unsigned long now = millis();
         if (now - state.lastHealthcheckAt < 15000)
         {
             return;
         }
 
-        if (g_webSocket.isConnected())
+        // Busca de host em andamento (sondas ocupam os PCBs TCP): o health check espera
+        if (g_webSocket.isConnected() || HostProbe::state() == HostProbe::RUNNING ||
+            Discovery::state() == Discovery::RUNNING)
         {
             return;
         }
 
         state.lastHealthcheckAt = now;
-
-        WiFiClient client;
-        HTTPClient http;
-        String url = String("http://") + host + ":" + WS_PORT + "/api/ws/health";
-
-        if (http.begin(client, url))
-        {
-            int code = http.GET();
-            if (code > 0)
-            {
-                String payload = http.getString();
-                Serial.print(F("[HTTP][HEALTH] status="));
-                Serial.print(code);
-                Serial.print(F(" body="));
-                Serial.println(payload);
-            }
-            else
-            {
-                Serial.print(F("[HTTP][HEALTH][ERRO] code="));
-                Serial.println(code);
-            }
-            http.end();
-        }
-        else
+        g_healthHostIndex = g_currentHostIndex;
+        if (!HealthCheck::start(host, currentPort(), now))
         {
             Serial.println(F("[HTTP][HEALTH][ERRO] Falha em iniciar conexão"));
         }
@@ -543,62 +1519,147 @@ namespace WebSocketManager
                 Serial.print(F("] "));
                 Serial.println(ALT_WS_HOSTS[i] ? ALT_WS_HOSTS[i] : "(null)");
             }
+            if (WS_HOST_SHARDING)
+            {
+                uint8_t order[WS_PROBE_MAX_HOSTS];
+                Rendezvous::order(ALT_WS_HOSTS, ALT_WS_HOSTS_COUNT, CAR_ID_STR, order);
+                Serial.print(F("[WS] Sharding (rendezvous) - ordem deste carro:"));
+                for (size_t i = 0; i < ALT_WS_HOSTS_COUNT && i < WS_PROBE_MAX_HOSTS; i++)
+                {
+                    Serial.print(' ');
+                    Serial.print(order[i]);
+                }
+                Serial.println();
+            }
             Serial.println();
         }
 
-        const char *host = ALT_WS_HOSTS[g_currentHostIndex];
-        if (!host || strlen(host) == 0)
+        // Host não confirmado: primeiro a descoberta por broadcast (uma ida e
+        // volta); o gateway que responder é usado direto
+        if (DISCOVERY_ENABLED && !g_hostVerified)
         {
-            Serial.println(F("[WS][ERRO] Host vazio ao iniciar."));
-            return;
+            if (Discovery::state() == Discovery::IDLE)
+            {
+                Discovery::start(now);
+            }
+            if (Discovery::state() == Discovery::RUNNING)
+            {
+                return;
+            }
+
+            if (Discovery::found())
+            {
+                // Host da lista com a mesma porta pontua no slot dele; outro
+                // endereço ocupa o slot do host descoberto
+                g_currentHostIndex = DISCOVERED_HOST;
+                for (size_t i = 0; i < ALT_WS_HOSTS_COUNT; i++)
+                {
+                    if (Discovery::port() == WS_PORT && ALT_WS_HOSTS[i] && strcmp(ALT_WS_HOSTS[i], Discovery::host()) == 0)
+                    {
+                        g_currentHostIndex = i;
+                        break;
+                    }
+                }
+                if (g_currentHostIndex == DISCOVERED_HOST)
+                {
+                    HostScoreboard::setDiscovered(Discovery::host(), Discovery::port());
+                }
+                g_hostVerified = true;
+            }
         }
 
-        if (WSUtils::isSelfHost(host))
+        // Ninguém respondeu e há vários candidatos: o host só é usado depois de
+        // aceitar uma conexão TCP em uma rodada de HostProbe (todos sondados ao
+        // mesmo tempo, sem bloquear o loop). Host confirmado conecta direto.
+        if (ALT_WS_HOSTS_COUNT > 1 && !g_hostVerified)
         {
-            Serial.print(F("[WS][SKIP] Host é o IP da própria placa ("));
-            Serial.print(host);
-            Serial.println(F(") — rotacionando"));
+            switch (HostProbe::state())
+            {
+            case HostProbe::IDLE:
+            {
+                // Sharding: ordem rendezvous do carro, e vence o primeiro dela que aceitar.
+                // Senão, melhores do placar sondados primeiro e preferidos no desempate
+                uint8_t order[WS_PROBE_MAX_HOSTS];
+                if (WS_HOST_SHARDING)
+                {
+                    Rendezvous::order(ALT_WS_HOSTS, ALT_WS_HOSTS_COUNT, CAR_ID_STR, order);
+                }
+                else
+                {
+                    HostScoreboard::ranking(order, WS_PROBE_MAX_HOSTS);
+                }
+                if (!HostProbe::start(ALT_WS_HOSTS, ALT_WS_HOSTS_COUNT, WS_PORT, now, order, WS_HOST_SHARDING))
+                {
+                    Discovery::reset();
+                    state.wsNextAllowedConnectAt = now + WS_MAX_RETRY_MS;
+                }
+                return;
+            }
 
-            WSUtils::rotateHost(ALT_WS_HOSTS, ALT_WS_HOSTS_COUNT, g_currentHostIndex, true);
-            host = ALT_WS_HOSTS[g_currentHostIndex];
+            case HostProbe::RUNNING:
+                return;
 
-            if (!host || !*host || WSUtils::isSelfHost(host))
+            case HostProbe::DONE:
             {
-                Serial.println(F("[WS][ERRO] Sem host válido diferente do IP da placa."));
-                if (WS_CONNECT_ONCE)
+                int winner = HostProbe::winner();
+                for (size_t i = 0; i < ALT_WS_HOSTS_COUNT; i++)
                 {
-                    state.wsConnectGaveUp = true;
-                    Serial.println(F("[WS][CONNECT_ONCE] Parando tentativas - configure WS_HOST_STR."));
+                    uint32_t connectMs;
+                    if (HostProbe::connectTime(i, connectMs))
+                    {
+                        HostScoreboard::recordConnect(i, connectMs);
+                    }
+                    else if (HostProbe::failed(i))
+                    {
+                        HostScoreboard::recordFailure(i);
+                    }
                 }
-                return;
+                HostProbe::reset();
+                Discovery::reset(); // a próxima busca volta a começar pelo broadcast
+                if (winner < 0)
+                {
+                    state.wsNextAllowedConnectAt = now + WS_BASE_RETRY_MS;
+                    return;
+                }
+                g_currentHostIndex = (size_t)winner;
+                g_hostVerified = true;
+                break;
+            }
             }
         }
 
-        // Teste rápido de conectividade antes de tentar WebSocket
-        Serial.print(F("[WS] Tentativa de conexão com: "));
-        Serial.println(host);
+        Discovery::reset();
 
-        if (!WSUtils::isHostReachable(host, WS_PORT, 2000))
+        const char *host = currentHost();
+        uint16_t port = currentPort();
+        if (!host || !*host || WSUtils::isSelfHost(host))
         {
-            Serial.println(F("[WS] Host não alcançável, rotacionando para próximo..."));
-            WSUtils::rotateHost(ALT_WS_HOSTS, ALT_WS_HOSTS_COUNT, g_currentHostIndex, true);
-
-            // Agendar próxima tentativa mais cedo para testar o próximo host
-            state.wsNextAllowedConnectAt = now + 1000; // 1 segundo apenas
+            Serial.println(F("[WS][ERRO] Sem host válido diferente do IP da placa."));
+            if (WS_CONNECT_ONCE)
+            {
+                state.wsConnectGaveUp = true;
+                Serial.println(F("[WS][CONNECT_ONCE] Parando tentativas - configure WS_HOST_STR."));
+            }
+            else
+            {
+                state.wsNextAllowedConnectAt = now + WS_MAX_RETRY_MS;
+            }
             return;
         }
 
         Serial.print(F("[WS] ✓ Conectando WebSocket a ws://"));
         Serial.print(host);
         Serial.print(":");
-        Serial.print(WS_PORT);
+        Serial.print(port);
         Serial.print(F("/ws?carId="));
         Serial.println(CAR_ID_STR);
 
         String path = String("/ws?carId=") + CAR_ID_STR;
-        g_webSocket.begin(host, WS_PORT, path.c_str());
+        g_webSocket.begin(host, port, path.c_str());
         g_webSocket.onEvent(onEvent);
-        g_webSocket.setReconnectInterval(5000);
+        // Falha de conexão não é repetida pela biblioteca dentro do handshake:
+        // o timeout acima devolve a decisão para a busca de host
+        g_webSocket.setReconnectInterval(2 * WS_HANDSHAKE_TIMEOUT_MS);
         g_webSocket.enableHeartbeat(30000, 10000, 2);
 
         state.lastWsConnectAttemptAt = millis();
@@ -607,19 +1668,22 @@ namespace WebSocketManager
         state.wsHandshakeStartedAt = state.lastWsConnectAttemptAt;
     }
 
-    void update()
+    void processCommands()
     {
-        g_webSocket.loop();
+        runQueuedCommands();
+    }
 
+    void update()
+    {
         auto &state = Operation::getState();
 
-        // Envio atrasado do HELLO/STATUS se configurado
-        if (state.pendingHelloSend &&
-            (millis() - state.pendingHelloScheduledAt >= (unsigned long)WS_HELLO_DELAY_MS))
+        // Só startConnection() abre conexão: fora de sessão e de handshake a
+        // biblioteca não roda, senão a reconexão automática dela faria um
+        // connect() bloqueante ao host antigo enquanto a descoberta e as
+        // sondas procuram outro
+        if (g_webSocket.isConnected() || state.wsInHandshake)
         {
-            state.pendingHelloSend = false;
-            sendHello();
-            publishStatus("STOPPED");
+            g_webSocket.loop();
         }
 
 // Envio periódico de heartbeat (se habilitado e conectado)
@@ -630,8 +1694,29 @@ namespace WebSocketManager
         }
 #endif
 
-        // Se não conectado e tem host configurado
-        if (!g_webSocket.isConnected() && strlen(WS_HOST_STR) != 0)
+        // Replay do diário offline (o hello, em PRIO_COMMAND, sai antes)
+        if (g_webSocket.isConnected())
+        {
+            sendJournalBatch();
+        }
+
+        // Telemetria agregada + medição de RTT
+#if TELEMETRY_WINDOW_SAMPLES
+        if (g_webSocket.isConnected())
+        {
+            sendTelemetry();
+            sendRttPing();
+        }
+#endif
+
+        // Drenagem da fila de saída (um frame por intervalo de pacing)
+        if (g_webSocket.isConnected())
+        {
+            OutboundQueue::drain(transmitFrame, millis(), g_webSocket.txAvailable());
+        }
+
+        // Se não conectado e tem host configurado (ou a descoberta pode achar um)
+        if (!g_webSocket.isConnected() && (strlen(WS_HOST_STR) != 0 || DISCOVERY_ENABLED))
         {
             unsigned long now = millis();
 
@@ -646,6 +1731,7 @@ namespace WebSocketManager
                 }
 
                 state.wsInHandshake = false;
+                g_webSocket.disconnect(); // fecha o TCP meio aberto; loop() para de rodar
 
                 if (WS_CONNECT_ONCE)
                 {
@@ -655,16 +1741,15 @@ namespace WebSocketManager
                 else
                 {
                     state.wsNextAllowedConnectAt = now + WS_BASE_RETRY_MS;
-                    WSUtils::rotateHost(ALT_WS_HOSTS, ALT_WS_HOSTS_COUNT, g_currentHostIndex, true);
-
-                    if (LOG_VERBOSE)
-                    {
-                        Serial.print(F("[WS][TIMEOUT] Próximo host: "));
-                        Serial.println(ALT_WS_HOSTS[g_currentHostIndex] ? ALT_WS_HOSTS[g_currentHostIndex] : "(null)");
-                    }
+                    g_hostVerified = false;
                 }
+                HostScoreboard::recordFailure(g_currentHostIndex);
             }
 
+            // Busca de host em andamento: só timeouts e repetições/novas sondas, sem bloquear
+            Discovery::poll(now);
+            HostProbe::poll(now);
+
             // Tentar conectar quando permitido
             if (!state.wsInHandshake && now >= state.wsNextAllowedConnectAt)
             {
@@ -673,7 +1758,7 @@ namespace WebSocketManager
                     return;
                 }
 
-                if (LOG_VERBOSE)
+                if (LOG_VERBOSE && HostProbe::state() == HostProbe::IDLE && Discovery::state() == Discovery::IDLE)
                 {
                     Serial.print(F("[WS][DEBUG] Tentando conectar. RSSI="));
                     Serial.print(Net::rssi());
@@ -2,6 +2,7 @@
 
 #include <Arduino.h>
 #include <WebSocketsClient.h>
+#include "../Json/json_tokenizer.h"
 
 namespace WebSocketManager
 {
@@ -9,18 +10,21 @@ namespace WebSocketManager
     // ===== INICIALIZAÇÃO E CONTROLE =====
     void initialize();
     void update();
+    void processCommands(); // executa comandos recebidos (orçamento WS_CMD_BUDGET_US)
     void startConnection();
 
     // ===== EVENTOS =====
     void onEvent(WStype_t type, uint8_t *payload, size_t length);
 
     // ===== ENVIO DE MENSAGENS =====
-    void sendHello();
+    void sendSessionOpen(); // hello + estado atual, enviado no CONNECTED
     void sendHeartbeat();
     void publishStatus(const char *status);
 
     // ===== ESTADO DA CONEXÃO =====
     bool isConnected();
+    void setEncoding(Json::Format format); // JSON (texto) ou MessagePack (binário)
+    Json::Format encoding();
     void tryHttpHealthcheck();
 
     // ===== DIAGNÓSTICO =====
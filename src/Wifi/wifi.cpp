@@ -227,6 +227,13 @@ namespace Net
 #endif
     }
 
+    IPAddress localIp()
+    {
+        if (!isConnected())
+            return IPAddress();
+        return WiFi.localIP();
+    }
+
     const char *hostname()
     {
         return g_hostname;
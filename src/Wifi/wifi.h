@@ -1,5 +1,6 @@
 #pragma once
 #include <Arduino.h>
+#include <IPAddress.h>
 
 namespace Net
 {
@@ -13,6 +14,7 @@ namespace Net
     bool setupMDNS(const char *hostname);
     long rssi();
     String ip();
+    IPAddress localIp(); // sem alocação; 0.0.0.0 se desconectado
     const char *hostname();
     bool waitConnected(unsigned long timeoutMs);
 }
@@ -20,6 +20,8 @@
 #include "Reley/reley.h"
 #include "HC595/HC595.h"
 #include "Status/status_led.h"
+#include "Journal/event_journal.h"
+#include "WebSocket/telemetry.h"
 
 // ===== VALIDAÇÃO DE CONFIGURAÇÃO =====
 #ifdef STATIC_IP_ADDR
@@ -31,10 +33,6 @@
 #endif
 #endif
 
-// ===== Modo de compatibilidade do HELLO =====
-#define WS_HELLO_SIMPLE
-#undef WS_HELLO_COMPAT
-
 /**
  * @brief Executa teste inicial do módulo HC595
  */
@@ -42,6 +40,11 @@ void performHC595Test()
 {
   Serial.println(F("[HC595] Executando teste inicial..."));
   HC595::runningLight(100);
+  while (HC595::isAnimating())
+  {
+    HC595::loop();
+    delay(1);
+  }
   delay(500);
   HC595::setByte(0b10101010);
   HC595::update();
@@ -100,6 +103,7 @@ void setup()
 
   // Inicializar gerenciadores
   Operation::initialize();
+  Journal::begin();
   WebSocketManager::initialize();
 
   // ===== CONFIGURAÇÃO DE REDE =====
@@ -141,6 +145,8 @@ void setup()
  */
 void loop()
 {
+  const uint32_t loopStartedAt = micros();
+
   // ===== STATUS PERIÓDICO DO SISTEMA =====
   static unsigned long lastSystemStatus = 0;
   if (millis() - lastSystemStatus > 60000) // A cada 1 minuto
@@ -161,12 +167,19 @@ void loop()
   Net::loop();
   StatusLED::update(); // Atualiza LED WiFi baseado no status da conexão
   WebSocketManager::update();
+  WebSocketManager::processCommands(); // fora do callback do WebSocket
+  HC595::loop();
   Operation::update();
+  Journal::loop();
   Disp::loop();
 
   // ===== PROCESSAMENTO DE COMANDOS SERIAL =====
   SerialCommands::processCommands();
 
+  // ===== TELEMETRIA (duração da iteração, sem o delay) =====
+  Telemetry::recordLoop(micros() - loopStartedAt);
+  Telemetry::update(millis());
+
   // ===== DELAY DO LOOP =====
   delay(LOOP_DELAY_MS);
 }
@@ -0,0 +1,66 @@
+#pragma once
+
+// Arduino.h mínimo para o ambiente native (platformio.ini): só o que os
+// módulos testados no host usam (tempo, Serial, PROGMEM e o contador de
+// ciclos do benchmark). Não faz parte do firmware.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#define F(text) (text)
+
+// No host a "flash" é memória comum
+#define PROGMEM
+#define PGM_P const char *
+#define memcpy_P memcpy
+
+inline unsigned long micros()
+{
+    using namespace std::chrono;
+    static const steady_clock::time_point started = steady_clock::now();
+    return (unsigned long)duration_cast<microseconds>(steady_clock::now() - started).count();
+}
+
+inline unsigned long millis()
+{
+    return micros() / 1000;
+}
+
+// Saída serial vai para stdout (os testes mostram os logs dos módulos)
+struct HostSerial
+{
+    void print(const char *text) { fputs(text, stdout); }
+    void print(char c) { fputc(c, stdout); }
+    void print(long value) { printf("%ld", value); }
+    void print(unsigned long value) { printf("%lu", value); }
+    void print(int value) { printf("%d", value); }
+    void print(unsigned value) { printf("%u", value); }
+    void println() { fputc('\n', stdout); }
+    void printf(const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        vprintf(format, args);
+        va_end(args);
+    }
+    template <typename T>
+    void println(T value)
+    {
+        print(value);
+        println();
+    }
+};
+
+inline HostSerial Serial;
+
+// ESP.getCycleCount(): microssegundos no lugar de ciclos (só o benchmark usa)
+struct HostEsp
+{
+    uint32_t getCycleCount() { return (uint32_t)micros(); }
+};
+
+inline HostEsp ESP;
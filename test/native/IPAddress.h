@@ -0,0 +1,19 @@
+#pragma once
+
+// IPAddress mínimo para o ambiente native: só o que os writers usam
+
+#include <cstdint>
+
+class IPAddress
+{
+public:
+    IPAddress() = default;
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d}, _set(true) {}
+
+    bool isSet() const { return _set; }
+    uint8_t operator[](int index) const { return _bytes[index]; }
+
+private:
+    uint8_t _bytes[4] = {};
+    bool _set = false;
+};
@@ -0,0 +1,79 @@
+// Testes da consulta de descoberta no host (pio test -e native)
+//
+// O env native compila com o CAR_ID_STR de uma placa real (formato de
+// generate-car-id.js); o frame discover precisa caber em QUERY_SIZE.
+
+#include <unity.h>
+#include "Config/config.h"
+#include "Protocol/messages.h"
+#include "WS/gateway_discovery.h"
+
+static_assert(Json::literalLength(CAR_ID_STR) >= 27, "Testar com um CAR_ID_STR de tamanho real (CAR-<timestamp>-<sufixo>)");
+
+namespace
+{
+    const char EXPECTED_HEAD[] = "{\"type\":\"discover\",\"carId\":\"" CAR_ID_STR "\",\"proto\":";
+
+    bool encode(uint32_t proto, char *frame, size_t capacity, size_t &length)
+    {
+        Json::Writer json(frame, capacity);
+        Protocol::DiscoverMsg query;
+        query.proto = proto;
+        bool ok = Protocol::encodeDiscover(query, json);
+        length = json.length();
+        return ok && !json.overflowed();
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_query_fits_with_real_car_id()
+{
+    char frame[Discovery::QUERY_SIZE];
+    size_t length = 0;
+    TEST_ASSERT_TRUE(encode(Protocol::SCHEMA_VERSION, frame, sizeof(frame), length));
+    TEST_ASSERT_EQUAL_STRING_LEN(EXPECTED_HEAD, frame, sizeof(EXPECTED_HEAD) - 1);
+    TEST_ASSERT_EQUAL(sizeof(EXPECTED_HEAD) - 1 + 2, length); // "1}"
+    TEST_ASSERT_EQUAL('}', frame[length - 1]);
+}
+
+void test_query_size_covers_largest_proto()
+{
+    char frame[Discovery::QUERY_SIZE];
+    size_t length = 0;
+    TEST_ASSERT_TRUE(encode(UINT32_MAX, frame, sizeof(frame), length));
+    TEST_ASSERT_EQUAL(Discovery::QUERY_SIZE - 1, length);
+
+    // Limite justo: um byte a menos já não cabe
+    TEST_ASSERT_FALSE(encode(UINT32_MAX, frame, sizeof(frame) - 1, length));
+}
+
+void test_old_fixed_buffer_overflowed()
+{
+    // O buffer de 64 bytes anterior não comportava um carId real
+    char frame[64];
+    size_t length = 0;
+    TEST_ASSERT_FALSE(encode(Protocol::SCHEMA_VERSION, frame, sizeof(frame), length));
+}
+
+void test_query_round_trip()
+{
+    char frame[Discovery::QUERY_SIZE];
+    size_t length = 0;
+    TEST_ASSERT_TRUE(encode(Protocol::SCHEMA_VERSION, frame, sizeof(frame), length));
+
+    Protocol::DiscoverMsg decoded;
+    TEST_ASSERT_TRUE(Protocol::decodeDiscover(reinterpret_cast<const uint8_t *>(frame), length, Json::FORMAT_JSON, decoded));
+    TEST_ASSERT_EQUAL(Protocol::SCHEMA_VERSION, decoded.proto);
+}
+
+int main(int, char **)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_query_fits_with_real_car_id);
+    RUN_TEST(test_query_size_covers_largest_proto);
+    RUN_TEST(test_old_fixed_buffer_overflowed);
+    RUN_TEST(test_query_round_trip);
+    return UNITY_END();
+}
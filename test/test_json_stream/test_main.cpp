@@ -0,0 +1,209 @@
+// Testes do Json::StreamTokenizer e do SessionDataParser no host (pio test -e native)
+//
+// Cada amostra é entregue em milhares de fatiamentos aleatórios; os tokens
+// e o SessionData resultantes têm de ser iguais aos da passada única sobre
+// o frame inteiro.
+
+#include <unity.h>
+#include <string>
+#include "Config/config.h"
+#include "Json/json_stream.h"
+#include "Operation/session_data.h"
+
+namespace
+{
+    const int CHUNKINGS = 2000;
+
+    const char *const SAMPLES[] = {
+        "{\"type\":\"session_data\",\"carId\":\"CAR-1\",\"data\":{\"status\":\"ACTIVE\",\"duration\":600,"
+        "\"initialMinutes\":10,\"remainingTime\":{\"minutes\":5,\"total_seconds\":300},"
+        "\"notes\":\"lorem ipsum dolor sit amet \\\"q\\\" consectetur\",\"flags\":[true,false,null,1.5e3]}}",
+        "{\"session_data\":{\"duration\":42},\"meta\":{\"data\":{\"duration\":7}}}",
+        "{\"session_data\":{\"duration\":42,\"status\":\"PAUSED\"}}",
+        "{\"a\":[{\"data\":1},{\"data\":{\"initialMinutes\":3}}],\"data\":{\"duration\":9}}",
+        "{\"type\":\"session_data\",\"data\":{\"remainingTime\":{\"total_seconds\":60}}}",
+    };
+
+    // Gerador determinístico: a mesma sequência de fatiamentos em toda execução
+    uint32_t g_seed = 20240917;
+
+    uint32_t nextRandom()
+    {
+        g_seed = g_seed * 1103515245u + 12345u;
+        return g_seed >> 8;
+    }
+
+    // Representação textual dos tokens para comparar as duas passadas
+    void appendToken(std::string &out, const Json::Token &tok)
+    {
+        out += std::to_string(tok.type);
+        out += ':';
+        out += std::to_string(tok.depth);
+        out += ':';
+        out.append(tok.text.ptr, tok.text.len);
+        out += '|';
+    }
+
+    struct Collected
+    {
+        std::string tokens;
+        Operation::SessionDataParser parser;
+    };
+
+    void onToken(const Json::Token &tok, void *context)
+    {
+        Collected *collected = static_cast<Collected *>(context);
+        appendToken(collected->tokens, tok);
+        collected->parser.feed(tok);
+    }
+
+    std::string singlePass(const std::string &frame)
+    {
+        std::string out;
+        Json::Tokenizer tok(reinterpret_cast<const uint8_t *>(frame.data()), frame.size());
+        Json::Token t;
+        while (tok.next(t))
+        {
+            appendToken(out, t);
+        }
+        TEST_ASSERT_EQUAL(Json::TOK_END, t.type);
+        return out;
+    }
+
+    void assertSameSession(const SessionData &expected, const SessionData &actual)
+    {
+        TEST_ASSERT_EQUAL(expected.found, actual.found);
+        TEST_ASSERT_EQUAL(expected.totalSeconds, actual.totalSeconds);
+        TEST_ASSERT_EQUAL(expected.duration, actual.duration);
+        TEST_ASSERT_EQUAL(expected.initialMinutes, actual.initialMinutes);
+        TEST_ASSERT_EQUAL_STRING(expected.status, actual.status);
+    }
+
+    // Entrega 'frame' em pedaços aleatórios de 1..maxChunk bytes
+    bool feedChunked(const std::string &frame, size_t maxChunk, Json::StreamTokenizer &stream, Collected &collected)
+    {
+        const uint8_t *data = reinterpret_cast<const uint8_t *>(frame.data());
+        size_t pos = 0;
+        while (pos < frame.size())
+        {
+            size_t n = 1 + nextRandom() % maxChunk;
+            if (n > frame.size() - pos)
+            {
+                n = frame.size() - pos;
+            }
+            if (!stream.feed(data + pos, n, onToken, &collected))
+            {
+                return false;
+            }
+            pos += n;
+        }
+        return stream.finish(onToken, &collected);
+    }
+
+    // session_data grande como o "session_frag" de server-simple.js
+    std::string largeSession()
+    {
+        std::string frame = "{\"type\":\"session_data\",\"history\":[";
+        for (int i = 0; i < 60; i++)
+        {
+            frame += (i ? ",{\"at\":" : "{\"at\":") + std::to_string(1759327346444LL - i * 60000LL) + ",\"event\":\"tick\"}";
+        }
+        frame += "],\"data\":{\"remainingTime\":{\"total_seconds\":90}}}";
+        return frame;
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_random_chunkings_match_single_pass()
+{
+    char window[WS_STREAM_WINDOW];
+    for (const char *sample : SAMPLES)
+    {
+        std::string frame(sample);
+        std::string expectedTokens = singlePass(frame);
+        SessionData expected;
+        bool found = Operation::parseSessionData(reinterpret_cast<const uint8_t *>(frame.data()), frame.size(), expected);
+
+        for (int trial = 0; trial < CHUNKINGS; trial++)
+        {
+            Collected collected;
+            Json::StreamTokenizer stream(window, sizeof(window));
+            TEST_ASSERT_TRUE_MESSAGE(feedChunked(frame, 20, stream, collected), sample);
+            TEST_ASSERT_TRUE_MESSAGE(collected.tokens == expectedTokens, sample);
+
+            SessionData actual;
+            TEST_ASSERT_EQUAL(found, collected.parser.finish(actual));
+            assertSameSession(expected, actual);
+        }
+    }
+}
+
+void test_large_session_in_gateway_fragments()
+{
+    std::string frame = largeSession();
+    TEST_ASSERT_TRUE(frame.size() > 4 * WS_STREAM_WINDOW);
+
+    // Fragmentos de 200 B, como o gateway envia
+    char window[WS_STREAM_WINDOW];
+    Json::StreamTokenizer stream(window, sizeof(window));
+    Collected collected;
+    for (size_t pos = 0; pos < frame.size(); pos += 200)
+    {
+        size_t n = frame.size() - pos < 200 ? frame.size() - pos : 200;
+        TEST_ASSERT_TRUE(stream.feed(reinterpret_cast<const uint8_t *>(frame.data()) + pos, n, onToken, &collected));
+    }
+    TEST_ASSERT_TRUE(stream.finish(onToken, &collected));
+    TEST_ASSERT_EQUAL(frame.size(), stream.consumed());
+    TEST_ASSERT_TRUE(collected.tokens == singlePass(frame));
+
+    SessionData session;
+    TEST_ASSERT_TRUE(collected.parser.finish(session));
+    TEST_ASSERT_EQUAL(90, session.seconds());
+}
+
+void test_token_larger_than_window_aborts()
+{
+    char window[16];
+    Json::StreamTokenizer stream(window, sizeof(window));
+    Collected collected;
+    const char *frame = "{\"k\":\"0123456789abcdefghij\"}";
+    TEST_ASSERT_FALSE(stream.feed(reinterpret_cast<const uint8_t *>(frame), strlen(frame), onToken, &collected));
+    TEST_ASSERT_EQUAL(Json::STREAM_TOKEN_TOO_LARGE, stream.error());
+
+    // Depois do erro nenhum pedaço é aceito até reset()
+    TEST_ASSERT_FALSE(stream.feed(reinterpret_cast<const uint8_t *>("}"), 1, onToken, &collected));
+    stream.reset();
+    TEST_ASSERT_TRUE(stream.feed(reinterpret_cast<const uint8_t *>("{}"), 2, onToken, &collected));
+    TEST_ASSERT_TRUE(stream.finish(onToken, &collected));
+}
+
+void test_truncated_and_malformed_streams()
+{
+    char window[WS_STREAM_WINDOW];
+    Collected collected;
+
+    Json::StreamTokenizer truncated(window, sizeof(window));
+    TEST_ASSERT_TRUE(truncated.feed(reinterpret_cast<const uint8_t *>("{\"a\":1"), 6, onToken, &collected));
+    TEST_ASSERT_FALSE(truncated.finish(onToken, &collected));
+    TEST_ASSERT_EQUAL(Json::STREAM_TRUNCATED, truncated.error());
+
+    Json::StreamTokenizer cut(window, sizeof(window));
+    TEST_ASSERT_TRUE(cut.feed(reinterpret_cast<const uint8_t *>("{\"a\":\"ab"), 8, onToken, &collected));
+    TEST_ASSERT_FALSE(cut.finish(onToken, &collected));
+
+    Json::StreamTokenizer malformed(window, sizeof(window));
+    TEST_ASSERT_FALSE(malformed.feed(reinterpret_cast<const uint8_t *>("{\"a\":1]"), 7, onToken, &collected));
+    TEST_ASSERT_EQUAL(Json::STREAM_MALFORMED, malformed.error());
+}
+
+int main(int, char **)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_random_chunkings_match_single_pass);
+    RUN_TEST(test_large_session_in_gateway_fragments);
+    RUN_TEST(test_token_larger_than_window_aborts);
+    RUN_TEST(test_truncated_and_malformed_streams);
+    return UNITY_END();
+}
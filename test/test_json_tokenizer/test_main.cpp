@@ -0,0 +1,380 @@
+// Testes do Json::Tokenizer no host (pio test -e native)
+//
+// Reproduz frames recebidos do gateway (server-simple.js / protocol-codec.js),
+// frames malformados e todos os prefixos truncados de cada frame, e mede a
+// vazão do tokenizador sobre a mesma amostra.
+
+#include <unity.h>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "Json/json_tokenizer.h"
+
+namespace
+{
+    // ===== FRAMES CAPTURADOS =====
+    // Frame de texto + uma chave de roteamento e o valor esperado
+    struct Frame
+    {
+        const char *text;
+        const char *key;
+        const char *value;
+    };
+
+    const Frame FRAMES[] = {
+        {"{\"type\":\"hello\",\"carId\":\"CAR-1759327346444-n2ug1qp3a\",\"timeout\":30000,\"timestamp\":1759327400123}",
+         "type", "hello"},
+        {"{\"type\":\"caps_select\",\"proto\":1,\"enc\":\"json\",\"hbDelta\":true,\"keyframeEvery\":10,\"compress\":\"lzss\"}",
+         "enc", "json"},
+        {"{\"type\":\"heartbeat_mode\",\"mode\":\"delta\",\"keyframeEvery\":10}", "mode", "delta"},
+        {"{\"type\":\"encoding\",\"value\":\"msgpack\"}", "value", "msgpack"},
+        {"{\"type\":\"heartbeat_keyframe\"}", "type", "heartbeat_keyframe"},
+        {"{\"type\":\"journal_ack\",\"seq\":17}", "type", "journal_ack"},
+        {"{\"action\":\"start\",\"id\":17,\"ts\":1759327401,\"ttl\":5000}", "action", "start"},
+        {"{\"action\":\"hc595_byte_255\",\"id\":18,\"ts\":1759327402,\"ttl\":5000}", "action", "hc595_byte_255"},
+        {"{\"actions\":[\"hc595_byte_255\",\"start\"],\"id\":19,\"ts\":1759327403,\"ttl\":5000}", "id", nullptr},
+        {"{\"type\":\"session_data\",\"data\":{\"remainingTime\":{\"total_seconds\":60}}}", "type", "session_data"},
+        {"{\"type\":\"session_data\",\"carId\":\"CAR-1759327346444-n2ug1qp3a\",\"data\":{\"status\":\"ACTIVE\","
+         "\"duration\":600,\"initialMinutes\":10,\"remainingTime\":{\"minutes\":5,\"total_seconds\":300}}}",
+         "status", "ACTIVE"},
+        {"{\"type\":\"session_data\",\"history\":[{\"at\":1759327340000,\"event\":\"tick\"},{\"at\":1759327280000,"
+         "\"event\":\"tick\"},{\"at\":1759327220000,\"event\":\"tick\"}],\"data\":{\"remainingTime\":{\"total_seconds\":120}}}",
+         "event", "tick"},
+        {"{ \"type\" : \"status\", \"status\" : \"running\", \"note\" : \"a \\\"b\\\" c\\\\\", \"n\" : [ -3e2, 1.5, null, false ] }",
+         "note", "a \\\"b\\\" c\\\\"},
+    };
+
+    // {"action":"start","id":17,"ts":1759327401,"ttl":5000} em MessagePack (msgpack-codec.js)
+    const uint8_t MSGPACK_ACTION[] = {
+        0x84, 0xa6, 0x61, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0xa5, 0x73, 0x74, 0x61, 0x72, 0x74, 0xa2, 0x69, 0x64,
+        0x11, 0xa2, 0x74, 0x73, 0xce, 0x68, 0xdd, 0x34, 0xa9, 0xa3, 0x74, 0x74, 0x6c, 0xcd, 0x13, 0x88};
+
+    const char *const MALFORMED[] = {
+        "{bad}",
+        "{\"a\":1]",
+        "[1,2}",
+        "{\"a\":[1,2}",
+        "}",
+        "{\"a\":tru}",
+        "{\"a\":nul,\"b\":1}",
+        "{\"a\":@}",
+        "[[[[[[[[[[[[[[[[[1]]]]]]]]]]]]]]]]]", // profundidade acima de MAX_DEPTH
+    };
+
+    // ===== AUXILIARES =====
+    const uint8_t *bytes(const char *text)
+    {
+        return reinterpret_cast<const uint8_t *>(text);
+    }
+
+    // Percorre o buffer inteiro; devolve o último token (TOK_END ou TOK_ERROR)
+    Json::TokenType drain(Json::Tokenizer &tok, size_t &count)
+    {
+        Json::Token t;
+        count = 0;
+        while (tok.next(t))
+        {
+            count++;
+        }
+        return t.type;
+    }
+
+    // Valor (string ou número bruto) da primeira chave igual a 'key'
+    bool findValue(const char *frame, const char *key, Json::Slice &value)
+    {
+        Json::Tokenizer tok(bytes(frame), strlen(frame));
+        Json::Token t;
+        while (tok.next(t))
+        {
+            if (t.type == Json::TOK_KEY && t.text.equals(key))
+            {
+                if (!tok.next(t))
+                {
+                    return false;
+                }
+                value = t.text;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+// ===== REPLAY =====
+
+void test_replay_captured_frames()
+{
+    for (const Frame &frame : FRAMES)
+    {
+        Json::Tokenizer tok(bytes(frame.text), strlen(frame.text));
+        size_t count = 0;
+        TEST_ASSERT_EQUAL_MESSAGE(Json::TOK_END, drain(tok, count), frame.text);
+        TEST_ASSERT_EQUAL_MESSAGE(0, tok.depth(), frame.text);
+        TEST_ASSERT_TRUE_MESSAGE(count > 0, frame.text);
+
+        Json::Slice value;
+        TEST_ASSERT_TRUE_MESSAGE(findValue(frame.text, frame.key, value), frame.text);
+        if (frame.value)
+        {
+            TEST_ASSERT_TRUE_MESSAGE(value.equals(frame.value), frame.text);
+        }
+    }
+}
+
+void test_slices_point_into_payload()
+{
+    const char *frame = FRAMES[6].text;
+    Json::Tokenizer tok(bytes(frame), strlen(frame));
+    Json::Token t;
+    while (tok.next(t))
+    {
+        if (t.type == Json::TOK_KEY || t.type == Json::TOK_STRING || t.type == Json::TOK_NUMBER)
+        {
+            TEST_ASSERT_TRUE(t.text.ptr >= frame && t.text.ptr + t.text.len <= frame + strlen(frame));
+        }
+    }
+}
+
+void test_numbers_and_depth()
+{
+    const char *frame = "{\"a\":{\"b\":[-3e2,1.5,42]}}";
+    Json::Tokenizer tok(bytes(frame), strlen(frame));
+    Json::Token t;
+    long numbers[3] = {};
+    uint8_t depths[3] = {};
+    size_t n = 0;
+    while (tok.next(t))
+    {
+        if (t.type == Json::TOK_NUMBER && n < 3)
+        {
+            depths[n] = t.depth;
+            numbers[n++] = t.number;
+        }
+    }
+    TEST_ASSERT_EQUAL(3, n);
+    TEST_ASSERT_EQUAL(-3, numbers[0]); // só a parte inteira
+    TEST_ASSERT_EQUAL(1, numbers[1]);
+    TEST_ASSERT_EQUAL(42, numbers[2]);
+    TEST_ASSERT_EQUAL(3, depths[2]);
+}
+
+void test_skip_nested_value()
+{
+    const char *frame = FRAMES[11].text;
+    Json::Tokenizer tok(bytes(frame), strlen(frame));
+    Json::Token t;
+    bool skipped = false;
+    while (tok.next(t))
+    {
+        if (t.type == Json::TOK_ARRAY_START)
+        {
+            TEST_ASSERT_TRUE(tok.skip(t));
+            skipped = true;
+        }
+        // Depois do skip, o próximo token é a chave "data" da raiz
+        if (skipped && t.type == Json::TOK_KEY)
+        {
+            TEST_ASSERT_TRUE(t.text.equals("data"));
+            TEST_ASSERT_EQUAL(1, t.depth);
+            return;
+        }
+    }
+    TEST_FAIL_MESSAGE("chave data não encontrada depois do skip");
+}
+
+void test_replay_msgpack_frame()
+{
+    Json::Tokenizer tok(MSGPACK_ACTION, sizeof(MSGPACK_ACTION), Json::FORMAT_MSGPACK);
+    Json::Token t;
+    bool action = false;
+    long ts = 0;
+    while (tok.next(t))
+    {
+        if (t.type == Json::TOK_KEY && t.text.equals("action"))
+        {
+            TEST_ASSERT_TRUE(tok.next(t));
+            action = t.type == Json::TOK_STRING && t.text.equals("start");
+        }
+        else if (t.type == Json::TOK_KEY && t.text.equals("ts"))
+        {
+            TEST_ASSERT_TRUE(tok.next(t));
+            ts = t.number;
+        }
+    }
+    TEST_ASSERT_EQUAL(Json::TOK_END, t.type);
+    TEST_ASSERT_TRUE(action);
+    TEST_ASSERT_EQUAL(1759327401L, ts);
+}
+
+// ===== INTEIROS MESSAGEPACK =====
+
+namespace
+{
+    // Valor esperado em Token::number: satura na faixa de long da plataforma
+    long clamped(long long value)
+    {
+        return value > LONG_MAX ? LONG_MAX : value < LONG_MIN ? LONG_MIN : (long)value;
+    }
+
+    long clampedUnsigned(unsigned long long value)
+    {
+        return value > (unsigned long long)LONG_MAX ? LONG_MAX : (long)value;
+    }
+
+    // Decodifica um único número MessagePack: tag + 'width' bytes big-endian
+    long decodeMsgPackNumber(uint8_t tag, uint64_t raw, uint8_t width)
+    {
+        uint8_t frame[9] = {tag};
+        for (uint8_t i = 0; i < width; i++)
+        {
+            frame[1 + i] = (uint8_t)(raw >> (8 * (width - 1 - i)));
+        }
+        Json::Tokenizer tok(frame, 1 + width, Json::FORMAT_MSGPACK);
+        Json::Token t;
+        TEST_ASSERT_TRUE(tok.next(t));
+        TEST_ASSERT_EQUAL(Json::TOK_NUMBER, t.type);
+        return t.number;
+    }
+}
+
+void test_msgpack_int64()
+{
+    const long long values[] = {-1, -5, 0, (long long)INT32_MIN - 1, (long long)INT32_MAX + 1, 1LL << 32,
+                                LLONG_MIN, LLONG_MAX};
+    for (long long value : values)
+    {
+        TEST_ASSERT_EQUAL(clamped(value), decodeMsgPackNumber(0xD3, (uint64_t)value, 8));
+    }
+}
+
+void test_msgpack_uint32_uint64()
+{
+    const unsigned long long values32[] = {0, 1u << 31, UINT32_MAX};
+    for (unsigned long long value : values32)
+    {
+        TEST_ASSERT_EQUAL(clampedUnsigned(value), decodeMsgPackNumber(0xCE, value, 4));
+    }
+
+    const unsigned long long values64[] = {5, 1ULL << 31, 1ULL << 32, ULLONG_MAX};
+    for (unsigned long long value : values64)
+    {
+        TEST_ASSERT_EQUAL(clampedUnsigned(value), decodeMsgPackNumber(0xCF, value, 8));
+    }
+}
+
+void test_msgpack_float_saturates()
+{
+    double big = 1e30;
+    uint64_t bits;
+    memcpy(&bits, &big, sizeof(bits));
+    TEST_ASSERT_EQUAL(LONG_MAX, decodeMsgPackNumber(0xCB, bits, 8));
+
+    double small = -2.5;
+    memcpy(&bits, &small, sizeof(bits));
+    TEST_ASSERT_EQUAL(-2, decodeMsgPackNumber(0xCB, bits, 8));
+}
+
+// ===== MALFORMADOS E TRUNCADOS =====
+
+void test_malformed_frames_fail()
+{
+    for (const char *frame : MALFORMED)
+    {
+        Json::Tokenizer tok(bytes(frame), strlen(frame));
+        size_t count = 0;
+        TEST_ASSERT_EQUAL_MESSAGE(Json::TOK_ERROR, drain(tok, count), frame);
+
+        // Depois do erro o tokenizador continua em erro
+        Json::Token t;
+        TEST_ASSERT_FALSE(tok.next(t));
+        TEST_ASSERT_EQUAL(Json::TOK_ERROR, t.type);
+    }
+}
+
+// Todo prefixo de um frame termina em erro ou com containers abertos, nunca
+// como documento completo; cada prefixo fica em um buffer do tamanho exato
+// para que um acesso além do fim apareça com -fsanitize=address
+void test_truncated_frames_never_complete()
+{
+    for (const Frame &frame : FRAMES)
+    {
+        size_t length = strlen(frame.text);
+        for (size_t cut = 1; cut < length; cut++)
+        {
+            std::vector<uint8_t> prefix(bytes(frame.text), bytes(frame.text) + cut);
+            Json::Tokenizer tok(prefix.data(), prefix.size());
+            size_t count = 0;
+            Json::TokenType last = drain(tok, count);
+            TEST_ASSERT_TRUE_MESSAGE(last == Json::TOK_ERROR || (last == Json::TOK_END && tok.depth() > 0), frame.text);
+            TEST_ASSERT_TRUE(tok.offset() <= cut);
+        }
+    }
+}
+
+void test_truncated_msgpack_never_completes()
+{
+    for (size_t cut = 1; cut < sizeof(MSGPACK_ACTION); cut++)
+    {
+        std::vector<uint8_t> prefix(MSGPACK_ACTION, MSGPACK_ACTION + cut);
+        Json::Tokenizer tok(prefix.data(), prefix.size(), Json::FORMAT_MSGPACK);
+        size_t count = 0;
+        Json::TokenType last = drain(tok, count);
+        TEST_ASSERT_TRUE(last == Json::TOK_ERROR || (last == Json::TOK_END && tok.depth() > 0));
+    }
+}
+
+// ===== BENCHMARK =====
+
+void test_replay_throughput()
+{
+    const int ROUNDS = 20000;
+    size_t bytesPerRound = 0;
+    for (const Frame &frame : FRAMES)
+    {
+        bytesPerRound += strlen(frame.text);
+    }
+
+    size_t tokens = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        for (const Frame &frame : FRAMES)
+        {
+            Json::Tokenizer tok(bytes(frame.text), strlen(frame.text));
+            size_t count = 0;
+            drain(tok, count);
+            tokens += count;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    size_t frames = (size_t)ROUNDS * (sizeof(FRAMES) / sizeof(FRAMES[0]));
+    char report[160];
+    snprintf(report, sizeof(report), "%zu frames, %zu tokens em %.3f s: %.1f MB/s, %.0f frames/s, %.0f ns/frame",
+             frames, tokens, seconds, (double)bytesPerRound * ROUNDS / seconds / 1e6, frames / seconds, seconds * 1e9 / frames);
+    TEST_MESSAGE(report);
+    TEST_ASSERT_TRUE(tokens > frames);
+}
+
+int main(int, char **)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_replay_captured_frames);
+    RUN_TEST(test_slices_point_into_payload);
+    RUN_TEST(test_numbers_and_depth);
+    RUN_TEST(test_skip_nested_value);
+    RUN_TEST(test_replay_msgpack_frame);
+    RUN_TEST(test_msgpack_int64);
+    RUN_TEST(test_msgpack_uint32_uint64);
+    RUN_TEST(test_msgpack_float_saturates);
+    RUN_TEST(test_malformed_frames_fail);
+    RUN_TEST(test_truncated_frames_never_complete);
+    RUN_TEST(test_truncated_msgpack_never_completes);
+    RUN_TEST(test_replay_throughput);
+    return UNITY_END();
+}
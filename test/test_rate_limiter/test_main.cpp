@@ -0,0 +1,108 @@
+// Testes do RateLimiter no host (pio test -e native)
+//
+// Reproduz rajadas de frames contra os baldes com os limites de config.h;
+// o tempo é passado explicitamente, como no loop da placa.
+
+#include <unity.h>
+#include "Config/config.h"
+#include "WebSocket/rate_limiter.h"
+
+namespace
+{
+    unsigned long g_now = 1000;
+
+    // Entrega 'frames' frames espaçados de 'spacingMs'; devolve quantos passaram
+    int replay(RateLimiter::Category category, int frames, unsigned long spacingMs, uint8_t cost = 1)
+    {
+        int accepted = 0;
+        for (int i = 0; i < frames; i++)
+        {
+            g_now += spacingMs;
+            accepted += RateLimiter::allow(category, cost, g_now) ? 1 : 0;
+        }
+        return accepted;
+    }
+}
+
+void setUp()
+{
+    // Intervalo longo entre testes: todos os baldes cheios de novo
+    g_now += 600000;
+    RateLimiter::reset(g_now);
+}
+
+void tearDown() {}
+
+void test_burst_lets_only_burst_size_through()
+{
+    uint32_t before = RateLimiter::rejected(RateLimiter::CAT_OPERATION);
+    TEST_ASSERT_EQUAL(RL_OPERATION_BURST, replay(RateLimiter::CAT_OPERATION, 100, 0));
+    TEST_ASSERT_EQUAL(100 - RL_OPERATION_BURST, RateLimiter::rejected(RateLimiter::CAT_OPERATION) - before);
+}
+
+void test_sustained_flood_gets_refill_rate()
+{
+    // Esvazia o balde e depois 100 frames ao longo de 1 s
+    replay(RateLimiter::CAT_OPERATION, RL_OPERATION_BURST, 0);
+    TEST_ASSERT_EQUAL(RL_OPERATION_PER_S, replay(RateLimiter::CAT_OPERATION, 100, 10));
+}
+
+void test_categories_are_independent()
+{
+    replay(RateLimiter::CAT_HC595, 1000, 0);
+    TEST_ASSERT_FALSE(RateLimiter::allow(RateLimiter::CAT_HC595, 1, g_now));
+    TEST_ASSERT_TRUE(RateLimiter::allow(RateLimiter::CAT_OPERATION, 1, g_now));
+    TEST_ASSERT_TRUE(RateLimiter::allow(RateLimiter::CAT_MESSAGE, 1, g_now));
+}
+
+void test_batch_costs_one_token_per_action()
+{
+    TEST_ASSERT_TRUE(RateLimiter::allow(RateLimiter::CAT_OPERATION, RL_OPERATION_BURST, g_now));
+    TEST_ASSERT_FALSE(RateLimiter::allow(RateLimiter::CAT_OPERATION, 1, g_now));
+
+    // Lote maior que o balde nunca passa, mesmo cheio
+    g_now += 600000;
+    TEST_ASSERT_FALSE(RateLimiter::allow(RateLimiter::CAT_OPERATION, RL_OPERATION_BURST + 1, g_now));
+}
+
+void test_bucket_refills_after_idle()
+{
+    replay(RateLimiter::CAT_MESSAGE, RL_MESSAGE_BURST, 0);
+    TEST_ASSERT_FALSE(RateLimiter::allow(RateLimiter::CAT_MESSAGE, 1, g_now));
+
+    // Tempo para encher o balde inteiro, e não mais que a capacidade
+    g_now += (1000UL * RL_MESSAGE_BURST) / RL_MESSAGE_PER_S;
+    TEST_ASSERT_EQUAL(RL_MESSAGE_BURST, replay(RateLimiter::CAT_MESSAGE, RL_MESSAGE_BURST + 5, 0));
+}
+
+void test_total_rejected_sums_categories()
+{
+    uint32_t before = RateLimiter::totalRejected();
+    replay(RateLimiter::CAT_OPERATION, RL_OPERATION_BURST + 3, 0);
+    replay(RateLimiter::CAT_HC595, RL_HC595_BURST + 4, 0);
+    TEST_ASSERT_EQUAL(7, RateLimiter::totalRejected() - before);
+}
+
+void test_millis_wraparound()
+{
+    g_now = (unsigned long)-50;
+    RateLimiter::reset(g_now);
+    replay(RateLimiter::CAT_OPERATION, RL_OPERATION_BURST, 0);
+
+    // 1 s depois do estouro de millis() o balde reabastece normalmente
+    g_now += 1000;
+    TEST_ASSERT_EQUAL(RL_OPERATION_PER_S, replay(RateLimiter::CAT_OPERATION, RL_OPERATION_BURST, 0));
+}
+
+int main(int, char **)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_burst_lets_only_burst_size_through);
+    RUN_TEST(test_sustained_flood_gets_refill_rate);
+    RUN_TEST(test_categories_are_independent);
+    RUN_TEST(test_batch_costs_one_token_per_action);
+    RUN_TEST(test_bucket_refills_after_idle);
+    RUN_TEST(test_total_rejected_sums_categories);
+    RUN_TEST(test_millis_wraparound);
+    return UNITY_END();
+}
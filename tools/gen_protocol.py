@@ -0,0 +1,704 @@
+#!/usr/bin/env python3
+"""
+Gerador dos codecs do protocolo a partir de protocol/messages.json
+
+Emite, para as mensagens planas do esquema:
+  src/Protocol/messages.h / messages.cpp - structs + encode/decode sem alocação
+                                           (Json::Writer, MsgPack::Writer,
+                                           Json::Tokenizer) e benchmark de ida e volta
+  protocol-codec.js                      - mesmo esquema para os gateways Node
+                                           (make/check/decode + benchmark)
+
+Roda sozinho (python3 tools/gen_protocol.py) ou como script "pre" do
+PlatformIO (extra_scripts em platformio.ini), antes de cada build. Só
+reescreve arquivos cujo conteúdo mudou, para não invalidar o cache do build.
+"""
+
+import json
+import os
+import re
+import sys
+
+try:
+    Import("env")  # noqa: F821 - injetado pelo SCons/PlatformIO
+    ROOT = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SCHEMA = os.path.join("protocol", "messages.json")
+OUT_H = os.path.join("src", "Protocol", "messages.h")
+OUT_CPP = os.path.join("src", "Protocol", "messages.cpp")
+OUT_JS = "protocol-codec.js"
+
+BANNER = "Gerado por tools/gen_protocol.py a partir de protocol/messages.json - não editar."
+
+TYPES = ("str", "int", "uint", "bool")
+CPP_TYPE = {"str": "Json::Slice", "int": "long", "uint": "uint32_t", "bool": "bool"}
+CPP_DEFAULT = {"str": "", "int": " = 0", "uint": " = 0", "bool": " = false"}
+# Maior valor serializado em JSON (strings: sem escapes, + aspas de fechamento)
+JSON_VALUE_MAX = {"int": 11, "uint": 10, "bool": 5}
+
+
+# ===== ESQUEMA =====
+
+def snake_upper(name):
+    return re.sub(r"([a-z0-9])([A-Z])", r"\1_\2", name).upper()
+
+
+def camel(name):
+    return "".join(part.capitalize() for part in name.split("_"))
+
+
+def flag_name(field):
+    return "has" + field["name"][0].upper() + field["name"][1:]
+
+
+def load_schema(root):
+    with open(os.path.join(root, SCHEMA), encoding="utf-8") as f:
+        schema = json.load(f)
+
+    messages = []
+    by_name = {}
+    for name, spec in schema["messages"].items():
+        fields = spec["fields"]
+        shares = None
+        if isinstance(fields, str):
+            # Mesmo layout de outra mensagem (ex.: nack = ack)
+            shares = fields
+            fields = by_name[shares]["fields"]
+        for field in fields:
+            if field["type"] not in TYPES:
+                sys.exit("%s.%s: tipo desconhecido %r" % (name, field["name"], field["type"]))
+            if field["type"] == "str" and "max" not in field:
+                sys.exit("%s.%s: string sem 'max'" % (name, field["name"]))
+        if spec["direction"] not in ("car", "gateway"):
+            sys.exit("%s: direction deve ser car ou gateway" % name)
+
+        message = {
+            "name": name,
+            "camel": camel(name),
+            "struct": camel(shares or name) + "Msg",
+            "shares": shares,
+            "direction": spec["direction"],
+            "description": spec.get("description", ""),
+            "fields": fields,
+        }
+        messages.append(message)
+        by_name[name] = message
+    return schema["version"], messages
+
+
+def example(field):
+    if "example" in field:
+        return field["example"]
+    return {"str": "x", "int": -42, "uint": 42, "bool": True}[field["type"]]
+
+
+# ===== C++ =====
+
+def json_fragment(field):
+    macro = "JSON_KEY_STR" if field["type"] == "str" else "JSON_KEY"
+    return "J_%s%s" % (snake_upper(field["name"]), "_STR" if field["type"] == "str" else ""), \
+        '%s("%s")' % (macro, field["name"])
+
+
+def cpp_literal(value):
+    if isinstance(value, bool):
+        return "true" if value else "false"
+    if isinstance(value, str):
+        return 'text("%s")' % value.replace("\\", "\\\\").replace('"', '\\"')
+    return str(value)
+
+
+def gen_header(version, messages):
+    out = []
+    w = out.append
+    w("#pragma once")
+    w("")
+    w("// " + BANNER)
+    w("")
+    w("#include <Arduino.h>")
+    w('#include "../Json/json_tokenizer.h"')
+    w('#include "../Json/json_writer.h"')
+    w('#include "../Json/msgpack_writer.h"')
+    w("")
+    w("/**")
+    w(" * Mensagens planas do protocolo WebSocket")
+    w(" *")
+    w(" * Para cada mensagem do esquema há uma struct e três funções sem alocação:")
+    w(" *   encodeX(msg, Json::Writer&) / encodeX(msg, MsgPack::Writer&) - frame")
+    w(" *     completo (com \"type\" e, nas mensagens da placa, \"carId\")")
+    w(" *   decodeX(payload, length, format, msg) - false se malformado, se faltar")
+    w(" *     campo obrigatório, se um tipo não bater ou se uma string passar do limite")
+    w(" * Strings são Json::Slice: no encode apontam para o texto do chamador")
+    w(" * (text()), no decode para dentro do payload (escapes preservados). Chaves")
+    w(" * desconhecidas são ignoradas no decode. Mensagens aninhadas (hello,")
+    w(" * heartbeat, telemetry, journal, session_data) continuam escritas à mão.")
+    w(" * O gateway usa protocol-codec.js, gerado do mesmo esquema.")
+    w(" */")
+    w("")
+    w("namespace Protocol")
+    w("{")
+    w("    const uint8_t SCHEMA_VERSION = %d;" % version)
+    w("")
+    w("    // Fatia sobre uma string C (campos string dos encoders)")
+    w("    inline Json::Slice text(const char *value)")
+    w("    {")
+    w("        Json::Slice slice;")
+    w("        slice.ptr = value;")
+    w("        slice.len = value ? strlen(value) : 0;")
+    w("        return slice;")
+    w("    }")
+
+    for m in messages:
+        arrow = "placa -> gateway" if m["direction"] == "car" else "gateway -> placa"
+        w("")
+        w("    // ===== %s (%s): %s =====" % (m["name"], arrow, m["description"]))
+        if m["shares"]:
+            w("    using %sMsg = %s;" % (m["camel"], m["struct"]))
+        else:
+            w("    struct %s" % m["struct"])
+            w("    {")
+            for field in m["fields"]:
+                if field["type"] == "str":
+                    w("        static const size_t %s_MAX = %d;" % (snake_upper(field["name"]), field["max"]))
+            for field in m["fields"]:
+                w("        %s %s%s;" % (CPP_TYPE[field["type"]], field["name"], CPP_DEFAULT[field["type"]]))
+                if field.get("optional"):
+                    w("        bool %s = false;" % flag_name(field))
+            w("    };")
+        w("    bool encode%s(const %s &msg, Json::Writer &json);" % (m["camel"], m["struct"]))
+        w("    bool encode%s(const %s &msg, MsgPack::Writer &out);" % (m["camel"], m["struct"]))
+        w("    bool decode%s(const uint8_t *payload, size_t length, Json::Format format, %s &msg);"
+          % (m["camel"], m["struct"]))
+
+    w("")
+    w("    // Ida e volta de todos os codecs (JSON e MessagePack) com os exemplos do esquema")
+    w("    void benchmarkRoundTrip(uint32_t iterations);")
+    w("}")
+    return "\n".join(out) + "\n"
+
+
+def gen_source(messages):
+    out = []
+    w = out.append
+    w("// " + BANNER)
+    w("")
+    w('#include "messages.h"')
+    w('#include "../Config/config.h"')
+    w("")
+    w("namespace")
+    w("{")
+    w("    // Fragmentos JSON constantes (flash)")
+    for m in messages:
+        if m["direction"] == "car":
+            head = '"{\\"type\\":\\"%s\\",\\"carId\\":\\"" CAR_ID_STR "\\""' % m["name"]
+        else:
+            head = '"{\\"type\\":\\"%s\\""' % m["name"]
+        w("    const char H_%s[] PROGMEM = %s;" % (snake_upper(m["camel"]), head))
+    fragments = {}
+    for m in messages:
+        for field in m["fields"]:
+            name, value = json_fragment(field)
+            fragments.setdefault(name, value)
+    for name, value in fragments.items():
+        w("    const char %s[] PROGMEM = %s;" % (name, value))
+
+    w("")
+    w("    // Chaves e valores MessagePack (mesmos nomes do JSON)")
+    keys = {"type": "K_TYPE", "carId": "K_CAR_ID"}
+    for m in messages:
+        for field in m["fields"]:
+            keys.setdefault(field["name"], "K_" + snake_upper(field["name"]))
+    for text, name in keys.items():
+        w('    const char %s[] PROGMEM = "%s";' % (name, text))
+    for m in messages:
+        w('    const char V_%s[] PROGMEM = "%s";' % (snake_upper(m["camel"]), m["name"]))
+    w("    const char V_CAR_ID[] PROGMEM = CAR_ID_STR;")
+
+    w("")
+    w("    // Pior caso de cada frame da placa (strings sem escapes) cabe no buffer de saída")
+    for m in messages:
+        if m["direction"] != "car" or m["shares"]:
+            continue
+        terms = ["Json::literalLength(H_%s)" % snake_upper(m["camel"])]
+        values = 1  # '}'
+        for field in m["fields"]:
+            terms.append("Json::literalLength(%s)" % json_fragment(field)[0])
+            values += field["max"] + 1 if field["type"] == "str" else JSON_VALUE_MAX[field["type"]]
+        w("    static_assert(%s + %d < WS_TX_BUFFER_SIZE," % (" +\n                      ".join(terms), values))
+        w('                  "WS_TX_BUFFER_SIZE pequeno para o frame %s");' % m["name"])
+
+    w("")
+    w("    bool readString(const Json::Token &value, size_t max, Json::Slice &out)")
+    w("    {")
+    w("        if (value.type != Json::TOK_STRING || value.text.len > max)")
+    w("        {")
+    w("            return false;")
+    w("        }")
+    w("        out = value.text;")
+    w("        return true;")
+    w("    }")
+    w("")
+    w("    bool readInt(const Json::Token &value, long &out)")
+    w("    {")
+    w("        if (value.type != Json::TOK_NUMBER)")
+    w("        {")
+    w("            return false;")
+    w("        }")
+    w("        out = value.number;")
+    w("        return true;")
+    w("    }")
+    w("")
+    w("    bool readUint(const Json::Token &value, uint32_t &out)")
+    w("    {")
+    w("        if (value.type != Json::TOK_NUMBER || value.number < 0)")
+    w("        {")
+    w("            return false;")
+    w("        }")
+    w("        out = (uint32_t)value.number;")
+    w("        return true;")
+    w("    }")
+    w("")
+    w("    bool readBool(const Json::Token &value, bool &out)")
+    w("    {")
+    w("        if (value.type != Json::TOK_TRUE && value.type != Json::TOK_FALSE)")
+    w("        {")
+    w("            return false;")
+    w("        }")
+    w("        out = (value.type == Json::TOK_TRUE);")
+    w("        return true;")
+    w("    }")
+    w("")
+    w("    bool sameText(const Json::Slice &a, const Json::Slice &b)")
+    w("    {")
+    w("        return a.len == b.len && memcmp(a.ptr, b.ptr, a.len) == 0;")
+    w("    }")
+
+    for m in messages:
+        if m["shares"]:
+            continue
+        w("")
+        w("    bool same(const Protocol::%s &a, const Protocol::%s &b)" % (m["struct"], m["struct"]))
+        w("    {")
+        terms = []
+        for field in m["fields"]:
+            n = field["name"]
+            value = "sameText(a.%s, b.%s)" % (n, n) if field["type"] == "str" else "a.%s == b.%s" % (n, n)
+            if field.get("optional"):
+                flag = flag_name(field)
+                value = "a.%s == b.%s && (!a.%s || %s)" % (flag, flag, flag, value)
+            terms.append(value)
+        if not terms:
+            w("        (void)a;")
+            w("        (void)b;")
+        w("        return %s;" % ("\n               && ".join(terms) if terms else "true"))
+        w("    }")
+
+    w("")
+    w("    template <typename Msg>")
+    w("    void benchmarkMessage(const char *name, const Msg &sample, uint32_t iterations,")
+    w("                          bool (*encodeJson)(const Msg &, Json::Writer &),")
+    w("                          bool (*encodeMsgPack)(const Msg &, MsgPack::Writer &),")
+    w("                          bool (*decode)(const uint8_t *, size_t, Json::Format, Msg &))")
+    w("    {")
+    w("        // Na pilha: static seria um buffer permanente por instanciação do template")
+    w("        uint8_t buffer[WS_TX_BUFFER_SIZE];")
+    w("")
+    w("        for (uint8_t f = 0; f < 2; f++)")
+    w("        {")
+    w("            const Json::Format format = f ? Json::FORMAT_MSGPACK : Json::FORMAT_JSON;")
+    w("            size_t length = 0;")
+    w("            bool ok = true;")
+    w("")
+    w("            uint32_t started = ESP.getCycleCount();")
+    w("            for (uint32_t n = 0; n < iterations; n++)")
+    w("            {")
+    w("                if (format == Json::FORMAT_MSGPACK)")
+    w("                {")
+    w("                    MsgPack::Writer out(buffer, sizeof(buffer));")
+    w("                    ok = encodeMsgPack(sample, out) && ok;")
+    w("                    length = out.length();")
+    w("                }")
+    w("                else")
+    w("                {")
+    w("                    Json::Writer json(reinterpret_cast<char *>(buffer), sizeof(buffer));")
+    w("                    ok = encodeJson(sample, json) && ok;")
+    w("                    length = json.length();")
+    w("                }")
+    w("            }")
+    w("            uint32_t encodeCycles = ESP.getCycleCount() - started;")
+    w("")
+    w("            Msg decoded;")
+    w("            started = ESP.getCycleCount();")
+    w("            for (uint32_t n = 0; n < iterations; n++)")
+    w("            {")
+    w("                ok = decode(buffer, length, format, decoded) && ok;")
+    w("            }")
+    w("            uint32_t decodeCycles = ESP.getCycleCount() - started;")
+    w("            ok = ok && same(sample, decoded);")
+    w("")
+    w('            Serial.printf("[BENCH] %-18s %-7s %3u B  enc %5lu  dec %5lu ciclos  %s\\n", name,')
+    w('                          format == Json::FORMAT_MSGPACK ? "msgpack" : "json", (unsigned)length,')
+    w("                          (unsigned long)(encodeCycles / iterations), (unsigned long)(decodeCycles / iterations),")
+    w('                          ok ? "ok" : "DIVERGIU");')
+    w("        }")
+    w("    }")
+    w("}")
+
+    w("")
+    w("namespace Protocol")
+    w("{")
+    first = True
+    for m in messages:
+        if not first:
+            w("")
+        first = False
+        upper = snake_upper(m["camel"])
+        fields = m["fields"]
+        required = sum(1 for f in fields if not f.get("optional"))
+        base = required + (2 if m["direction"] == "car" else 1)
+
+        w("    // ===== %s =====" % m["name"])
+        w("    bool encode%s(const %s &msg, Json::Writer &json)" % (m["camel"], m["struct"]))
+        w("    {")
+        if not fields:
+            w("        (void)msg;")
+        w("        json.raw(H_%s);" % upper)
+        for field in fields:
+            frag = json_fragment(field)[0]
+            n = field["name"]
+            if field["type"] == "str":
+                line = "json.raw(%s).str(msg.%s.ptr, msg.%s.len).put('\"');" % (frag, n, n)
+            elif field["type"] == "bool":
+                line = "json.raw(%s).boolean(msg.%s);" % (frag, n)
+            elif field["type"] == "uint":
+                line = "json.raw(%s).number((unsigned long)msg.%s);" % (frag, n)
+            else:
+                line = "json.raw(%s).number(msg.%s);" % (frag, n)
+            if field.get("optional"):
+                w("        if (msg.%s)" % flag_name(field))
+                w("        {")
+                w("            " + line)
+                w("        }")
+            else:
+                w("        " + line)
+        w("        json.put('}');")
+        w("        return !json.overflowed();")
+        w("    }")
+        w("")
+
+        w("    bool encode%s(const %s &msg, MsgPack::Writer &out)" % (m["camel"], m["struct"]))
+        w("    {")
+        optional = [f for f in fields if f.get("optional")]
+        if optional:
+            w("        out.map(%d%s);" % (base, "".join(" + (msg.%s ? 1 : 0)" % flag_name(f) for f in optional)))
+        else:
+            if not fields:
+                w("        (void)msg;")
+            w("        out.map(%d);" % base)
+        w("        out.key(K_TYPE).key(V_%s);" % upper)
+        if m["direction"] == "car":
+            w("        out.key(K_CAR_ID).key(V_CAR_ID);")
+        for field in fields:
+            n = field["name"]
+            key = keys[n]
+            if field["type"] == "str":
+                line = "out.key(%s).str(msg.%s.ptr, msg.%s.len);" % (key, n, n)
+            elif field["type"] == "bool":
+                line = "out.key(%s).boolean(msg.%s);" % (key, n)
+            elif field["type"] == "uint":
+                line = "out.key(%s).number((unsigned long)msg.%s);" % (key, n)
+            else:
+                line = "out.key(%s).number(msg.%s);" % (key, n)
+            if field.get("optional"):
+                w("        if (msg.%s)" % flag_name(field))
+                w("        {")
+                w("            " + line)
+                w("        }")
+            else:
+                w("        " + line)
+        w("        return !out.overflowed();")
+        w("    }")
+        w("")
+
+        w("    bool decode%s(const uint8_t *payload, size_t length, Json::Format format, %s &msg)"
+          % (m["camel"], m["struct"]))
+        w("    {")
+        w("        msg = %s();" % m["struct"])
+        for field in fields:
+            if not field.get("optional"):
+                w("        bool seen%s = false;" % flag_name(field)[3:])
+        w("")
+        w("        Json::Tokenizer tok(payload, length, format);")
+        w("        Json::Token key;")
+        w("        while (tok.next(key))")
+        w("        {")
+        w("            if (key.type != Json::TOK_KEY || key.depth != 1)")
+        w("            {")
+        w("                continue;")
+        w("            }")
+        w("")
+        w("            Json::Token value;")
+        w("            if (!tok.next(value))")
+        w("            {")
+        w("                return false;")
+        w("            }")
+        keyword = "if"
+        for field in fields:
+            n = field["name"]
+            t = field["type"]
+            if t == "str":
+                read = "readString(value, %s::%s_MAX, msg.%s)" % (m["struct"], snake_upper(n), n)
+            elif t == "int":
+                read = "readInt(value, msg.%s)" % n
+            elif t == "uint":
+                read = "readUint(value, msg.%s)" % n
+            else:
+                read = "readBool(value, msg.%s)" % n
+            w("            %s (key.text.equals(\"%s\"))" % (keyword, n))
+            w("            {")
+            w("                if (!%s)" % read)
+            w("                {")
+            w("                    return false;")
+            w("                }")
+            if field.get("optional"):
+                w("                msg.%s = true;" % flag_name(field))
+            else:
+                w("                seen%s = true;" % flag_name(field)[3:])
+            w("            }")
+            keyword = "else if"
+        if not fields:
+            w("            (void)msg;")
+        w("        }")
+        w("")
+        checks = ["key.type == Json::TOK_END"]
+        checks += ["seen%s" % flag_name(f)[3:] for f in fields if not f.get("optional")]
+        w("        return %s;" % " && ".join(checks))
+        w("    }")
+
+    w("")
+    w("    void benchmarkRoundTrip(uint32_t iterations)")
+    w("    {")
+    w("        if (iterations == 0)")
+    w("        {")
+    w("            return;")
+    w("        }")
+    w('        Serial.printf("[BENCH] Codecs do protocolo (esquema v%u, %lu iterações)\\n",')
+    w("                      (unsigned)SCHEMA_VERSION, (unsigned long)iterations);")
+    for m in messages:
+        var = m["camel"][0].lower() + m["camel"][1:]
+        w("")
+        w("        %s %s;" % (m["struct"], var))
+        for field in m["fields"]:
+            w("        %s.%s = %s;" % (var, field["name"], cpp_literal(example(field))))
+            if field.get("optional"):
+                w("        %s.%s = true;" % (var, flag_name(field)))
+        w('        benchmarkMessage<%s>("%s", %s, iterations, encode%s, encode%s, decode%s);'
+          % (m["struct"], m["name"], var, m["camel"], m["camel"], m["camel"]))
+    w("    }")
+    w("}")
+
+    return "\n".join(out) + "\n"
+
+
+# ===== JS =====
+
+def gen_js(version, messages):
+    table = {}
+    for m in messages:
+        table[m["name"]] = {
+            "direction": m["direction"],
+            "fields": [
+                {k: v for k, v in f.items() if k in ("name", "type", "max", "optional")} for f in m["fields"]
+            ],
+        }
+    examples = {m["name"]: {f["name"]: example(f) for f in m["fields"]} for m in messages}
+    builders = "\n".join(
+        "const %s = (fields%s) => make(\"%s\", fields%s);"
+        % (m["camel"][0].lower() + m["camel"][1:], ", carId" if m["direction"] == "car" else "", m["name"],
+           ", carId" if m["direction"] == "car" else "")
+        for m in messages
+    )
+    exports = ", ".join(m["camel"][0].lower() + m["camel"][1:] for m in messages)
+
+    return JS_TEMPLATE.replace("@BANNER@", BANNER) \
+        .replace("@VERSION@", str(version)) \
+        .replace("@MESSAGES@", js_table(table)) \
+        .replace("@EXAMPLES@", json.dumps(examples, indent=2, ensure_ascii=False)) \
+        .replace("@BUILDERS@", builders) \
+        .replace("@EXPORTS@", exports)
+
+
+def js_table(table):
+    # Um campo por linha: legível e com diffs curtos quando o esquema muda
+    lines = ["{"]
+    for name, spec in table.items():
+        lines.append('  "%s": {' % name)
+        lines.append('    "direction": "%s",' % spec["direction"])
+        if spec["fields"]:
+            lines.append('    "fields": [')
+            for i, field in enumerate(spec["fields"]):
+                comma = "," if i + 1 < len(spec["fields"]) else ""
+                lines.append("      %s%s" % (json.dumps(field, ensure_ascii=False), comma))
+            lines.append("    ]")
+        else:
+            lines.append('    "fields": []')
+        lines.append("  },")
+    lines[-1] = "  }"
+    lines.append("}")
+    return "\n".join(lines)
+
+
+JS_TEMPLATE = r"""#!/usr/bin/env node
+// @BANNER@
+/**
+ * Codec das mensagens planas do protocolo, espelho de src/Protocol/messages.*
+ *
+ *   make(type, fields)  -> objeto pronto para JSON/MessagePack (lança se inválido)
+ *   check(msg)          -> lista de problemas ([] = válido; null = tipo fora do esquema)
+ *   decode(msg)         -> msg validada (lança se inválida)
+ *
+ * Mensagens da placa levam "carId"; as do gateway não. Campos fora do
+ * esquema são erro aqui (o firmware os ignora): o gateway nunca deve
+ * enviar algo que a placa não conheça.
+ *
+ *   node protocol-codec.js bench [iterações]
+ */
+
+const SCHEMA_VERSION = @VERSION@;
+
+const MESSAGES = @MESSAGES@;
+
+const EXAMPLES = @EXAMPLES@;
+
+function checkValue(field, value) {
+  switch (field.type) {
+    case "str":
+      if (typeof value !== "string") return "deveria ser string";
+      if (Buffer.byteLength(value) > field.max) return `passa de ${field.max} bytes`;
+      return null;
+    case "bool":
+      return typeof value === "boolean" ? null : "deveria ser booleano";
+    case "int":
+      return Number.isInteger(value) && value >= -0x80000000 && value <= 0x7fffffff ? null : "deveria ser inteiro de 32 bits";
+    case "uint":
+      return Number.isInteger(value) && value >= 0 && value <= 0xffffffff ? null : "deveria ser inteiro sem sinal de 32 bits";
+  }
+  return "tipo desconhecido";
+}
+
+function check(msg) {
+  if (!msg || typeof msg !== "object") return ["não é objeto"];
+  const spec = MESSAGES[msg.type];
+  if (!spec) return null;
+
+  const problems = [];
+  const known = new Set(["type"]);
+  if (spec.direction === "car") {
+    known.add("carId");
+    if (typeof msg.carId !== "string") problems.push("carId ausente");
+  }
+  for (const field of spec.fields) {
+    known.add(field.name);
+    if (msg[field.name] === undefined) {
+      if (!field.optional) problems.push(`${field.name} ausente`);
+      continue;
+    }
+    const problem = checkValue(field, msg[field.name]);
+    if (problem) problems.push(`${field.name} ${problem}`);
+  }
+  for (const key of Object.keys(msg)) {
+    if (!known.has(key)) problems.push(`${key} fora do esquema`);
+  }
+  return problems;
+}
+
+function decode(msg) {
+  const problems = check(msg);
+  if (problems === null) throw new Error(`tipo fora do esquema: ${msg && msg.type}`);
+  if (problems.length) throw new Error(`${msg.type}: ${problems.join(", ")}`);
+  return msg;
+}
+
+// Monta a mensagem na ordem do esquema (mesma ordem do firmware)
+function make(type, fields = {}, carId) {
+  const spec = MESSAGES[type];
+  if (!spec) throw new Error(`tipo fora do esquema: ${type}`);
+  const msg = { type };
+  if (spec.direction === "car") msg.carId = carId;
+  for (const field of spec.fields) {
+    if (fields[field.name] !== undefined) msg[field.name] = fields[field.name];
+  }
+  for (const key of Object.keys(fields)) {
+    if (!(key in msg)) msg[key] = fields[key];
+  }
+  return decode(msg);
+}
+
+@BUILDERS@
+
+function benchmark(iterations = 10000) {
+  const msgpack = require("./msgpack-codec");
+  const assert = require("assert");
+  const carId = "CAR-BENCH";
+
+  console.log(`Codecs do protocolo (esquema v${SCHEMA_VERSION}, ${iterations} iterações)`);
+  for (const type of Object.keys(MESSAGES)) {
+    const sample = make(type, EXAMPLES[type], carId);
+    const codecs = [
+      ["json", (m) => Buffer.from(JSON.stringify(m)), (b) => JSON.parse(b.toString())],
+      ["msgpack", (m) => msgpack.encode(m), (b) => msgpack.decode(b)],
+    ];
+    for (const [name, enc, dec] of codecs) {
+      let frame;
+      const t0 = process.hrtime.bigint();
+      for (let i = 0; i < iterations; i++) frame = enc(make(type, EXAMPLES[type], carId));
+      const t1 = process.hrtime.bigint();
+      let back;
+      for (let i = 0; i < iterations; i++) back = decode(dec(frame));
+      const t2 = process.hrtime.bigint();
+      assert.deepStrictEqual(back, sample, `${type}/${name}: ida e volta divergiu`);
+      const ns = (t) => (Number(t) / iterations).toFixed(0).padStart(6);
+      console.log(`${type.padEnd(18)} ${name.padEnd(7)} ${String(frame.length).padStart(3)} B  enc ${ns(t1 - t0)} ns  dec ${ns(t2 - t1)} ns  ok`);
+    }
+  }
+}
+
+module.exports = { SCHEMA_VERSION, MESSAGES, check, decode, make, benchmark, @EXPORTS@ };
+
+if (require.main === module) {
+  if (process.argv[2] !== "bench") {
+    console.log("uso: node protocol-codec.js bench [iterações]");
+    process.exit(1);
+  }
+  benchmark(parseInt(process.argv[3] || "10000", 10));
+}
+"""
+
+
+# ===== SAÍDA =====
+
+def write_if_changed(root, path, content):
+    full = os.path.join(root, path)
+    try:
+        with open(full, encoding="utf-8") as f:
+            if f.read() == content:
+                return False
+    except FileNotFoundError:
+        pass
+    os.makedirs(os.path.dirname(full) or ".", exist_ok=True)
+    with open(full, "w", encoding="utf-8", newline="\n") as f:
+        f.write(content)
+    print("[gen_protocol] %s atualizado" % path)
+    return True
+
+
+def generate(root):
+    version, messages = load_schema(root)
+    write_if_changed(root, OUT_H, gen_header(version, messages))
+    write_if_changed(root, OUT_CPP, gen_source(messages))
+    write_if_changed(root, OUT_JS, gen_js(version, messages))
+
+
+generate(ROOT)